@@ -36,6 +36,7 @@
 #include "dw3000_nfcc_coex.h"
 #include "dw3000_pctt.h"
 #include "dw3000_debugfs.h"
+#include "dw3000_cir_stream.h"
 
 #undef BIT_MASK
 #ifndef DEBUG
@@ -68,6 +69,7 @@ struct dw3000_isr_data {
 	u64 ts_rctu; /* frame timestamp in RCTU unit */
 	u8 dss_stat; /* value of the dual-SPI semaphore events */
 	u8 rx_flags; /* RX frame flags, see dw3000_rx_flags */
+	u16 finfo16; /* RX frame info read by RX fast path */
 };
 
 /* Time units and conversion factor */
@@ -265,6 +267,19 @@ enum dw3000_rx_flags {
 	DW3000_RX_FLAG_CPER = BIT(6)
 };
 
+/* Number of preallocated socket buffers for received frames */
+#define DW3000_RX_SKB_POOL_SIZE 8
+
+/* Pool of preallocated socket buffers for received frames */
+struct dw3000_rx_skb_pool {
+	/* Available socket buffers, protected by their own lock */
+	struct sk_buff_head skbs;
+	/* Work refilling the pool out of the event thread */
+	struct work_struct refill_work;
+	/* Number of frames received while the pool was empty */
+	atomic64_t exhausted;
+};
+
 /* Receive descriptor */
 struct dw3000_rx {
 	/* Receive lock */
@@ -277,6 +292,8 @@ struct dw3000_rx {
 	u8 flags;
 	/* Busy flag */
 	u8 busy;
+	/* Preallocated socket buffers */
+	struct dw3000_rx_skb_pool pool;
 };
 
 /* DW3000 STS length field of the CP_CFG register (unit of 8 symbols bloc) */
@@ -438,6 +455,9 @@ enum config_changed_flags {
 	DW3000_DATA_RATE_CHANGED = BIT(9),
 };
 
+/* Number of wake-up durations used to learn wake-up latency */
+#define DW3000_WAKEUP_SAMPLES 32
+
 /**
  * struct dw3000_power - DW3000 device power related data
  * @stats: accumulated statistics defined by struct sysfs_power_stats
@@ -446,6 +466,16 @@ enum config_changed_flags {
  * @tx_adjust: TX time adjustment based on frame length
  * @rx_start: RX start date in DTU for RX time adjustment
  * @interrupts: Hardware interrupts count on the device.
+ * @wakeup_start: timestamp of current wake-up start, or zero
+ * @wakeup: wake-up count and accumulated wake-up to ready duration in ns
+ * @wakeup_max: longest wake-up to ready duration in ns
+ * @wakeup_samples_us: last wake-up to ready durations in us
+ * @wakeup_sample_idx: next entry to replace in @wakeup_samples_us
+ * @wakeup_sample_count: number of valid entries in @wakeup_samples_us
+ * @wakeup_latency_us: learned wake-up latency, or zero if not yet known
+ * @sleep_missed: deep sleep not entered before a TX/RX while the measured
+ *  wake-up latency allowed it
+ * @wakeup_late: wake-up done too late for the next TX/RX
  */
 struct dw3000_power {
 	struct sysfs_power_stats stats[DW3000_PWR_MAX];
@@ -454,6 +484,59 @@ struct dw3000_power {
 	int tx_adjust;
 	u32 rx_start;
 	atomic64_t interrupts;
+	u64 wakeup_start;
+	struct sysfs_power_stats wakeup;
+	u64 wakeup_max;
+	u32 wakeup_samples_us[DW3000_WAKEUP_SAMPLES];
+	int wakeup_sample_idx;
+	int wakeup_sample_count;
+	int wakeup_latency_us;
+	u64 sleep_missed;
+	u64 wakeup_late;
+};
+
+/**
+ * enum dw3000_lat_stage - Measured stages of the IRQ and TX pipeline
+ * @DW3000_LAT_IRQ_TO_THREAD: hard IRQ to event thread wake-up
+ * @DW3000_LAT_THREAD_TO_STATUS: event thread wake-up to status read done
+ * @DW3000_LAT_STATUS_TO_MCPS: status read done to MCPS RX frame callback
+ * @DW3000_LAT_TX_TO_TXFRS: immediate TX fast command to TXFRS event read
+ * @DW3000_LAT_MAX: number of measured stages
+ */
+enum dw3000_lat_stage {
+	DW3000_LAT_IRQ_TO_THREAD,
+	DW3000_LAT_THREAD_TO_STATUS,
+	DW3000_LAT_STATUS_TO_MCPS,
+	DW3000_LAT_TX_TO_TXFRS,
+	DW3000_LAT_MAX,
+};
+
+/* Number of log2 buckets in latency histograms, bucket N counts latencies
+   from 2^N to 2^(N+1)-1 ns, last one counts all longer latencies */
+#define DW3000_LAT_BUCKETS 32
+
+/**
+ * struct dw3000_lat_hist - Latency histograms of one CPU
+ * @count: number of measures in each log2 bucket, for each stage
+ */
+struct dw3000_lat_hist {
+	u64 count[DW3000_LAT_MAX][DW3000_LAT_BUCKETS];
+};
+
+/**
+ * struct dw3000_lat_stats - DW3000 pipeline latency statistics
+ * @hist: per-CPU latency histograms
+ * @irq_ns: date of last hard IRQ, zero if already handled
+ * @thread_ns: date of event thread wake-up for current IRQ
+ * @status_ns: date of status read done for current IRQ
+ * @tx_ns: date of last immediate TX fast command, zero if none pending
+ */
+struct dw3000_lat_stats {
+	struct dw3000_lat_hist __percpu *hist;
+	atomic64_t irq_ns;
+	u64 thread_ns;
+	u64 status_ns;
+	u64 tx_ns;
 };
 
 /**
@@ -506,6 +589,197 @@ struct dw3000_cir_data;
 
 #define DW3000_MAX_QUEUED_SPI_XFER 32
 #define DW3000_QUEUED_SPI_BUFFER_SZ 2048
+/* Number of SPI messages queues which can be in-flight at the same time */
+#define DW3000_SPI_QUEUE_SLOTS 4
+
+/**
+ * typedef dw3000_spi_async_cb - Asynchronous SPI queue completion callback
+ * @dw: the DW device on which the SPI transfers occurred
+ * @arg: argument given to dw3000_spi_queue_flush_async()
+ * @status: zero on success, else a negative error code
+ *
+ * Called from the SPI controller completion context, which may be atomic.
+ * It must not sleep.
+ */
+typedef void (*dw3000_spi_async_cb)(struct dw3000 *dw, void *arg, int status);
+
+/**
+ * struct dw3000_spi_queue_rx - Queued RX transfer data to scatter
+ * @dest: caller buffer where to copy received data after flush
+ * @src: location of received data in queue buffer
+ * @len: length of received data
+ */
+struct dw3000_spi_queue_rx {
+	void *dest;
+	const void *src;
+	unsigned len;
+};
+
+/**
+ * struct dw3000_spi_queue_slot - SPI messages queue storage
+ * @dw: backpointer to DW3000 device, used by completion handler
+ * @msg: SPI message holding queued transfers
+ * @buf: buffer for queued transfers data
+ * @busy: non-zero while the message is submitted and not yet completed
+ * @cb: completion callback of the asynchronous flush, or NULL
+ * @arg: argument given to @cb
+ * @rx: queued RX transfers to scatter into caller buffers after flush
+ * @rx_count: number of valid entries in @rx
+ */
+struct dw3000_spi_queue_slot {
+	struct dw3000 *dw;
+	struct spi_message *msg;
+	char *buf;
+	atomic_t busy;
+	dw3000_spi_async_cb cb;
+	void *arg;
+	struct dw3000_spi_queue_rx rx[DW3000_MAX_QUEUED_SPI_XFER];
+	unsigned rx_count;
+};
+
+/**
+ * struct dw3000_spi_async - Asynchronous SPI transfers engine
+ * @slots: SPI messages queues, used in a round robin way
+ * @slot_idx: index of the slot used by the current messages queue
+ * @inflight: number of submitted messages not yet completed
+ * @status: first error reported by a completed message, or zero
+ * @wq: wait queue woken up on each message completion
+ */
+struct dw3000_spi_async {
+	struct dw3000_spi_queue_slot slots[DW3000_SPI_QUEUE_SLOTS];
+	int slot_idx;
+	atomic_t inflight;
+	atomic_t status;
+	wait_queue_head_t wq;
+};
+
+/* Maximum number of transfers and data size of a saved SPI program */
+#define DW3000_SPI_PROGRAM_MAX_XFER 24
+#define DW3000_SPI_PROGRAM_BUFFER_SZ 256
+
+/**
+ * struct dw3000_spi_program_xfer - Saved SPI transfer
+ * @offset: offset of the TX data in the program buffer
+ * @len: length of the transfer
+ * @cs_change: true to deselect the chip after this transfer
+ */
+struct dw3000_spi_program_xfer {
+	u16 offset;
+	u16 len;
+	bool cs_change;
+};
+
+/**
+ * struct dw3000_spi_program - Write-only transfers saved from a queue
+ * @xfers: saved transfers
+ * @buf: TX data of all saved transfers
+ * @n_xfers: number of valid entries in @xfers
+ * @buf_len: used size of @buf
+ * @valid: true if the program can be replayed
+ *
+ * A program is recorded once from a messages queue, then copied again in
+ * later queues without calling the functions which built it.
+ */
+struct dw3000_spi_program {
+	struct dw3000_spi_program_xfer xfers[DW3000_SPI_PROGRAM_MAX_XFER];
+	char buf[DW3000_SPI_PROGRAM_BUFFER_SZ];
+	int n_xfers;
+	int buf_len;
+	bool valid;
+};
+
+/**
+ * struct dw3000_wakeup_restore - Registers restore program used on wake-up
+ * @prog: saved SPI program
+ * @chan: channel for which @prog was built
+ * @rx_code: RX preamble code for which @prog was built
+ * @coex_gpio: WiFi coexistence GPIO for which @prog was built
+ * @ant_gpios: bitmap of antenna selection GPIOs for which @prog was built
+ */
+struct dw3000_wakeup_restore {
+	struct dw3000_spi_program prog;
+	u8 chan;
+	u8 rx_code;
+	s8 coex_gpio;
+	u16 ant_gpios;
+};
+
+/* Maximum number of registers in the shadow registers cache */
+#define DW3000_REG_CACHE_SIZE 12
+
+/**
+ * struct dw3000_reg_cache_entry - Shadow copy of a 32 bits register
+ * @fileid: register fileID, access address is fileID plus offset
+ * @value: register bytes as last written to or read from the chip
+ */
+struct dw3000_reg_cache_entry {
+	u32 fileid;
+	u8 value[4];
+};
+
+/**
+ * struct dw3000_reg_cache - Shadow cache of non-volatile registers
+ * @entries: cached registers, only written by the driver
+ * @count: number of valid entries in @entries, zero until chip version known
+ * @valid: bitmap of entries holding the current register value
+ * @hits: number of register reads answered by the cache
+ * @misses: number of cached register reads done on the chip
+ * @elided: number of register writes skipped as register already held value
+ * @writes: number of cached register writes done on the chip
+ *
+ * Protected by the msg_mutex, like the register access SPI message.
+ */
+struct dw3000_reg_cache {
+	struct dw3000_reg_cache_entry entries[DW3000_REG_CACHE_SIZE];
+	int count;
+	unsigned long valid;
+	u64 hits;
+	u64 misses;
+	u64 elided;
+	u64 writes;
+};
+
+/* Number of smart TX power adjustments remembered. */
+#define DW3000_TXPOWER_MEMO_SIZE 8
+
+/**
+ * struct dw3000_txpower_memo_entry - Remembered smart TX power adjustment
+ * @ref_tx_power: reference TX power, for a 1 ms frame
+ * @adjusted_tx_power: adjusted TX power register value
+ * @frame_duration_us: frame duration in us
+ * @th_boost: theoretical boost, for traces
+ * @app_boost: applied boost, for traces
+ * @chan: channel
+ */
+struct dw3000_txpower_memo_entry {
+	u32 ref_tx_power;
+	u32 adjusted_tx_power;
+	u16 frame_duration_us;
+	u16 th_boost;
+	u16 app_boost;
+	u8 chan;
+};
+
+/**
+ * struct dw3000_txpower_memo - Memo of smart TX power adjustments
+ * @entries: remembered adjustments
+ * @valid: bitmap of valid entries in @entries
+ * @next: next entry to replace
+ * @hits: number of adjustments found in @entries
+ * @misses: number of adjustments computed
+ *
+ * Frames of a session have a few different durations only, so the result of
+ * the adjustment search is kept for each channel, reference power and frame
+ * duration. Only used from the STM thread, invalidated when calibration
+ * changes.
+ */
+struct dw3000_txpower_memo {
+	struct dw3000_txpower_memo_entry entries[DW3000_TXPOWER_MEMO_SIZE];
+	unsigned long valid;
+	int next;
+	u64 hits;
+	u64 misses;
+};
 
 /* Number of samples to average. */
 #define DW3000_NB_AVERAGE 1
@@ -551,7 +825,9 @@ struct dw3000_rx_ctx {
  * @timer_expired_work: call mcps802154_timer_expired outside driver kthread.
  * @wakeup_done_cb: callback called on wakeup done.
  * @idle_timeout_cb: callback when idle timer expired
- * @auto_sleep_margin_us: configurable automatic deep sleep margin
+ * @auto_sleep_margin_us: configurable automatic deep sleep margin, -1 to
+ *			  disable deep sleep, 0 to only use the learned wake-up
+ *			  latency, see dw3000_wakeup_latency_us()
  * @need_ranging_clock: true if next operation need ranging clock
  *			and deep sleep cannot be used
  * @nfcc_coex: NFCC coexistence specific context
@@ -588,11 +864,21 @@ struct dw3000_rx_ctx {
  * @cir_data_changed: true if buffer data have been reallocated
  * @full_cia_read: CIA registers fully loaded into cir_data struct
  * @cir_data: allocated CIR exploitation data
+ * @cir_stream: CIR streaming character device
  * @msg_queue: SPI message holding transfer queue
  * @msg_queue_xfer: next transfer available
  * @msg_queue_xfer_count: number of queued transfers
  * @msg_queue_buf: buffer for queued transfers
  * @msg_queue_buf_pos: current position in buffer
+ * @spi_async: asynchronous SPI transfers engine, owning messages queues
+ * @lat: IRQ and TX pipeline latency statistics
+ * @config_pending: configuration changes not yet applied by the STM thread
+ * @config_error: last asynchronous configuration apply error, not yet returned
+ * @reg_cache: shadow cache of non-volatile registers
+ * @txpower_memo: memo of smart TX power adjustments
+ * @wakeup_restore: registers restore program replayed after DEEP SLEEP
+ * @tx_prepared_frame_idx: index of the frame already written in the TX
+ *  buffer, or -1
  * @msg_mutex: mutex protecting @msg_readwrite_fdx
  * @msg_readwrite_fdx: pre-computed generic register read/write SPI message
  * @msg_fast_command: pre-computed fast command SPI message
@@ -602,6 +888,7 @@ struct dw3000_rx_ctx {
  * @msg_read_rx_timestamp: pre-computed SPI message
  * @msg_read_rx_timestamp_a: pre-computed SPI message
  * @msg_read_rx_timestamp_b: pre-computed SPI message
+ * @msg_read_rx_fastpath: pre-computed ISR RX fast path SPI message
  * @msg_read_sys_status: pre-computed SPI message
  * @msg_read_all_sys_status: pre-computed SPI message
  * @msg_read_sys_time: pre-computed SPI message
@@ -707,6 +994,8 @@ struct dw3000 {
 	bool cir_data_changed;
 	bool full_cia_read;
 	struct dw3000_cir_data *cir_data;
+	/* CIR streaming ring */
+	struct dw3000_cir_stream cir_stream;
 	/* SPI message holding transfers queue */
 	struct spi_message *msg_queue;
 	struct spi_transfer *msg_queue_xfer;
@@ -714,6 +1003,22 @@ struct dw3000 {
 	/* Buffer for queued transfers */
 	char *msg_queue_buf;
 	char *msg_queue_buf_pos;
+	/* Asynchronous SPI transfers engine */
+	struct dw3000_spi_async spi_async;
+	/* Pipeline latency statistics */
+	struct dw3000_lat_stats lat;
+	/* Configuration changes waiting for asynchronous apply */
+	atomic_long_t config_pending;
+	/* Asynchronous configuration apply error for next caller */
+	atomic_t config_error;
+	/* Shadow registers cache */
+	struct dw3000_reg_cache reg_cache;
+	/* Smart TX power adjustments memo */
+	struct dw3000_txpower_memo txpower_memo;
+	/* Registers restored after DEEP SLEEP */
+	struct dw3000_wakeup_restore wakeup_restore;
+	/* Frame preloaded in the TX buffer */
+	int tx_prepared_frame_idx;
 	/* dw3000 thread clamp value  */
 	int min_clamp_value;
 	/* Insert new fields before this line */
@@ -727,6 +1032,7 @@ struct dw3000 {
 	struct spi_message *msg_read_rx_timestamp;
 	struct spi_message *msg_read_rx_timestamp_a;
 	struct spi_message *msg_read_rx_timestamp_b;
+	struct spi_message *msg_read_rx_fastpath;
 	struct spi_message *msg_read_sys_status;
 	struct spi_message *msg_read_all_sys_status;
 	struct spi_message *msg_read_sys_time;
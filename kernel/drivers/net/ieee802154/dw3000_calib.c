@@ -20,7 +20,12 @@
  * software for any purpose without first obtaining a commercial license from
  * Qorvo. Please contact Qorvo to inquire about licensing terms.
  */
+#include <linux/bsearch.h>
+#include <linux/once.h>
+#include <linux/sort.h>
+
 #include "dw3000.h"
+#include "dw3000_core.h"
 #include "dw3000_txpower_adjustment.h"
 
 /* clang-format off */
@@ -250,20 +255,46 @@ const dw3000_pdoa_lut_t dw3000_default_lut_ch9 = {
 	/* clang-format on */
 };
 
-int dw3000_calib_parse_key(struct dw3000 *dw, const char *key, void **param)
+/* Indexes in dw3000_calib_keys, sorted by key. */
+static u16 dw3000_calib_keys_index[MAX_CALIB_KEYS];
+static int dw3000_calib_keys_index_len;
+
+static int dw3000_calib_keys_index_cmp(const void *a, const void *b)
+{
+	return strcmp(dw3000_calib_keys[*(const u16 *)a],
+		      dw3000_calib_keys[*(const u16 *)b]);
+}
+
+static void dw3000_calib_keys_index_init(void)
 {
 	int i;
 
-	for (i = 0; dw3000_calib_keys[i]; i++) {
-		const char *k = dw3000_calib_keys[i];
+	for (i = 0; dw3000_calib_keys[i]; i++)
+		dw3000_calib_keys_index[i] = i;
+	sort(dw3000_calib_keys_index, i, sizeof(dw3000_calib_keys_index[0]),
+	     dw3000_calib_keys_index_cmp, NULL);
+	dw3000_calib_keys_index_len = i;
+}
 
-		if (strcmp(k, key) == 0) {
-			/* Key found, calculate parameter address */
-			*param = (void *)dw + dw3000_calib_keys_info[i].offset;
-			return dw3000_calib_keys_info[i].length;
-		}
-	}
-	return -ENOENT;
+static int dw3000_calib_keys_index_search(const void *key, const void *elt)
+{
+	return strcmp(key, dw3000_calib_keys[*(const u16 *)elt]);
+}
+
+int dw3000_calib_parse_key(struct dw3000 *dw, const char *key, void **param)
+{
+	const u16 *index;
+
+	DO_ONCE(dw3000_calib_keys_index_init);
+	index = bsearch(key, dw3000_calib_keys_index,
+			dw3000_calib_keys_index_len,
+			sizeof(dw3000_calib_keys_index[0]),
+			dw3000_calib_keys_index_search);
+	if (!index)
+		return -ENOENT;
+	/* Key found, calculate parameter address */
+	*param = (void *)dw + dw3000_calib_keys_info[*index].offset;
+	return dw3000_calib_keys_info[*index].length;
 }
 
 /**
@@ -300,6 +331,11 @@ int dw3000_calib_update_config(struct dw3000 *dw)
 	int ant_rf1, ant_rf2, antpair;
 	int chanidx, prfidx;
 
+	/* Calibration may change, adjusted TX powers must be computed again. */
+	dw3000_txpower_memo_invalidate(dw);
+	/* Same for antenna GPIO restored on wake-up. */
+	dw3000_wakeup_restore_invalidate(dw);
+
 	dw->llhw->hw->phy->supported.channels[4] = DW3000_SUPPORTED_CHANNELS &
 						   ~dw->restricted_channels;
 	/* Change channel if the current one is restricted. */
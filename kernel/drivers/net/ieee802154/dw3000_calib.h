@@ -211,8 +211,9 @@ struct dw3000;
  * @key: pointer to NUL terminated string to retrieve param address and len
  * @param: pointer where to store the corresponding parameter address
  *
- * This function lookup the NULL terminated table @dw3000_calib_keys and
- * if specified key is found, store the corresponding address in @param and
+ * This function lookup the table @dw3000_calib_keys, using an index sorted
+ * by key built on first call, and if specified key is found, store the
+ * corresponding address in @param and return its length.
  *
  * Return: length of corresponding parameter if found, else a -ENOENT error.
  */
@@ -24,6 +24,7 @@
 #define __DW3000_CIR_H
 
 #include <linux/completion.h>
+#include <linux/version.h>
 
 #include "dw3000_core_reg.h"
 
@@ -80,4 +81,13 @@ struct dw3000_cir_data {
 	struct dw3000_cir_record data[1];
 };
 
+static inline int completion_active(struct completion *completion)
+{
+#if (KERNEL_VERSION(5, 7, 0) > LINUX_VERSION_CODE)
+	return waitqueue_active(&completion->wait);
+#else
+	return swait_active(&completion->wait);
+#endif
+}
+
 #endif
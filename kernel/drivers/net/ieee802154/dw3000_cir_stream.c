@@ -0,0 +1,220 @@
+/*
+ * This file is part of the UWB stack for linux.
+ *
+ * Copyright (c) 2021 Qorvo US, Inc.
+ *
+ * This software is provided under the GNU General Public License, version 2
+ * (GPLv2), as well as under a Qorvo commercial license.
+ *
+ * You may choose to use this software under the terms of the GPLv2 License,
+ * version 2 ("GPLv2"), as published by the Free Software Foundation.
+ * You should have received a copy of the GPLv2 along with this program.  If
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is distributed under the GPLv2 in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GPLv2 for more
+ * details.
+ *
+ * If you cannot meet the requirements of the GPLv2, you may not use this
+ * software for any purpose without first obtaining a commercial license from
+ * Qorvo. Please contact Qorvo to inquire about licensing terms.
+ */
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+
+#include "dw3000.h"
+#include "dw3000_cir.h"
+#include "dw3000_cir_stream.h"
+
+static inline struct dw3000_cir_stream *
+dw3000_cir_stream_from_file(struct file *filp)
+{
+	return container_of(filp->private_data, struct dw3000_cir_stream,
+			    misc);
+}
+
+static inline struct dw3000_cir_stream_record *
+dw3000_cir_stream_record(struct dw3000_cir_stream *stream, u32 n)
+{
+	return (void *)(stream->ring + 1) +
+	       (n % stream->nr_records) * stream->record_size;
+}
+
+static int dw3000_cir_stream_open(struct inode *inode, struct file *filp)
+{
+	struct dw3000_cir_stream *stream = dw3000_cir_stream_from_file(filp);
+	struct dw3000 *dw = container_of(stream, struct dw3000, cir_stream);
+	struct dw3000_cir_stream_ring *ring;
+	unsigned int max_count;
+	size_t record_size;
+	size_t size;
+
+	/* Single consumer only */
+	if (atomic_cmpxchg(&stream->opened, 0, 1))
+		return -EBUSY;
+	/* Size records for the CIR window configured at open time */
+	max_count = dw->cir_data ? dw->cir_data->count :
+				   DW3000_DEFAULT_CIR_RECORD_COUNT;
+	record_size = ALIGN(sizeof(struct dw3000_cir_stream_record) +
+				    max_count * sizeof(struct dw3000_cir_record),
+			    sizeof(u64));
+	size = PAGE_ALIGN(sizeof(*ring) +
+			  record_size * DW3000_CIR_STREAM_RECORDS);
+	ring = vmalloc_user(size);
+	if (!ring) {
+		atomic_set(&stream->opened, 0);
+		return -ENOMEM;
+	}
+	mutex_lock(&stream->mutex);
+	stream->size = size;
+	stream->max_count = max_count;
+	stream->head = 0;
+	stream->nr_records = DW3000_CIR_STREAM_RECORDS;
+	stream->record_size = record_size;
+	WRITE_ONCE(ring->nr_records, stream->nr_records);
+	WRITE_ONCE(ring->record_size, stream->record_size);
+	/* Publish the ring, producer starts to fill it */
+	WRITE_ONCE(stream->ring, ring);
+	mutex_unlock(&stream->mutex);
+	return nonseekable_open(inode, filp);
+}
+
+static int dw3000_cir_stream_release(struct inode *inode, struct file *filp)
+{
+	struct dw3000_cir_stream *stream = dw3000_cir_stream_from_file(filp);
+	struct dw3000_cir_stream_ring *ring;
+
+	mutex_lock(&stream->mutex);
+	ring = stream->ring;
+	WRITE_ONCE(stream->ring, NULL);
+	mutex_unlock(&stream->mutex);
+	/* Existing mappings hold their own reference on the pages */
+	vfree(ring);
+	atomic_set(&stream->opened, 0);
+	return 0;
+}
+
+static int dw3000_cir_stream_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct dw3000_cir_stream *stream = dw3000_cir_stream_from_file(filp);
+	unsigned long len = vma->vm_end - vma->vm_start;
+
+	if (vma->vm_pgoff || len > stream->size)
+		return -EINVAL;
+	return remap_vmalloc_range(vma, stream->ring, 0);
+}
+
+static __poll_t dw3000_cir_stream_poll(struct file *filp,
+				       struct poll_table_struct *wait)
+{
+	struct dw3000_cir_stream *stream = dw3000_cir_stream_from_file(filp);
+	struct dw3000_cir_stream_ring *ring = stream->ring;
+
+	poll_wait(filp, &stream->wq, wait);
+	if (READ_ONCE(stream->head) != READ_ONCE(ring->tail))
+		return EPOLLIN | EPOLLRDNORM;
+	return 0;
+}
+
+static const struct file_operations dw3000_cir_stream_fops = {
+	.owner = THIS_MODULE,
+	.open = dw3000_cir_stream_open,
+	.release = dw3000_cir_stream_release,
+	.mmap = dw3000_cir_stream_mmap,
+	.poll = dw3000_cir_stream_poll,
+	.llseek = no_llseek,
+};
+
+/**
+ * dw3000_cir_stream_push() - Add a CIR record to the streaming ring
+ * @dw: the DW device
+ * @cir: CIR data just read for the received frame
+ * @rx_buffer: RX buffer holding the frame, 0 for A (or single), 1 for B
+ *
+ * Called by the STM thread, the only producer. The record is dropped and
+ * counted if the user didn't consume enough records. Ring geometry and head
+ * are taken from kernel-private copies, the user tail is clamped.
+ */
+void dw3000_cir_stream_push(struct dw3000 *dw,
+			    const struct dw3000_cir_data *cir, u8 rx_buffer)
+{
+	struct dw3000_cir_stream *stream = &dw->cir_stream;
+	struct dw3000_cir_stream_record *rec;
+	struct dw3000_cir_stream_ring *ring;
+	unsigned int count;
+	u32 head, used;
+
+	mutex_lock(&stream->mutex);
+	ring = stream->ring;
+	if (!ring)
+		goto unlock;
+	head = stream->head;
+	/* Pairs with user release of consumed records. A tail ahead of head
+	   or too late is invalid, ring is then seen as full. */
+	used = head - smp_load_acquire(&ring->tail);
+	if (used >= stream->nr_records) {
+		ring->dropped++;
+		goto unlock;
+	}
+	rec = dw3000_cir_stream_record(stream, head);
+	count = min(cir->count, stream->max_count);
+	rec->utime = cir->utime;
+	rec->ts = cir->ts;
+	rec->fp_power1 = cir->fp_power1;
+	rec->fp_power2 = cir->fp_power2;
+	rec->fp_power3 = cir->fp_power3;
+	rec->fp_index = cir->fp_index;
+	rec->acc = cir->acc;
+	rec->count = count;
+	rec->type = cir->type;
+	rec->rx_buffer = rx_buffer;
+	memcpy(rec->ciaregs, cir->ciaregs, sizeof(rec->ciaregs));
+	memcpy(rec->data, cir->data, count * sizeof(struct dw3000_cir_record));
+	ring->written++;
+	WRITE_ONCE(stream->head, head + 1);
+	/* Record must be visible before the new head */
+	smp_store_release(&ring->head, head + 1);
+	wake_up_interruptible(&stream->wq);
+unlock:
+	mutex_unlock(&stream->mutex);
+}
+
+/**
+ * dw3000_cir_stream_init() - Register the CIR streaming character device
+ * @dw: the DW device
+ *
+ * Return: zero on success, else a negative error code.
+ */
+int dw3000_cir_stream_init(struct dw3000 *dw)
+{
+	struct dw3000_cir_stream *stream = &dw->cir_stream;
+	int rc;
+
+	mutex_init(&stream->mutex);
+	init_waitqueue_head(&stream->wq);
+	stream->misc.minor = MISC_DYNAMIC_MINOR;
+	stream->misc.name =
+		devm_kasprintf(dw->dev, GFP_KERNEL, "dw3000_cir-%s",
+			       dev_name(dw->dev));
+	if (!stream->misc.name)
+		return -ENOMEM;
+	stream->misc.fops = &dw3000_cir_stream_fops;
+	stream->misc.parent = dw->dev;
+	rc = misc_register(&stream->misc);
+	if (rc)
+		dev_err(dw->dev, "cannot register CIR stream device: %d\n", rc);
+	return rc;
+}
+
+/**
+ * dw3000_cir_stream_remove() - Unregister the CIR streaming character device
+ * @dw: the DW device
+ */
+void dw3000_cir_stream_remove(struct dw3000 *dw)
+{
+	misc_deregister(&dw->cir_stream.misc);
+}
@@ -0,0 +1,139 @@
+/*
+ * This file is part of the UWB stack for linux.
+ *
+ * Copyright (c) 2021 Qorvo US, Inc.
+ *
+ * This software is provided under the GNU General Public License, version 2
+ * (GPLv2), as well as under a Qorvo commercial license.
+ *
+ * You may choose to use this software under the terms of the GPLv2 License,
+ * version 2 ("GPLv2"), as published by the Free Software Foundation.
+ * You should have received a copy of the GPLv2 along with this program.  If
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is distributed under the GPLv2 in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GPLv2 for more
+ * details.
+ *
+ * If you cannot meet the requirements of the GPLv2, you may not use this
+ * software for any purpose without first obtaining a commercial license from
+ * Qorvo. Please contact Qorvo to inquire about licensing terms.
+ */
+#ifndef __DW3000_CIR_STREAM_H
+#define __DW3000_CIR_STREAM_H
+
+#include <linux/types.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+
+#include "dw3000_core_reg.h"
+
+/* Number of records in the CIR streaming ring */
+#define DW3000_CIR_STREAM_RECORDS 256
+
+/**
+ * struct dw3000_cir_stream_ring - CIR streaming ring header, shared with user
+ * @head: count of written records, mirror of the driver value
+ * @tail: count of consumed records, only updated by the user
+ * @nr_records: number of record slots following the header, mirror of the
+ *              driver value
+ * @record_size: size in bytes of each record slot, mirror of the driver value
+ * @dropped: records dropped because the ring was full
+ * @written: records written since the device was opened
+ *
+ * The ring is mapped in user space with mmap(). Record n is located at
+ * offset sizeof(header) + (n % @nr_records) * @record_size. The driver
+ * publishes a record by incrementing @head after the record is written, the
+ * user releases it by incrementing @tail once consumed. No lock is shared,
+ * poll() reports the device readable when @head differs from @tail.
+ *
+ * The header is writable by the user, so the driver never reads back @head,
+ * @nr_records nor @record_size, and clamps @tail.
+ */
+struct dw3000_cir_stream_ring {
+	__u32 head;
+	__u32 tail;
+	__u32 nr_records;
+	__u32 record_size;
+	__u64 dropped;
+	__u64 written;
+};
+
+/**
+ * struct dw3000_cir_stream_record - CIR streaming ring record
+ * @utime: RX timestamp of the frame
+ * @ts: boot time in ns of the CIR read
+ * @fp_power1: first path power component f1
+ * @fp_power2: first path power component f2
+ * @fp_power3: first path power component f3
+ * @fp_index: index of first path record in CIR register
+ * @acc: number of symbols accumulated in CIR
+ * @count: number of CIR records in @data
+ * @type: CIR type field
+ * @rx_buffer: RX buffer of the frame, 0 for A (or single), 1 for B
+ * @ciaregs: all CIA registers of the frame
+ * @data: CIR window, @count complex records of 6 bytes
+ */
+struct dw3000_cir_stream_record {
+	__u64 utime;
+	__u64 ts;
+	__u32 fp_power1;
+	__u32 fp_power2;
+	__u32 fp_power3;
+	__u16 fp_index;
+	__u16 acc;
+	__u16 count;
+	__u8 type;
+	__u8 rx_buffer;
+	__le32 ciaregs[DW3000_DB_DIAG_SET_LEN >> 2];
+	__u8 data[];
+};
+
+/**
+ * struct dw3000_cir_stream - CIR streaming character device
+ * @misc: misc character device
+ * @mutex: protect @ring against release while a record is written
+ * @wq: wait queue of poll()
+ * @ring: shared ring, allocated while the device is opened
+ * @size: allocated size of @ring
+ * @max_count: maximum number of CIR records in each ring record
+ * @head: count of written records, published in @ring
+ * @nr_records: number of record slots in @ring
+ * @record_size: size in bytes of each record slot in @ring
+ * @opened: non-zero while the device is opened
+ */
+struct dw3000_cir_stream {
+	struct miscdevice misc;
+	struct mutex mutex;
+	wait_queue_head_t wq;
+	struct dw3000_cir_stream_ring *ring;
+	size_t size;
+	unsigned int max_count;
+	u32 head;
+	u32 nr_records;
+	u32 record_size;
+	atomic_t opened;
+};
+
+struct dw3000;
+struct dw3000_cir_data;
+
+int dw3000_cir_stream_init(struct dw3000 *dw);
+void dw3000_cir_stream_remove(struct dw3000 *dw);
+void dw3000_cir_stream_push(struct dw3000 *dw,
+			    const struct dw3000_cir_data *cir, u8 rx_buffer);
+
+/**
+ * dw3000_cir_stream_active() - Check if a CIR stream consumer exists
+ * @stream: the CIR streaming device
+ *
+ * Return: true if CIR must be read for each received frame.
+ */
+static inline bool dw3000_cir_stream_active(struct dw3000_cir_stream *stream)
+{
+	return READ_ONCE(stream->ring) != NULL;
+}
+
+#endif /* __DW3000_CIR_STREAM_H */
@@ -27,12 +27,14 @@
 #include <linux/interrupt.h>
 #include <linux/bitfield.h>
 #include <linux/log2.h>
+#include <linux/math64.h>
 
 #include "dw3000.h"
 #include "dw3000_core.h"
 #define DEFINE_COMPAT_REGISTERS
 #include "dw3000_core_reg.h"
 #include "dw3000_cir.h"
+#include "dw3000_cir_stream.h"
 #include "dw3000_stm.h"
 #include "dw3000_trc.h"
 #include "dw3000_perf.h"
@@ -41,6 +43,7 @@
 #include "dw3000_nfcc_coex_core.h"
 #include "dw3000_txpower_adjustment.h"
 #include "dw3000_power_stats.h"
+#include "dw3000_lat_stats.h"
 
 /* Table of supported chip version and associated chip operations */
 const struct dw3000_chip_version dw3000_chip_versions[] = {
@@ -174,6 +177,8 @@ const struct dw3000_chip_version dw3000_chip_versions[] = {
 
 #define DW3000_RX_BUFFER_MAX_LEN (1023)
 #define DW3000_TX_BUFFER_MAX_LEN (1024)
+/* Maximum number of data transfers for a fragmented TX frame */
+#define DW3000_TX_MAX_FRAGS 4
 #define DW3000_REG_DIRECT_OFFSET_MAX_LEN (127)
 
 #define DW3000_CONFIG \
@@ -216,9 +221,6 @@ const struct dw3000_chip_version dw3000_chip_versions[] = {
 #define DW3000_FORCE_CLK_SYS_TX (1)
 #define DW3000_FORCE_CLK_AUTO (5)
 
-#define DW3000_STD_FRAME_LEN (127)
-#define DW3000_EXT_FRAME_LEN (1023)
-
 /* CIA lower bound threshold values for 64 MHz PRF */
 #define DW3000_CIA_MANUALLOWERBOUND_TH_64 (0x10)
 
@@ -562,8 +564,9 @@ static inline void dw3000_free_xfer(struct spi_message *msg, unsigned int len)
 }
 
 /**
- * dw3000_prepare_xfer() - Initialise an spi_message allocated by @dw3000_alloc_xfer
- * @msg: the SPI message to initialise
+ * dw3000_prepare_transfer() - Initialise an spi_transfer for register access
+ * @tr: the SPI transfer holding the header, followed by data transfer if
+ *      @buffer is provided
  * @reg_fileid: the register fileID to read/write
  * @index: the index where to read/write
  * @length: the length of provided buffer and SPI data transfer
@@ -572,12 +575,11 @@ static inline void dw3000_free_xfer(struct spi_message *msg, unsigned int len)
  *
  * Return: zero on success, else a negative error code.
  */
-static inline int dw3000_prepare_xfer(struct spi_message *msg, u32 reg_fileid,
-				      u16 index, u16 length, void *buffer,
-				      enum spi_modes mode)
+static inline int dw3000_prepare_transfer(struct spi_transfer *tr,
+					  u32 reg_fileid, u16 index,
+					  u16 length, void *buffer,
+					  enum spi_modes mode)
 {
-	struct spi_transfer *tr = list_first_entry(
-		&msg->transfers, struct spi_transfer, transfer_list);
 	u8 *header_buf = (u8 *)tr->tx_buf;
 	u16 header_len;
 
@@ -632,6 +634,28 @@ static inline int dw3000_prepare_xfer(struct spi_message *msg, u32 reg_fileid,
 	return 0;
 }
 
+/**
+ * dw3000_prepare_xfer() - Initialise an spi_message allocated by @dw3000_alloc_xfer
+ * @msg: the SPI message to initialise
+ * @reg_fileid: the register fileID to read/write
+ * @index: the index where to read/write
+ * @length: the length of provided buffer and SPI data transfer
+ * @buffer: the address where to read/write data
+ * @mode: operation mode, ie. RW, WR, AND_OR8, etc.
+ *
+ * Return: zero on success, else a negative error code.
+ */
+static inline int dw3000_prepare_xfer(struct spi_message *msg, u32 reg_fileid,
+				      u16 index, u16 length, void *buffer,
+				      enum spi_modes mode)
+{
+	struct spi_transfer *tr = list_first_entry(
+		&msg->transfers, struct spi_transfer, transfer_list);
+
+	return dw3000_prepare_transfer(tr, reg_fileid, index, length, buffer,
+				       mode);
+}
+
 /**
  * dw3000_alloc_prepare_xfer() - Allocate and prepare an spi_message
  * @dw: the DW device on which the SPI transfer will occurs
@@ -707,6 +731,86 @@ static void dw3000_free_fastcmd(struct spi_message *msg)
 	dw3000_free_xfer(msg, 1);
 }
 
+/* Number of registers read by the ISR RX fast path message */
+#define DW3000_RX_FASTPATH_XFER 3
+/* Length of TX and RX buffers of each RX fast path transfer */
+#define DW3000_RX_FASTPATH_BUF_LEN 16
+
+/**
+ * dw3000_alloc_prepare_rx_fastpath() - Allocate and prepare ISR RX fast path
+ * @dw: the DW device on which the SPI transfer will occurs
+ *
+ * The prepared spi_message reads SYS_STATUS, RX_FINFO and RX_TIME registers
+ * using one full-duplex transfer per register, with a CS toggle between each.
+ * All header and data buffers are allocated at once.
+ *
+ * Return: the spi_message struct or NULL if error.
+ */
+static struct spi_message *dw3000_alloc_prepare_rx_fastpath(struct dw3000 *dw)
+{
+	const struct {
+		u32 reg_fileid;
+		u16 len;
+	} regs[DW3000_RX_FASTPATH_XFER] = {
+		{ DW3000_SYS_STATUS_ID, sizeof(u64) },
+		{ DW3000_RX_FINFO_ID, sizeof(u16) },
+		{ DW3000_RX_TIME_0_ID, DW3000_RX_TIME_RX_STAMP_LEN },
+	};
+	struct spi_message *msg;
+	struct spi_transfer *tr;
+	u8 *buf;
+	int i = 0;
+
+	msg = dw3000_alloc_xfer(DW3000_RX_FASTPATH_XFER, 0);
+	if (!msg)
+		goto err_alloc;
+	buf = kzalloc(2 * DW3000_RX_FASTPATH_XFER * DW3000_RX_FASTPATH_BUF_LEN,
+		      GFP_KERNEL | GFP_DMA);
+	if (!buf)
+		goto err_buf;
+	list_for_each_entry (tr, &msg->transfers, transfer_list) {
+		tr->tx_buf = buf + i * DW3000_RX_FASTPATH_BUF_LEN;
+		tr->rx_buf = buf + (DW3000_RX_FASTPATH_XFER + i) *
+					   DW3000_RX_FASTPATH_BUF_LEN;
+		tr->len = DW3000_RX_FASTPATH_BUF_LEN;
+		dw3000_prepare_transfer(tr, regs[i].reg_fileid, 0, regs[i].len,
+					NULL, DW3000_SPI_RD_BIT);
+		/* Toggle CS between registers, without delay */
+		if (!list_is_last(&tr->transfer_list, &msg->transfers)) {
+			tr->cs_change = true;
+#if (KERNEL_VERSION(5, 5, 0) <= LINUX_VERSION_CODE)
+			tr->cs_change_delay.unit = SPI_DELAY_UNIT_NSECS;
+			tr->cs_change_delay.value = 0;
+#endif
+		}
+		i++;
+	}
+	return msg;
+
+err_buf:
+	spi_message_free(msg);
+err_alloc:
+	dev_err(dw->dev, "Failure to allocate RX fast path message\n");
+	return NULL;
+}
+
+/**
+ * dw3000_free_rx_fastpath() - Free ISR RX fast path spi_message
+ * @msg: the SPI message to free
+ */
+static void dw3000_free_rx_fastpath(struct spi_message *msg)
+{
+	struct spi_transfer *tr;
+
+	if (!msg)
+		return;
+	/* All buffers are in the first transfer TX buffer allocation */
+	tr = list_first_entry(&msg->transfers, struct spi_transfer,
+			      transfer_list);
+	kfree(tr->tx_buf);
+	spi_message_free(msg);
+}
+
 static inline int dw3000_spi_sync(struct dw3000 *dw, struct spi_message *msg);
 
 /**
@@ -714,13 +818,23 @@ static inline int dw3000_spi_sync(struct dw3000 *dw, struct spi_message *msg);
  * @dw: the DW device on which the SPI transfer will occurs
  *
  * Reset and initialise SPI messages queue to record next transfers until
- * dw3000_spi_queue_flush() is called.
+ * dw3000_spi_queue_flush() or dw3000_spi_queue_flush_async() is called.
+ *
+ * The queue is taken from the next free slot of the asynchronous engine, so
+ * this may sleep until a previously submitted queue using it is completed.
  */
 void dw3000_spi_queue_start(struct dw3000 *dw)
 {
 #ifdef CONFIG_DW3000_SPI_OPTIMIZATION
-	struct spi_message *msg = dw->msg_queue;
-
+	struct dw3000_spi_async *async = &dw->spi_async;
+	struct dw3000_spi_queue_slot *slot = &async->slots[async->slot_idx];
+	struct spi_message *msg = slot->msg;
+
+	/* Slot may still be used by a previous asynchronous flush */
+	wait_event(async->wq, !atomic_read(&slot->busy));
+	dw->msg_queue = msg;
+	dw->msg_queue_buf = slot->buf;
+	slot->rx_count = 0;
 	spi_message_init(msg);
 	dw->msg_queue_xfer = (struct spi_transfer *)(msg + 1);
 	dw->msg_queue_xfer_count = 0;
@@ -728,37 +842,106 @@ void dw3000_spi_queue_start(struct dw3000 *dw)
 #endif
 }
 
+/**
+ * dw3000_spi_queue_slot() - Get SPI messages queue slot in use
+ * @dw: the DW device on which the SPI transfer will occurs
+ *
+ * Return: the slot holding current SPI messages queue.
+ */
+static inline struct dw3000_spi_queue_slot *
+dw3000_spi_queue_slot(struct dw3000 *dw)
+{
+	return &dw->spi_async.slots[dw->spi_async.slot_idx];
+}
+
+/**
+ * dw3000_spi_queue_scatter() - Copy received data to caller buffers
+ * @slot: the SPI messages queue slot which was transferred
+ */
+static void dw3000_spi_queue_scatter(struct dw3000_spi_queue_slot *slot)
+{
+	int i;
+
+	for (i = 0; i < slot->rx_count; i++)
+		memcpy(slot->rx[i].dest, slot->rx[i].src, slot->rx[i].len);
+	slot->rx_count = 0;
+}
+
+/* dw3000_spi_queue_msg() flags */
+/* RX transfers may be queued */
+#define DW3000_SPI_QUEUE_RX BIT(0)
+/* TX data after first transfer are used in place, not copied */
+#define DW3000_SPI_QUEUE_ZEROCOPY BIT(1)
+
 /**
  * dw3000_spi_queue_msg() - Add one SPI message to messages queue
  * @dw: the DW device on which the SPI transfer will occurs
  * @msg: the SPI message to add to SPI message queue
+ * @flags: DW3000_SPI_QUEUE_RX and/or DW3000_SPI_QUEUE_ZEROCOPY
  *
  * All transfers of the provided SPI message are added to the local SPI messages
- * queue. TX only transfer can be queued, so message queue must be flushed
- * before any RX transfer is required.
+ * queue. TX data are copied into the queue buffer.
+ *
+ * RX transfers are only accepted if DW3000_SPI_QUEUE_RX is set, because
+ * received data are only available after the queue is flushed: space is
+ * reserved in the queue buffer and data are copied into the transfer rx_buf at
+ * this time. Callers parsing received data immediately must flush the queue
+ * first.
+ *
+ * With DW3000_SPI_QUEUE_ZEROCOPY, only the first transfer (the header) is
+ * copied, the TX data of next ones are given as is to the SPI controller. They
+ * must remain valid and unchanged until the queue is flushed and completed.
  *
  * Return: 0 on success, else a negative error code.
  */
 static inline int dw3000_spi_queue_msg(struct dw3000 *dw,
-				       struct spi_message *msg)
+				       struct spi_message *msg,
+				       unsigned int flags)
 {
+	struct dw3000_spi_queue_slot *slot = dw3000_spi_queue_slot(dw);
 	struct spi_transfer *dxfer = dw->msg_queue_xfer;
 	struct spi_transfer *xfer;
 
 	if (dxfer == NULL)
 		return -ENOBUFS;
 	list_for_each_entry (xfer, &msg->transfers, transfer_list) {
-		/* Don't support queuing RX transfer */
-		if (xfer->rx_buf)
-			return -EINVAL;
-		if ((dw->msg_queue_buf_pos + xfer->len) >=
+		bool copy = xfer->tx_buf &&
+			    (!(flags & DW3000_SPI_QUEUE_ZEROCOPY) ||
+			     xfer == list_first_entry(&msg->transfers,
+						      struct spi_transfer,
+						      transfer_list));
+		unsigned sz = copy ? xfer->len : 0;
+
+		if (xfer->rx_buf) {
+			/* Don't support queuing RX transfer if not asked */
+			if (!(flags & DW3000_SPI_QUEUE_RX))
+				return -EINVAL;
+			sz += xfer->len;
+		}
+		if ((dw->msg_queue_buf_pos + sz) >=
 		    (dw->msg_queue_buf + DW3000_QUEUED_SPI_BUFFER_SZ))
 			return -EMSGSIZE;
-		/* Copy this message transfer to next empty transfer in queue */
-		memcpy(dw->msg_queue_buf_pos, xfer->tx_buf, xfer->len);
 		memset(dxfer, 0, sizeof *dxfer);
 		dxfer->len = xfer->len;
-		dxfer->tx_buf = dw->msg_queue_buf_pos;
+		/* Copy this message transfer to next empty transfer in queue */
+		if (copy) {
+			memcpy(dw->msg_queue_buf_pos, xfer->tx_buf, xfer->len);
+			dxfer->tx_buf = dw->msg_queue_buf_pos;
+			dw->msg_queue_buf_pos += xfer->len;
+		} else {
+			dxfer->tx_buf = xfer->tx_buf;
+		}
+		/* Reserve received data space and save scatter destination */
+		if (xfer->rx_buf) {
+			struct dw3000_spi_queue_rx *rx =
+				&slot->rx[slot->rx_count++];
+
+			dxfer->rx_buf = dw->msg_queue_buf_pos;
+			rx->dest = xfer->rx_buf;
+			rx->src = dxfer->rx_buf;
+			rx->len = xfer->len;
+			dw->msg_queue_buf_pos += xfer->len;
+		}
 		if (list_is_last(&xfer->transfer_list, &msg->transfers)) {
 			dxfer->cs_change = true;
 #if (KERNEL_VERSION(5, 5, 0) <= LINUX_VERSION_CODE)
@@ -770,7 +953,6 @@ static inline int dw3000_spi_queue_msg(struct dw3000 *dw,
 		spi_message_add_tail(dxfer, dw->msg_queue);
 		dw->msg_queue_xfer_count++;
 		/* Prepare next */
-		dw->msg_queue_buf_pos += dxfer->len;
 		if (dw->msg_queue_xfer_count >= DW3000_MAX_QUEUED_SPI_XFER) {
 			dxfer = NULL;
 			break;
@@ -784,6 +966,21 @@ static inline int dw3000_spi_queue_msg(struct dw3000 *dw,
 	return 0;
 }
 
+/**
+ * dw3000_reg_cache_invalidate() - Invalidate shadow registers cache
+ * @dw: the DW device
+ *
+ * Must be called each time chip registers may have lost their value, after a
+ * reset or while in deep sleep, or may not hold the value written in cache,
+ * after a failed queued transfer.
+ */
+static void dw3000_reg_cache_invalidate(struct dw3000 *dw)
+{
+	mutex_lock(&dw->msg_mutex);
+	dw->reg_cache.valid = 0;
+	mutex_unlock(&dw->msg_mutex);
+}
+
 /**
  * dw3000_spi_queue_reset() - Reset message queue
  * @dw: the DW device on which the SPI transfer will occurs
@@ -793,7 +990,8 @@ static inline int dw3000_spi_queue_msg(struct dw3000 *dw,
  * This must be called when an error happen while SPI message are
  * queued to ensure queuing mode is disabled.
  *
- * This revert dw3000_spi_sync() to immediate transaction mode.
+ * This revert dw3000_spi_sync() to immediate transaction mode. On error, the
+ * shadow registers cache, updated when writes were queued, is invalidated.
  *
  * Return: the rc given value
  */
@@ -802,7 +1000,128 @@ int dw3000_spi_queue_reset(struct dw3000 *dw, int rc)
 #ifdef CONFIG_DW3000_SPI_OPTIMIZATION
 	dw->msg_queue_xfer = NULL;
 	dw->msg_queue_xfer_count = 0;
+	if (unlikely(rc))
+		dw3000_reg_cache_invalidate(dw);
+#endif
+	return rc;
+}
+
+/**
+ * dw3000_spi_async_complete() - Asynchronous SPI message completion handler
+ * @context: the SPI messages queue slot which was submitted
+ *
+ * Called by the SPI controller, possibly from atomic context. Record first
+ * error, call the user callback and release the slot.
+ */
+static void dw3000_spi_async_complete(void *context)
+{
+	struct dw3000_spi_queue_slot *slot = context;
+	struct dw3000 *dw = slot->dw;
+	struct dw3000_spi_async *async = &dw->spi_async;
+	int status = slot->msg->status;
+
+	if (unlikely(status))
+		atomic_cmpxchg(&async->status, 0, status);
+	else
+		dw3000_spi_queue_scatter(slot);
+	if (slot->cb)
+		slot->cb(dw, slot->arg, status);
+	/* Release slot, then wake up any waiter */
+	atomic_set_release(&slot->busy, 0);
+	atomic_dec(&async->inflight);
+	wake_up(&async->wq);
+}
+
+/**
+ * dw3000_spi_queue_flush_async() - Submit messages queue without waiting
+ * @dw: the DW device on which the SPI transfer will occurs
+ * @cb: optional callback called when transfers are completed
+ * @arg: argument given to @cb
+ *
+ * Submit all queued transfers in SPI message queue using spi_async() and
+ * return immediately, letting the caller continue its work while transfers
+ * are done. Next dw3000_spi_queue_start() will use another slot, so several
+ * queues can be in-flight at the same time.
+ *
+ * The SPI core executes messages in submission order, so any later transfer,
+ * synchronous or not, is done after the submitted ones. Errors are reported
+ * to @cb and recorded for next dw3000_spi_async_wait().
+ *
+ * This revert dw3000_spi_sync() to immediate transaction mode.
+ *
+ * Return: 0 on success, else a negative error code. On submission error, @cb
+ * isn't called.
+ */
+int dw3000_spi_queue_flush_async(struct dw3000 *dw, dw3000_spi_async_cb cb,
+				 void *arg)
+{
+#ifdef CONFIG_DW3000_SPI_OPTIMIZATION
+	struct dw3000_spi_async *async = &dw->spi_async;
+	struct dw3000_spi_queue_slot *slot = &async->slots[async->slot_idx];
+	struct spi_message *msg = dw->msg_queue;
+	struct spi_transfer *xfer;
+	int rc;
+
+	/* If nothing queued, nothing to do. Just reset to no-queuing mode. */
+	if (!dw->msg_queue_xfer_count) {
+		if (cb)
+			cb(dw, arg, 0);
+		return dw3000_spi_queue_reset(dw, 0);
+	}
+	/* Ensure last xfer don't have cs_change flag */
+	xfer = list_last_entry(&msg->transfers, struct spi_transfer,
+			       transfer_list);
+	xfer->cs_change = false;
+	/* Ensure dw3000_spi_sync() stop queue messages */
+	dw->msg_queue_xfer = NULL;
+	/* Submit saved SPI transfers */
+	slot->cb = cb;
+	slot->arg = arg;
+	msg->complete = dw3000_spi_async_complete;
+	msg->context = slot;
+	atomic_set(&slot->busy, 1);
+	atomic_inc(&async->inflight);
+	rc = spi_async(dw->spi, msg);
+	if (unlikely(rc)) {
+		dev_err(dw->dev, "could not transfer : %d\n", rc);
+		atomic_set(&slot->busy, 0);
+		atomic_dec(&async->inflight);
+	} else {
+		/* Next queue will use next slot */
+		async->slot_idx = (async->slot_idx + 1) % DW3000_SPI_QUEUE_SLOTS;
+	}
+	/* Cleanup */
+	return dw3000_spi_queue_reset(dw, rc);
+#else
+	if (cb)
+		cb(dw, arg, 0);
+	return 0;
 #endif
+}
+
+/**
+ * dw3000_spi_async_wait() - Wait for all asynchronous SPI messages
+ * @dw: the DW device on which the SPI transfers occurs
+ *
+ * Wait until all messages submitted by dw3000_spi_queue_flush_async() are
+ * completed and report the first error which occurred since last call. On
+ * error, the shadow registers cache is invalidated, as it was updated when
+ * writes were queued.
+ *
+ * Return: 0 on success, else a negative error code.
+ */
+int dw3000_spi_async_wait(struct dw3000 *dw)
+{
+	struct dw3000_spi_async *async = &dw->spi_async;
+	int rc;
+
+	if (atomic_read(&async->inflight))
+		wait_event(async->wq, !atomic_read(&async->inflight));
+	rc = atomic_xchg(&async->status, 0);
+	if (unlikely(rc)) {
+		dev_err(dw->dev, "could not transfer : %d\n", rc);
+		dw3000_reg_cache_invalidate(dw);
+	}
 	return rc;
 }
 
@@ -811,7 +1130,10 @@ int dw3000_spi_queue_reset(struct dw3000 *dw, int rc)
  * @dw: the DW device on which the SPI transfer will occurs
  *
  * Flush all queued transfers in SPI message queue by calling the
- * dw3000_spi_sync() again with the SPI messages queue.
+ * dw3000_spi_sync() again with the SPI messages queue. This is the
+ * synchronous counterpart of dw3000_spi_queue_flush_async(): it also
+ * collects the status of previously submitted asynchronous queues, which
+ * are completed before this one.
  *
  * This revert dw3000_spi_sync() to immediate transaction mode.
  *
@@ -825,16 +1147,23 @@ int dw3000_spi_queue_flush(struct dw3000 *dw)
 	int rc;
 
 	/* If nothing queued, nothing to do. Just reset to no-queuing mode. */
-	if (!dw->msg_queue_xfer_count)
-		return dw3000_spi_queue_reset(dw, 0);
+	if (!dw->msg_queue_xfer_count) {
+		dw3000_spi_queue_reset(dw, 0);
+		return dw3000_spi_async_wait(dw);
+	}
 	/* Ensure last xfer don't have cs_change flag */
 	xfer = list_last_entry(&msg->transfers, struct spi_transfer,
 			       transfer_list);
 	xfer->cs_change = false;
 	/* Ensure dw3000_spi_sync() stop queue messages */
 	dw->msg_queue_xfer = NULL;
-	/* Do saved SPI transfers */
+	/* Do saved SPI transfers. Keep spi_sync() which may run the transfer
+	   directly in our context, avoiding a switch to the SPI pump thread. */
 	rc = dw3000_spi_sync(dw, msg);
+	if (!rc) {
+		dw3000_spi_queue_scatter(dw3000_spi_queue_slot(dw));
+		rc = dw3000_spi_async_wait(dw);
+	}
 	/* Cleanup */
 	return dw3000_spi_queue_reset(dw, rc);
 #else
@@ -860,7 +1189,7 @@ static inline int dw3000_spi_sync(struct dw3000 *dw, struct spi_message *msg)
 {
 	int rc;
 	if (dw->msg_queue_xfer)
-		return dw3000_spi_queue_msg(dw, msg);
+		return dw3000_spi_queue_msg(dw, msg, 0);
 	rc = spi_sync(dw->spi, msg);
 	if (rc)
 		dev_err(dw->dev, "could not transfer : %d\n", rc);
@@ -878,6 +1207,317 @@ static inline bool dw3000_spi_queue_active(struct dw3000 *dw)
 	return (dw->msg_queue_xfer || dw->msg_queue_xfer_count);
 }
 
+/**
+ * dw3000_spi_queue_save() - Save queued transfers as a replayable program
+ * @dw: the DW device on which the SPI transfer will occurs
+ * @prog: where to save the queued transfers
+ *
+ * Only write transfers with data copied into the queue buffer can be saved,
+ * so the queue must be built without DW3000_SPI_QUEUE_RX nor
+ * DW3000_SPI_QUEUE_ZEROCOPY. The queue is left unchanged and must still be
+ * flushed.
+ *
+ * Return: 0 on success, else a negative error code and @prog is left invalid.
+ */
+static int dw3000_spi_queue_save(struct dw3000 *dw,
+				 struct dw3000_spi_program *prog)
+{
+#ifdef CONFIG_DW3000_SPI_OPTIMIZATION
+	size_t len = dw->msg_queue_buf_pos - dw->msg_queue_buf;
+	struct spi_transfer *xfer;
+	int n = 0;
+
+	prog->valid = false;
+	if (!dw->msg_queue || len > sizeof(prog->buf) ||
+	    dw->msg_queue_xfer_count > DW3000_SPI_PROGRAM_MAX_XFER)
+		return -EMSGSIZE;
+	list_for_each_entry (xfer, &dw->msg_queue->transfers, transfer_list) {
+		const char *tx_buf = xfer->tx_buf;
+
+		/* TX data must be in the saved part of the queue buffer */
+		if (xfer->rx_buf || !tx_buf || tx_buf < dw->msg_queue_buf ||
+		    tx_buf + xfer->len > dw->msg_queue_buf + len)
+			return -EINVAL;
+		prog->xfers[n].offset = tx_buf - dw->msg_queue_buf;
+		prog->xfers[n].len = xfer->len;
+		prog->xfers[n].cs_change = xfer->cs_change;
+		n++;
+	}
+	memcpy(prog->buf, dw->msg_queue_buf, len);
+	prog->n_xfers = n;
+	prog->buf_len = len;
+	prog->valid = true;
+	return 0;
+#else
+	prog->valid = false;
+	return -EOPNOTSUPP;
+#endif
+}
+
+/**
+ * dw3000_spi_queue_program() - Add a saved program to messages queue
+ * @dw: the DW device on which the SPI transfer will occurs
+ * @prog: the program saved by dw3000_spi_queue_save()
+ *
+ * Program data are copied into the queue buffer, so the queue is the same as
+ * if the functions which built the program were called again.
+ *
+ * Return: 0 on success, else a negative error code.
+ */
+static int dw3000_spi_queue_program(struct dw3000 *dw,
+				    const struct dw3000_spi_program *prog)
+{
+#ifdef CONFIG_DW3000_SPI_OPTIMIZATION
+	struct spi_transfer *dxfer = dw->msg_queue_xfer;
+	char *buf = dw->msg_queue_buf_pos;
+	int i;
+
+	if (!dxfer || dw->msg_queue_xfer_count + prog->n_xfers >
+			      DW3000_MAX_QUEUED_SPI_XFER)
+		return -ENOBUFS;
+	if ((buf + prog->buf_len) >=
+	    (dw->msg_queue_buf + DW3000_QUEUED_SPI_BUFFER_SZ))
+		return -EMSGSIZE;
+	memcpy(buf, prog->buf, prog->buf_len);
+	for (i = 0; i < prog->n_xfers; i++, dxfer++) {
+		const struct dw3000_spi_program_xfer *pxfer = &prog->xfers[i];
+
+		memset(dxfer, 0, sizeof *dxfer);
+		dxfer->tx_buf = buf + pxfer->offset;
+		dxfer->len = pxfer->len;
+		dxfer->cs_change = pxfer->cs_change;
+#if (KERNEL_VERSION(5, 5, 0) <= LINUX_VERSION_CODE)
+		if (dxfer->cs_change) {
+			dxfer->cs_change_delay.unit = SPI_DELAY_UNIT_NSECS;
+			dxfer->cs_change_delay.value = 0;
+		}
+#endif
+		spi_message_add_tail(dxfer, dw->msg_queue);
+	}
+	dw->msg_queue_buf_pos += prog->buf_len;
+	dw->msg_queue_xfer_count += prog->n_xfers;
+	/* Same as dw3000_spi_queue_msg() when the queue is full */
+	dw->msg_queue_xfer =
+		dw->msg_queue_xfer_count < DW3000_MAX_QUEUED_SPI_XFER ? dxfer :
+									NULL;
+	return 0;
+#else
+	return -EOPNOTSUPP;
+#endif
+}
+
+/**
+ * dw3000_reg_cache_find() - Find cached register overlapping an access
+ * @cache: the shadow registers cache
+ * @addr: access address, fileID plus offset
+ * @length: access length in bytes
+ * @inside: set to true if access is fully inside the found register
+ *
+ * Return: index of the first overlapping entry, or -1 if none.
+ */
+static int dw3000_reg_cache_find(struct dw3000_reg_cache *cache, u32 addr,
+				 u16 length, bool *inside)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		u32 start = cache->entries[i].fileid;
+		u32 end = start + sizeof(cache->entries[i].value);
+
+		if (addr < end && addr + length > start) {
+			*inside = addr >= start && addr + length <= end;
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * dw3000_reg_cache_drop() - Forget cached registers overlapping an access
+ * @cache: the shadow registers cache
+ * @addr: access address, fileID plus offset
+ * @length: access length in bytes
+ *
+ * Must be called with msg_mutex held.
+ */
+static void dw3000_reg_cache_drop(struct dw3000_reg_cache *cache, u32 addr,
+				  u16 length)
+{
+	int i;
+
+	for (i = 0; i < cache->count; i++) {
+		u32 start = cache->entries[i].fileid;
+		u32 end = start + sizeof(cache->entries[i].value);
+
+		if (addr < end && addr + length > start)
+			cache->valid &= ~BIT(i);
+	}
+}
+
+/**
+ * dw3000_reg_cache_read() - Read a register from the shadow cache
+ * @dw: the DW device
+ * @reg_fileid: the register fileID to read
+ * @reg_offset: the register offset to read
+ * @length: the length of provided buffer
+ * @buffer: the address where to store the read data
+ *
+ * Must be called with msg_mutex held.
+ *
+ * Return: true if @buffer was filled from the cache.
+ */
+static bool dw3000_reg_cache_read(struct dw3000 *dw, u32 reg_fileid,
+				  u16 reg_offset, u16 length, void *buffer)
+{
+	struct dw3000_reg_cache *cache = &dw->reg_cache;
+	u32 addr = reg_fileid + reg_offset;
+	bool inside;
+	int i;
+
+	i = dw3000_reg_cache_find(cache, addr, length, &inside);
+	if (i < 0 || !inside)
+		return false;
+	if (!(cache->valid & BIT(i))) {
+		cache->misses++;
+		return false;
+	}
+	memcpy(buffer, cache->entries[i].value + addr - cache->entries[i].fileid,
+	       length);
+	cache->hits++;
+	return true;
+}
+
+/**
+ * dw3000_reg_cache_fill() - Update shadow cache with register read data
+ * @dw: the DW device
+ * @reg_fileid: the register fileID read
+ * @reg_offset: the register offset read
+ * @length: the length of read data
+ * @buffer: the read data
+ *
+ * Only a full read of a cached register makes it valid. Must be called with
+ * msg_mutex held.
+ */
+static void dw3000_reg_cache_fill(struct dw3000 *dw, u32 reg_fileid,
+				  u16 reg_offset, u16 length,
+				  const void *buffer)
+{
+	struct dw3000_reg_cache *cache = &dw->reg_cache;
+	u32 addr = reg_fileid + reg_offset;
+	struct dw3000_reg_cache_entry *entry;
+	bool inside;
+	int i;
+
+	i = dw3000_reg_cache_find(cache, addr, length, &inside);
+	if (i < 0 || !inside)
+		return;
+	entry = &cache->entries[i];
+	if (addr != entry->fileid || length != sizeof(entry->value))
+		return;
+	memcpy(entry->value, buffer, sizeof(entry->value));
+	cache->valid |= BIT(i);
+}
+
+/**
+ * dw3000_reg_cache_write() - Update shadow cache before a register write
+ * @dw: the DW device
+ * @reg_fileid: the register fileID to write
+ * @reg_offset: the register offset to write
+ * @length: the length of provided buffer
+ * @buffer: the data to write, AND mask then OR mask for modify modes
+ * @mode: the write operation mode to use (direct, bitmask and/or)
+ *
+ * Compute the register value after the write. If it is unchanged, the write
+ * can be skipped. Else the cache is updated with the new value, or the register
+ * is forgotten when its new value can't be known. Must be called with
+ * msg_mutex held.
+ *
+ * Return: true if the write is redundant and must be elided.
+ */
+static bool dw3000_reg_cache_write(struct dw3000 *dw, u32 reg_fileid,
+				   u16 reg_offset, u16 length,
+				   const void *buffer, enum spi_modes mode)
+{
+	struct dw3000_reg_cache *cache = &dw->reg_cache;
+	u32 addr = reg_fileid + reg_offset;
+	bool modify = mode & DW3000_SPI_AND_OR_MSK;
+	u16 len = modify ? length / 2 : length;
+	struct dw3000_reg_cache_entry *entry;
+	const u8 *data = buffer;
+	u8 value[4];
+	bool inside;
+	int i, j, pos;
+
+	i = dw3000_reg_cache_find(cache, addr, len, &inside);
+	if (i < 0)
+		return false;
+	if (!inside) {
+		/* Access across cached registers, forget all of them */
+		dw3000_reg_cache_drop(cache, addr, len);
+		return false;
+	}
+	entry = &cache->entries[i];
+	cache->writes++;
+	if (!(cache->valid & BIT(i))) {
+		/* Unknown previous value, only a full write gives the new one */
+		if (!modify && len == sizeof(entry->value) &&
+		    addr == entry->fileid) {
+			memcpy(entry->value, data, len);
+			cache->valid |= BIT(i);
+		}
+		return false;
+	}
+	pos = addr - entry->fileid;
+	memcpy(value, entry->value, sizeof(value));
+	for (j = 0; j < len; j++)
+		value[pos + j] = modify ? (value[pos + j] & data[j]) |
+						  data[len + j] :
+					  data[j];
+	if (!memcmp(value, entry->value, sizeof(value))) {
+		cache->writes--;
+		cache->elided++;
+		return true;
+	}
+	memcpy(entry->value, value, sizeof(value));
+	return false;
+}
+
+/**
+ * dw3000_reg_cache_init() - Initialise shadow registers cache
+ * @dw: the DW device
+ * @enable: false to disable the cache
+ *
+ * Some cached register addresses depend on the chip version, so the cache
+ * must only be enabled once it is known. The cache is left invalidated and its
+ * statistics are reset.
+ */
+static void dw3000_reg_cache_init(struct dw3000 *dw, bool enable)
+{
+	/* Registers only written by the driver, without side effects. Each one
+	   must be followed by at least 4 bytes not belonging to another
+	   register, so DRX_TUNE0 (2 bytes, followed by SFDTOC) is excluded. */
+	const u32 fileids[] = {
+		DW3000_SYS_CFG_ID,   DW3000_TX_FCTRL_ID,  DW3000_TX_FCTRL_HI_ID,
+		DW3000_TX_ANTD_ID,   DW3000_TX_POWER_ID,  DW3000_CHAN_CTRL_ID,
+		DW3000_GPIO_MODE_ID, DW3000_GPIO_DIR_ID,  DW3000_GPIO_OUT_ID,
+		DW3000_TX_CTRL_HI_ID,
+	};
+	struct dw3000_reg_cache *cache = &dw->reg_cache;
+	int i;
+
+	BUILD_BUG_ON(ARRAY_SIZE(fileids) > DW3000_REG_CACHE_SIZE);
+	mutex_lock(&dw->msg_mutex);
+	for (i = 0; i < ARRAY_SIZE(fileids); i++)
+		cache->entries[i].fileid = fileids[i];
+	cache->count = enable ? ARRAY_SIZE(fileids) : 0;
+	cache->valid = 0;
+	cache->hits = 0;
+	cache->misses = 0;
+	cache->elided = 0;
+	cache->writes = 0;
+	mutex_unlock(&dw->msg_mutex);
+}
+
 /**
  * dw3000_xfer() - Generic low-level slow transfer
  * @dw: the DW device on which the SPI transfer will occurs
@@ -913,10 +1553,56 @@ int dw3000_xfer(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset, u16 length,
 	/* Prepare header & data transfers */
 	dw3000_prepare_xfer(&xfer.msg, reg_fileid, reg_offset, length, buffer,
 			    mode);
+	if (mode != DW3000_SPI_RD_BIT) {
+		/* Written data may change cached registers */
+		mutex_lock(&dw->msg_mutex);
+		dw3000_reg_cache_drop(&dw->reg_cache, reg_fileid + reg_offset,
+				      length);
+		mutex_unlock(&dw->msg_mutex);
+	}
 	/* Now execute this spi message synchronously */
 	return dw3000_spi_sync(dw, &xfer.msg);
 }
 
+/**
+ * dw3000_spi_queue_read() - Queue a deferred register read
+ * @dw: the DW device on which the SPI transfer will occurs
+ * @reg_fileid: the fileID to read
+ * @reg_offset: the offset where to read
+ * @length: the length of provided buffer and SPI data transfer
+ * @buffer: the address where to store read data
+ *
+ * Record a register read in the SPI messages queue, allowing reads and writes
+ * to be done in a single SPI message. The @buffer is filled with raw register
+ * data once the queue is flushed, so it must remain valid until then and
+ * mustn't be used before.
+ *
+ * If SPI queuing mode isn't active, the read is done immediately.
+ *
+ * Return: 0 on success, else a negative error code.
+ */
+int dw3000_spi_queue_read(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
+			  u16 length, void *buffer)
+{
+	struct {
+		struct spi_message msg;
+		struct spi_transfer header;
+		struct spi_transfer data;
+		u8 header_buf[2];
+	} xfer = {};
+
+	if (!dw->msg_queue_xfer)
+		return dw3000_xfer(dw, reg_fileid, reg_offset, length, buffer,
+				   DW3000_SPI_RD_BIT);
+	/* Same construction as dw3000_xfer(), header is copied in queue */
+	xfer.header.tx_buf = xfer.header_buf;
+	xfer.header.len = sizeof(xfer.header_buf);
+	spi_message_init_with_transfers(&xfer.msg, &xfer.header, 2);
+	dw3000_prepare_xfer(&xfer.msg, reg_fileid, reg_offset, length, buffer,
+			    DW3000_SPI_RD_BIT);
+	return dw3000_spi_queue_msg(dw, &xfer.msg, DW3000_SPI_QUEUE_RX);
+}
+
 /**
  * dw3000_write_fastcmd() - Send a fast command to the device
  * @dw: the DW device on which the SPI transfer will occurs
@@ -966,6 +1652,12 @@ int dw3000_reg_read_fast(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
 	int rc;
 
 	mutex_lock(&dw->msg_mutex);
+	/* Non-volatile register value may be already known */
+	if (dw3000_reg_cache_read(dw, reg_fileid, reg_offset, length,
+				  buffer)) {
+		mutex_unlock(&dw->msg_mutex);
+		return 0;
+	}
 	/* Update header and length */
 	dw3000_prepare_xfer(msg, reg_fileid, reg_offset, length, NULL,
 			    DW3000_SPI_RD_BIT);
@@ -975,9 +1667,14 @@ int dw3000_reg_read_fast(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
 	memset((void *)tr->tx_buf + hlen, 0, length);
 	/* Execute SPI transfer */
 	rc = dw3000_spi_sync(dw, msg);
-	if (!rc)
+	if (!rc) {
 		/* Get back the data that are after the header in RX buffer */
 		memcpy(buffer, tr->rx_buf + hlen, length);
+		/* Queued read data isn't available yet, don't cache it */
+		if (!dw->msg_queue_xfer)
+			dw3000_reg_cache_fill(dw, reg_fileid, reg_offset,
+					      length, buffer);
+	}
 	mutex_unlock(&dw->msg_mutex);
 	return rc;
 }
@@ -1074,6 +1771,12 @@ int dw3000_reg_write_fast(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
 	int rc;
 
 	mutex_lock(&dw->msg_mutex);
+	/* Skip write if register already holds the value */
+	if (dw3000_reg_cache_write(dw, reg_fileid, reg_offset, length, buffer,
+				   mode)) {
+		mutex_unlock(&dw->msg_mutex);
+		return 0;
+	}
 	/* Update header and length */
 	dw3000_prepare_xfer(msg, reg_fileid, reg_offset, length, NULL, mode);
 	/* Data are after the header in TX buffer */
@@ -1085,6 +1788,10 @@ int dw3000_reg_write_fast(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
 	tr->rx_buf = NULL;
 	/* Execute SPI transfer */
 	rc = dw3000_spi_sync(dw, msg);
+	if (unlikely(rc))
+		/* Register value is unknown now */
+		dw3000_reg_cache_drop(&dw->reg_cache, reg_fileid + reg_offset,
+				      length);
 	/* Restore RX buffer */
 	tr->rx_buf = rx_buf;
 	mutex_unlock(&dw->msg_mutex);
@@ -1530,6 +2237,42 @@ int dw3000_read_rx_timestamp(struct dw3000 *dw, u64 *rx_ts)
 	return rc;
 }
 
+/**
+ * dw3000_read_rx_fastpath() - Read SYS_STATUS, RX frame info and timestamp
+ * @dw: the DW device on which the SPI transfer will occurs
+ * @isr: ISR data where to store read values
+ *
+ * Use the prebuilt ISR RX fast path message to read all registers needed to
+ * report a good frame in a single SPI message. Read values are only
+ * meaningful in single buffer mode.
+ *
+ * Return: 0 on success, else a negative error code.
+ */
+static int dw3000_read_rx_fastpath(struct dw3000 *dw,
+				   struct dw3000_isr_data *isr)
+{
+	struct spi_message *msg = dw->msg_read_rx_fastpath;
+	struct spi_transfer *tr;
+	int rc;
+
+	rc = dw3000_spi_sync(dw, msg);
+	if (unlikely(rc))
+		return rc;
+	/* Data are at end of each transfer, after the header */
+	tr = list_first_entry(&msg->transfers, struct spi_transfer,
+			      transfer_list);
+	isr->status = get_unaligned_le64(tr->rx_buf + tr->len - sizeof(u64));
+	tr = list_next_entry(tr, transfer_list);
+	isr->finfo16 = get_unaligned_le16(tr->rx_buf + tr->len - sizeof(u16));
+	tr = list_next_entry(tr, transfer_list);
+	isr->ts_rctu = get_unaligned_le64(tr->rx_buf + tr->len -
+					  DW3000_RX_TIME_RX_STAMP_LEN) &
+		       ((1ull << (DW3000_RX_TIME_RX_STAMP_LEN * 8)) - 1);
+	/* Frame info and timestamp don't need to be read again */
+	isr->rx_flags = DW3000_RX_FLAG_TS;
+	return 0;
+}
+
 /**
  * dw3000_configure_ciadiag() - Enable CIA diagnostic data
  * @dw: the DW device
@@ -1977,6 +2720,7 @@ int dw3000_poweroff(struct dw3000 *dw)
 	/* Update operational state and power stats */
 	dw3000_set_operational_state(dw, DW3000_OP_STATE_OFF);
 	dw3000_power_stats(dw, DW3000_PWR_OFF, 0);
+	dw3000_power_stats_wakeup_cancel(dw);
 
 	/* Ensure RESET is asserted at least the required time */
 	usleep_range(DW3000_HARD_RESET_DELAY_US,
@@ -2085,19 +2829,24 @@ static inline int dw3000_setdelayedtrxtime(struct dw3000 *dw, u32 starttime)
  * @dw: the DW device
  * @delay_us: the delay before which RX/TX must be executed
  *
+ * The learned wake-up latency is used, see dw3000_wakeup_latency_us(). It is
+ * only learned from wake-ups, so auto_sleep_margin_us must be 0 or more.
+ *
  * Return: zero if not enough time to enter deep sleep, else a positive delay
  *  in us.
  */
 int dw3000_can_deep_sleep(struct dw3000 *dw, int delay_us)
 {
+	int latency_us = dw3000_wakeup_latency_us(dw);
+
 	/* We can't enter DEEP_SLEEP if previous operation has
 	 * required ranging clock or if deep-sleep is disabled. */
 	if (dw->need_ranging_clock || (dw->auto_sleep_margin_us < 0))
 		return 0;
-	if (delay_us < max(DW3000_WAKEUP_LATENCY_US, dw->auto_sleep_margin_us))
+	if (delay_us < max(latency_us, dw->auto_sleep_margin_us))
 		return 0;
 	/* Take care of wakeup latency in returned result */
-	return delay_us - DW3000_WAKEUP_LATENCY_US;
+	return delay_us - latency_us;
 }
 
 /**
@@ -2119,10 +2868,14 @@ static int dw3000_wakeup(struct dw3000 *dw)
 	/* Avoid race condition with dw3000_poweroff while chip is stopped just
 	   when dw3000_idle_timeout() HR timer callback is executed. Do nothing
 	   if not in DEEP-SLEEP state. */
-	if (dw->current_operational_state != DW3000_OP_STATE_DEEP_SLEEP)
+	if (dw->current_operational_state != DW3000_OP_STATE_DEEP_SLEEP) {
+		/* Forget start recorded by dw3000_deepsleep_wakeup() */
+		dw3000_power_stats_wakeup_cancel(dw);
 		return 0;
+	}
 
 	trace_dw3000_wakeup(dw);
+	dw3000_power_stats_wakeup_start(dw);
 
 	/* Add a delay after transfer. See spi_transfer_delay_exec() called by
 	   spi_transfer_one_message(). */
@@ -2139,6 +2892,8 @@ static int dw3000_wakeup(struct dw3000 *dw)
 		dw3000_set_operational_state(dw, DW3000_OP_STATE_WAKE_UP);
 		/* Re-enable spi's irqs. deepsleep disable them */
 		enable_irq(dw->spi->irq);
+	} else {
+		dw3000_power_stats_wakeup_cancel(dw);
 	}
 	/* Reset delay in transfer */
 #if (KERNEL_VERSION(5, 13, 0) > LINUX_VERSION_CODE)
@@ -2214,6 +2969,8 @@ bool dw3000_deepsleep_wakeup(struct dw3000 *dw)
 	    dw->deep_sleep_state.next_operational_state >
 		    DW3000_OP_STATE_IDLE_PLL) {
 		struct dw3000_stm_command cmd = { do_wakeup, NULL, NULL };
+		/* Wake-up latency is measured from timer expiration */
+		dw3000_power_stats_wakeup_start(dw);
 		/* The chip is about to wake up, let's request the best QoS
 		   latency early */
 		dw3000_pm_qos_update_request(dw, dw3000_qos_latency);
@@ -2365,9 +3122,12 @@ int dw3000_check_operational_state(struct dw3000 *dw, int delay_dtu,
 		if (can_sync)
 			dw3000_may_resync(dw);
 		/* Update delay_us with wakeup margin */
-		delay_us = dw3000_can_deep_sleep(dw, delay_us);
-		if (!delay_us)
+		rc = dw3000_can_deep_sleep(dw, delay_us);
+		if (!rc) {
+			dw3000_sleep_missed(dw, delay_us);
 			break;
+		}
+		delay_us = rc;
 		/* Enter DEEP SLEEP and setup wakeup timer */
 		rc = dw3000_deep_sleep_and_wakeup(dw, delay_us);
 		if (!rc)
@@ -2674,6 +3434,7 @@ static irqreturn_t dw3000_irq_handler(int irq, void *context)
 	struct dw3000 *dw = context;
 
 	atomic64_inc(&dw->power.interrupts);
+	dw3000_lat_stats_irq(dw);
 	dw3000_enqueue_irq(dw);
 
 	return IRQ_HANDLED;
@@ -2995,6 +3756,8 @@ int dw3000_hardreset(struct dw3000 *dw)
 {
 	int rc;
 
+	/* Chip version may change, disable cache until soft reset */
+	dw3000_reg_cache_init(dw, false);
 	rc = dw3000_reset_assert(dw, true);
 	if (rc)
 		return rc;
@@ -3062,6 +3825,66 @@ static int dw3000_tx_write_data(struct dw3000 *dw, u8 *buffer, u16 len)
 	return 0;
 }
 
+/**
+ * dw3000_tx_write_skb() - Write frame data to the TX buffer without copy
+ * @dw: the DW device
+ * @skb: the frame to write, possibly with paged fragments
+ *
+ * Build a single SPI message with the TX buffer header followed by one
+ * transfer per skb fragment. In SPI queuing mode, fragments are referenced by
+ * the queue instead of being copied into its buffer, so the skb must not be
+ * released before the queue is flushed and completed, as done by
+ * dw3000_tx_frame().
+ *
+ * Return: zero on success, else a negative error code.
+ */
+static int dw3000_tx_write_skb(struct dw3000 *dw, struct sk_buff *skb)
+{
+	struct {
+		struct spi_message msg;
+		struct spi_transfer header;
+		struct spi_transfer data[DW3000_TX_MAX_FRAGS];
+		u8 header_buf[2];
+	} xfer = {};
+	struct skb_shared_info *shinfo = skb_shinfo(skb);
+	int i, rc;
+
+	if (skb->len >= DW3000_TX_BUFFER_MAX_LEN)
+		return -EINVAL;
+	/* Fall back to a linear copy if fragments can't be used directly */
+	for (i = 0; i < shinfo->nr_frags; i++)
+		if (!skb_frag_address_safe(&shinfo->frags[i]))
+			break;
+	if (unlikely(i < shinfo->nr_frags ||
+		     shinfo->nr_frags >= DW3000_TX_MAX_FRAGS ||
+		     skb_has_frag_list(skb) || !skb_headlen(skb))) {
+		rc = skb_linearize(skb);
+		if (rc)
+			return rc;
+	}
+	/* Header and linear data transfers */
+	xfer.header.tx_buf = xfer.header_buf;
+	xfer.header.len = sizeof(xfer.header_buf);
+	spi_message_init_with_transfers(&xfer.msg, &xfer.header, 2);
+	rc = dw3000_prepare_xfer(&xfer.msg, DW3000_TX_BUFFER_ID, 0,
+				 skb_headlen(skb), skb->data,
+				 DW3000_SPI_WR_BIT);
+	if (rc)
+		return rc;
+	/* One transfer per page fragment */
+	for (i = 0; i < shinfo->nr_frags; i++) {
+		struct spi_transfer *tr = &xfer.data[i + 1];
+
+		tr->tx_buf = skb_frag_address(&shinfo->frags[i]);
+		tr->len = skb_frag_size(&shinfo->frags[i]);
+		spi_message_add_tail(tr, &xfer.msg);
+	}
+	if (dw->msg_queue_xfer)
+		return dw3000_spi_queue_msg(dw, &xfer.msg,
+					    DW3000_SPI_QUEUE_ZEROCOPY);
+	return dw3000_spi_sync(dw, &xfer.msg);
+}
+
 static int do_change_speed(struct dw3000 *dw, const void *in, void *out)
 {
 	/* Need to reset pre-allocated message which hold speed */
@@ -3121,6 +3944,9 @@ int dw3000_softreset(struct dw3000 *dw)
 	if (rc)
 		return rc;
 
+	/* All registers are back to their reset value */
+	dw3000_reg_cache_init(dw, true);
+
 	/* Switch back to full SPI clock speed */
 	dw3000_change_speed(dw, dw->of_max_speed_hz);
 
@@ -3420,6 +4246,7 @@ static int dw3000_setrxaftertxdelay(struct dw3000 *dw, u32 rx_delay_time)
  * @rx_delay_dly: positive if needed to active RX after TX otherwise null
  * @rx_timeout_pac: the preamble detect timeout
  * @ranging: true if transmitting ranging frame
+ * @prepared: true if the frame data is already in the TX buffer
  *
  * This function prepares, executes or programs TX according to a given socket
  * buffer pointer provided by the MCPS.
@@ -3428,7 +4255,7 @@ static int dw3000_setrxaftertxdelay(struct dw3000 *dw, u32 rx_delay_time)
  */
 int dw3000_tx_frame(struct dw3000 *dw, struct sk_buff *skb, bool tx_delayed,
 		    u32 tx_date_dtu, int rx_delay_dly, u32 rx_timeout_pac,
-		    bool ranging)
+		    bool ranging, bool prepared)
 {
 	u32 cur_time_dtu = 0;
 	int rc, len;
@@ -3465,8 +4292,8 @@ int dw3000_tx_frame(struct dw3000 *dw, struct sk_buff *skb, bool tx_delayed,
 		/* Write frame properties to the transmit frame control register */
 		if (WARN_ON(len > dw->data.max_frames_len))
 			return -EINVAL;
-		/* Write frame data to the DW IC buffer */
-		if (dw3000_tx_write_data(dw, skb->data, skb->len) != 0) {
+		/* Write frame data to the DW IC buffer, unless preloaded */
+		if (!prepared && dw3000_tx_write_skb(dw, skb) != 0) {
 			dev_err(dw->dev, "cannot write frame data to DW IC\n");
 			return -EINVAL;
 		}
@@ -3485,20 +4312,28 @@ int dw3000_tx_frame(struct dw3000 *dw, struct sk_buff *skb, bool tx_delayed,
 		return rc;
 
 	/* Flush SPI queue before dw3000_coex_start() because coex use it
-	   already. */
-	rc = dw3000_spi_queue_flush(dw);
+	   already. Don't wait for completion, the frame data transfer is done
+	   while coexistence is computed, next transfers are executed after. */
+	rc = dw3000_spi_queue_flush_async(dw, NULL, NULL);
 	if (unlikely(rc))
 		return rc;
 
 	/* Update TX parameters according to Wifi coexistence */
 	rc = dw3000_coex_start(dw, &tx_delayed, &tx_date_dtu, cur_time_dtu);
-	if (unlikely(rc))
+	if (unlikely(rc)) {
+		dw3000_spi_async_wait(dw);
 		return rc;
+	}
 
 	if (!tx_delayed) {
 		/* Program immediate transmission. */
 		cmd = rx_delay_dly >= 0 ? DW3000_CMD_TX_W4R : DW3000_CMD_TX;
 		rc = dw3000_write_fastcmd(dw, cmd);
+		if (unlikely(rc))
+			goto stop_coex;
+		dw3000_lat_stats_tx_start(dw, true);
+		/* Collect status of asynchronous transfers, done by now */
+		rc = dw3000_spi_async_wait(dw);
 		if (unlikely(rc))
 			goto stop_coex;
 		/* W4R mode are handled by TX event IRQ handler */
@@ -3517,14 +4352,15 @@ int dw3000_tx_frame(struct dw3000 *dw, struct sk_buff *skb, bool tx_delayed,
 	rc = dw3000_write_fastcmd(dw, cmd);
 	if (unlikely(rc))
 		goto stop_coex;
-	/* Execute SPI queued transfers */
-	rc = dw3000_spi_queue_flush(dw);
+	/* Execute SPI queued transfers, power stats are updated meanwhile */
+	rc = dw3000_spi_queue_flush_async(dw, NULL, NULL);
 	if (unlikely(rc))
 		goto stop_coex;
+	dw3000_lat_stats_tx_start(dw, false);
 
 	/* W4R mode are handled by TX event IRQ handler */
 	dw3000_power_stats(dw, DW3000_PWR_TX, len);
-	/* Check if late */
+	/* Check if late, this read is done after queued transfers */
 	rc = dw3000_check_hpdwarn(dw);
 	if (unlikely(rc)) {
 		if (rc == -ETIME) {
@@ -3534,8 +4370,12 @@ int dw3000_tx_frame(struct dw3000 *dw, struct sk_buff *skb, bool tx_delayed,
 		}
 		goto stop_coex;
 	}
+	rc = dw3000_spi_async_wait(dw);
+	if (unlikely(rc))
+		goto stop_coex;
 	return dw->chip_ops->check_tx_ok(dw);
 stop_coex:
+	dw3000_spi_async_wait(dw);
 	dw3000_coex_stop(dw);
 	return rc;
 }
@@ -3576,11 +4416,18 @@ int dw3000_do_tx_frame(struct dw3000 *dw,
 	bool ranging = false;
 	int delay_dtu = 0;
 	bool can_sync = false;
+	bool prepared;
 	int rc;
 	u8 sts_mode;
 
 	trace_dw3000_mcps_tx_frame(dw, config->flags, skb ? skb->len : 0);
 
+	/* Preloaded data is only used once, for the frame it was written for */
+	prepared = skb &&
+		   (config->flags & MCPS802154_TX_FRAME_CONFIG_PREPARED) &&
+		   dw->tx_prepared_frame_idx == frame_idx;
+	dw->tx_prepared_frame_idx = -1;
+
 	/* Calculate the transfer date.*/
 	if (config->flags & MCPS802154_TX_FRAME_CONFIG_TIMESTAMP_DTU) {
 		tx_date_dtu = config->timestamp_dtu + llhw->shr_dtu;
@@ -3615,7 +4462,7 @@ int dw3000_do_tx_frame(struct dw3000 *dw,
 		if (rc < 0)
 			return rc;
 		/* Save parameters to activate TX delayed when
-		   wakeup later */
+		   wakeup later, TX buffer content is lost in deep sleep */
 		dw->wakeup_done_cb = dw3000_wakeup_done_to_tx;
 		dss->next_operational_state = DW3000_OP_STATE_TX;
 		dss->tx_config = *config;
@@ -3676,7 +4523,7 @@ int dw3000_do_tx_frame(struct dw3000 *dw,
 		}
 	}
 	rc = dw3000_tx_frame(dw, skb, tx_delayed, tx_date_dtu, rx_delay_dly,
-			     rx_timeout_pac, ranging);
+			     rx_timeout_pac, ranging, prepared);
 	if (unlikely(rc))
 		goto fail;
 
@@ -3692,6 +4539,39 @@ fail:
 	return rc;
 }
 
+/**
+ * dw3000_do_tx_prepare_frame() - Preload a frame in the TX buffer
+ * @dw: the DW device
+ * @skb: the next frame to transmit, or NULL to drop a preloaded frame
+ * @frame_idx: index of the frame in the block
+ *
+ * Called while a reception is in progress, the TX buffer is unused. The
+ * next dw3000_do_tx_frame() for the same frame index, flagged as prepared by
+ * the MCPS, will not write it again.
+ *
+ * Return: zero on success, else a negative error code.
+ */
+int dw3000_do_tx_prepare_frame(struct dw3000 *dw, struct sk_buff *skb,
+			       int frame_idx)
+{
+	int len;
+	int rc;
+
+	dw->tx_prepared_frame_idx = -1;
+	if (!skb)
+		return 0;
+	/* Nothing can be written while the chip sleeps */
+	if (dw->current_operational_state < DW3000_OP_STATE_IDLE_RC)
+		return -EBUSY;
+	len = skb->len + (dw->pctt.enabled ? 0 : IEEE802154_FCS_LEN);
+	if (len > dw->data.max_frames_len)
+		return -EINVAL;
+	rc = dw3000_tx_write_skb(dw, skb);
+	if (!rc)
+		dw->tx_prepared_frame_idx = frame_idx;
+	return rc;
+}
+
 static int dw3000_rx_read_data(struct dw3000 *dw, u8 *buffer, u16 len,
 			       u16 offset)
 {
@@ -3724,6 +4604,88 @@ static int dw3000_rx_read_data(struct dw3000 *dw, u8 *buffer, u16 len,
 	}
 }
 
+/**
+ * dw3000_rx_skb_pool_refill() - Refill the RX socket buffers pool
+ * @work: the pool refill work
+ *
+ * Socket buffers are sized for the biggest frame allowed by current PHR mode,
+ * including the FCS.
+ *
+ * Refill runs in process context, so buffers are allocated with GFP_KERNEL.
+ */
+static void dw3000_rx_skb_pool_refill(struct work_struct *work)
+{
+	struct dw3000_rx_skb_pool *pool =
+		container_of(work, struct dw3000_rx_skb_pool, refill_work);
+	struct dw3000 *dw = container_of(pool, struct dw3000, rx.pool);
+	unsigned int len =
+		READ_ONCE(dw->data.max_frames_len) + IEEE802154_FCS_LEN;
+
+	while (skb_queue_len(&pool->skbs) < DW3000_RX_SKB_POOL_SIZE) {
+		struct sk_buff *skb = __dev_alloc_skb(len, GFP_KERNEL);
+
+		if (!skb)
+			break;
+		skb_queue_tail(&pool->skbs, skb);
+	}
+}
+
+/**
+ * dw3000_rx_skb_pool_init() - Initialise the RX socket buffers pool
+ * @dw: the DW device
+ *
+ * The pool is filled later by its refill work, once frame length is known.
+ */
+static void dw3000_rx_skb_pool_init(struct dw3000 *dw)
+{
+	struct dw3000_rx_skb_pool *pool = &dw->rx.pool;
+
+	skb_queue_head_init(&pool->skbs);
+	INIT_WORK(&pool->refill_work, dw3000_rx_skb_pool_refill);
+	atomic64_set(&pool->exhausted, 0);
+}
+
+/**
+ * dw3000_rx_skb_pool_free() - Release the RX socket buffers pool
+ * @dw: the DW device
+ */
+void dw3000_rx_skb_pool_free(struct dw3000 *dw)
+{
+	struct dw3000_rx_skb_pool *pool = &dw->rx.pool;
+
+	cancel_work_sync(&pool->refill_work);
+	skb_queue_purge(&pool->skbs);
+}
+
+/**
+ * dw3000_rx_skb_pool_get() - Get a socket buffer for a received frame
+ * @dw: the DW device
+ * @len: the needed buffer length
+ *
+ * Take a preallocated socket buffer from the pool and schedule its refill.
+ * Buffers too small, allocated before a frame length change, are dropped.
+ * If the pool is empty, fallback to a direct allocation.
+ *
+ * Return: a socket buffer or NULL on allocation failure.
+ */
+static struct sk_buff *dw3000_rx_skb_pool_get(struct dw3000 *dw,
+					      unsigned int len)
+{
+	struct dw3000_rx_skb_pool *pool = &dw->rx.pool;
+	struct sk_buff *skb;
+
+	while ((skb = skb_dequeue(&pool->skbs))) {
+		if (likely(skb_tailroom(skb) >= len))
+			break;
+		dev_kfree_skb_any(skb);
+	}
+	schedule_work(&pool->refill_work);
+	if (likely(skb))
+		return skb;
+	atomic64_inc(&pool->exhausted);
+	return dev_alloc_skb(len);
+}
+
 static int dw3000_rx_frame(struct dw3000 *dw,
 			   const struct dw3000_isr_data *data)
 {
@@ -3739,8 +4701,8 @@ static int dw3000_rx_frame(struct dw3000 *dw,
 		return 0;
 	/* Read frame data into skb */
 	if (len) {
-		/* Allocate new skb (including space for FCS added by ieee802154_rx) */
-		skb = dev_alloc_skb(len + IEEE802154_FCS_LEN);
+		/* Get new skb (including space for FCS added by ieee802154_rx) */
+		skb = dw3000_rx_skb_pool_get(dw, len + IEEE802154_FCS_LEN);
 		if (!skb) {
 			dev_err(dw->dev, "RX buffer allocation failed\n");
 			rc = -ENOMEM;
@@ -3773,6 +4735,7 @@ static int dw3000_rx_frame(struct dw3000 *dw,
 					     DUMP_PREFIX_NONE, skb->data, len);
 	}
 	/* Inform MCPS 802.15.4 that we received a frame */
+	dw3000_lat_stats_rx_frame(dw);
 	mcps802154_rx_frame(dw->llhw);
 	WARN_ON_ONCE(dw3000_rx_busy(dw, false));
 	return 0;
@@ -4619,6 +5582,8 @@ static int dw3000_setdwstate(struct dw3000 *dw, enum operational_state state)
 		 */
 		dw3000_power_stats(dw, DW3000_PWR_DEEPSLEEP, 0);
 		dw3000_set_operational_state(dw, DW3000_OP_STATE_DEEP_SLEEP);
+		/* Registers will be restored on wake-up, don't trust cache */
+		dw3000_reg_cache_invalidate(dw);
 		break;
 
 	case DW3000_OP_STATE_IDLE_PLL:
@@ -4952,7 +5917,7 @@ int dw3000_idle(struct dw3000 *dw, bool timestamp, u32 timestamp_dtu,
 		 * WakeUp latency! */
 		deepsleep_delay_us = idle_delay_us;
 		if (is_sleeping)
-			deepsleep_delay_us -= DW3000_WAKEUP_LATENCY_US;
+			deepsleep_delay_us -= dw3000_wakeup_latency_us(dw);
 
 		/* TODO/FIXME:
 		 * Timer is used for idle timeout and deepsleep timeout,
@@ -5197,6 +6162,8 @@ static int dw3000_configure(struct dw3000 *dw)
 	dw->data.sleep_mode &= (~(DW3000_ALT_GEAR | DW3000_SEL_GEAR3));
 	dw->data.max_frames_len = config->phrMode ? DW3000_EXT_FRAME_LEN :
 						    DW3000_STD_FRAME_LEN;
+	/* Ensure RX socket buffers pool is filled with right size buffers */
+	schedule_work(&dw->rx.pool.refill_work);
 	/* Configure the SYS_CFG register */
 	rc = dw3000_configure_sys_cfg(dw, config);
 	if (rc)
@@ -6541,7 +7508,16 @@ static void dw3000_mcps_timer_expired(struct work_struct *work)
  */
 static void dw3000_complete_cir_data(struct dw3000 *dw)
 {
-	complete(&dw->cir_data->complete);
+	struct dw3000_cir_data *cir = dw->cir_data;
+
+	/* Feed streaming ring, with RX buffer used by this frame */
+	dw3000_cir_stream_push(
+		dw, cir,
+		dw->data.dblbuffon == DW3000_DBL_BUFF_ACCESS_BUFFER_B);
+	/* Only wake up a waiting debugfs reader, a completion without waiter
+	   would give stale data to the next one */
+	if (completion_active(&cir->complete))
+		complete(&cir->complete);
 }
 
 /**
@@ -6559,8 +7535,9 @@ static int dw3000_read_ciaregs(struct dw3000 *dw)
 	/* Find witch bank is storing CIA data */
 	switch (dw->data.dblbuffon) {
 	case DW3000_DBL_BUFF_ACCESS_BUFFER_B:
-		dev_warn_once(dw->dev, "double banking not supported\n");
-		return -ENOSYS;
+		cia_bank = DW3000_DB_DIAG_SET_2;
+		length = DW3000_DB_DIAG_SET_LEN;
+		break;
 	case DW3000_DBL_BUFF_ACCESS_BUFFER_A:
 		cia_bank = DW3000_DB_DIAG_SET_1;
 		length = DW3000_DB_DIAG_SET_LEN;
@@ -6914,6 +7891,10 @@ static void dw3000_initialise(struct dw3000 *dw)
  */
 void dw3000_transfers_free(struct dw3000 *dw)
 {
+	int i;
+
+	/* ensure no message queue is still in-flight */
+	dw3000_spi_async_wait(dw);
 	/* fast command message, only one transfer */
 	dw3000_free_fastcmd(dw->msg_fast_command);
 	dw->msg_fast_command = NULL;
@@ -6942,13 +7923,22 @@ void dw3000_transfers_free(struct dw3000 *dw)
 	dw->msg_write_dss_status = NULL;
 	dw3000_free_xfer(dw->msg_write_spi_collision_status, 1);
 	dw->msg_write_spi_collision_status = NULL;
+	/* ISR RX fast path message */
+	dw3000_free_rx_fastpath(dw->msg_read_rx_fastpath);
+	dw->msg_read_rx_fastpath = NULL;
 	/* generic read/write full-duplex message */
 	dw3000_free_xfer(dw->msg_readwrite_fdx, 1);
 	dw->msg_readwrite_fdx = NULL;
-	/* message queue */
-	kfree(dw->msg_queue_buf);
+	/* message queues */
+	for (i = 0; i < DW3000_SPI_QUEUE_SLOTS; i++) {
+		struct dw3000_spi_queue_slot *slot = &dw->spi_async.slots[i];
+
+		kfree(slot->buf);
+		slot->buf = NULL;
+		kfree(slot->msg);
+		slot->msg = NULL;
+	}
 	dw->msg_queue_buf = NULL;
-	kfree(dw->msg_queue);
 	dw->msg_queue = NULL;
 }
 
@@ -6963,6 +7953,8 @@ void dw3000_transfers_free(struct dw3000 *dw)
  */
 int dw3000_transfers_init(struct dw3000 *dw)
 {
+	int i;
+
 	/* fast command message, only one transfer */
 	dw->msg_fast_command = dw3000_alloc_prepare_fastcmd();
 	if (!dw->msg_fast_command)
@@ -7019,6 +8011,10 @@ int dw3000_transfers_init(struct dw3000 *dw)
 		dw, DW3000_SPI_COLLISION_STATUS_ID, 0, 1, DW3000_SPI_WR_BIT);
 	if (!dw->msg_write_spi_collision_status)
 		goto alloc_err;
+	/* ISR RX fast path message */
+	dw->msg_read_rx_fastpath = dw3000_alloc_prepare_rx_fastpath(dw);
+	if (!dw->msg_read_rx_fastpath)
+		goto alloc_err;
 	/* generic read/write full-duplex message */
 	dw->msg_readwrite_fdx =
 		dw3000_alloc_prepare_xfer(dw, 0, 0, 16, DW3000_SPI_RD_BIT);
@@ -7026,14 +8022,28 @@ int dw3000_transfers_init(struct dw3000 *dw)
 		goto alloc_err;
 	/* mutex protecting msg_readwrite_fdx */
 	mutex_init(&dw->msg_mutex);
-	/* message queue */
-	dw->msg_queue_buf = kzalloc(DW3000_QUEUED_SPI_BUFFER_SZ, GFP_KERNEL);
-	if (!dw->msg_queue_buf)
-		goto alloc_err;
-	dw->msg_queue = kzalloc(sizeof(struct spi_message) +
-					DW3000_MAX_QUEUED_SPI_XFER *
-						sizeof(struct spi_transfer),
-				GFP_KERNEL);
+	/* message queues, one per asynchronous engine slot */
+	init_waitqueue_head(&dw->spi_async.wq);
+	for (i = 0; i < DW3000_SPI_QUEUE_SLOTS; i++) {
+		struct dw3000_spi_queue_slot *slot = &dw->spi_async.slots[i];
+
+		slot->dw = dw;
+		atomic_set(&slot->busy, 0);
+		slot->buf = kzalloc(DW3000_QUEUED_SPI_BUFFER_SZ, GFP_KERNEL);
+		if (!slot->buf)
+			goto alloc_err;
+		slot->msg = kzalloc(sizeof(struct spi_message) +
+					    DW3000_MAX_QUEUED_SPI_XFER *
+						    sizeof(struct spi_transfer),
+				    GFP_KERNEL);
+		if (!slot->msg)
+			goto alloc_err;
+	}
+	dw->spi_async.slot_idx = 0;
+	atomic_set(&dw->spi_async.inflight, 0);
+	atomic_set(&dw->spi_async.status, 0);
+	dw->msg_queue = dw->spi_async.slots[0].msg;
+	dw->msg_queue_buf = dw->spi_async.slots[0].buf;
 	return 0;
 
 alloc_err:
@@ -7308,6 +8318,152 @@ void dw3000_init_config(struct dw3000 *dw)
 
 	/* Initialize dw3000_rx spinlock */
 	spin_lock_init(&dw->rx.lock);
+	/* Initialize RX socket buffers pool */
+	dw3000_rx_skb_pool_init(dw);
+}
+
+/**
+ * dw3000_wakeup_restore_static() - Queue registers restore depending only on
+ * configuration and calibration
+ * @dw: the DW device
+ *
+ * Called to build the wake-up restore program, which is saved and replayed
+ * until dw3000_wakeup_restore_invalidate() is called.
+ *
+ * Return: zero on success, else a negative error code.
+ */
+static int dw3000_wakeup_restore_static(struct dw3000 *dw)
+{
+	int rc;
+
+	/* DGC LUT, if not needed before ADC offset calibration */
+	if (!dw->chip_ops->adc_offset_calibration) {
+		rc = dw3000_restore_dgc(dw);
+		if (rc)
+			return rc;
+	}
+	/* WiFi coexistence initialisation */
+	rc = dw3000_coex_init(dw);
+	if (rc)
+		return rc;
+	/* Configure antenna selection GPIO if any */
+	rc = dw3000_config_antenna_gpios(dw);
+	if (rc)
+		return rc;
+	/* Select the events that will generate an interruption */
+	rc = dw3000_set_interrupt(dw, DW3000_SYS_STATUS_TRX,
+				  DW3000_ENABLE_INT_ONLY);
+	if (rc)
+		return rc;
+	/* TODO: So, just add below this line more required unsaved registers
+	 * setup. */
+	return dw3000_reg_write32(dw, DW3000_LDO_VOUT_ID, 0, DW3000_RF_LDO_VOUT);
+}
+
+/**
+ * dw3000_wakeup_restore_ant_gpios() - Get antenna selection GPIOs
+ * @dw: the DW device
+ *
+ * Return: bitmap of GPIOs configured by dw3000_config_antenna_gpios().
+ */
+static u16 dw3000_wakeup_restore_ant_gpios(struct dw3000 *dw)
+{
+	u16 gpios = 0;
+	int i;
+
+	for (i = 0; i < DW3000_CALIBRATION_ANTENNA_MAX; i++) {
+		u8 selector = dw->calib_data.ant[i].selector_gpio;
+
+		if (selector < DW3000_GPIO_COUNT)
+			gpios |= BIT(selector);
+	}
+	return gpios;
+}
+
+/**
+ * dw3000_wakeup_restore() - Restore registers after DEEP SLEEP and PLL lock
+ * @dw: the DW device
+ *
+ * The AON memory was copied to register, so only STS & AES keys and some
+ * others non saved register need to be re-initialised.
+ *
+ * Registers depending only on configuration and calibration are written by a
+ * saved SPI program, recorded on first wake-up and after invalidation. It is
+ * only replayed if the channel, preamble code and GPIOs it configures are the
+ * same, as the WiFi coexistence GPIO may be changed at runtime. It is sent
+ * with the address filter and STS key in a single SPI message. When the chip
+ * needs an ADC offset calibration, DGC is restored before it in its own
+ * message.
+ *
+ * Return: zero on success, else a negative error code.
+ */
+static int dw3000_wakeup_restore(struct dw3000 *dw)
+{
+	struct dw3000_wakeup_restore *wr = &dw->wakeup_restore;
+	struct dw3000_config *config = &dw->config;
+	u16 ant_gpios;
+	int rc;
+
+	if (dw->chip_ops->adc_offset_calibration) {
+		/* DGC LUT */
+		dw3000_spi_queue_start(dw);
+		rc = dw3000_restore_dgc(dw);
+		if (rc)
+			return dw3000_spi_queue_reset(dw, rc);
+		rc = dw3000_spi_queue_flush(dw);
+		if (rc)
+			return rc;
+		/* Calibrate ADC offset after DGC configuration and after PLL
+		 * lock. If this calibration is executed before the PLL lock,
+		 * the PLL lock failed. */
+		rc = dw->chip_ops->adc_offset_calibration(dw);
+		if (rc)
+			return rc;
+	}
+
+	ant_gpios = dw3000_wakeup_restore_ant_gpios(dw);
+	dw3000_spi_queue_start(dw);
+	if (wr->prog.valid && wr->chan == config->chan &&
+	    wr->rx_code == config->rxCode && wr->coex_gpio == dw->coex_gpio &&
+	    wr->ant_gpios == ant_gpios) {
+		rc = dw3000_spi_queue_program(dw, &wr->prog);
+	} else {
+		rc = dw3000_wakeup_restore_static(dw);
+		/* Without queue, functions are called again next time */
+		if (!rc && !dw3000_spi_queue_save(dw, &wr->prog)) {
+			wr->chan = config->chan;
+			wr->rx_code = config->rxCode;
+			wr->coex_gpio = dw->coex_gpio;
+			wr->ant_gpios = ant_gpios;
+		}
+	}
+	if (rc)
+		return dw3000_spi_queue_reset(dw, rc);
+	/* Reset cached antenna config to ensure GPIO are well reconfigured */
+	config->ant[0] = -1;
+	config->ant[1] = -1;
+
+	rc = dw3000_reconfigure_hw_addr_filt(dw);
+	if (rc)
+		return dw3000_spi_queue_reset(dw, rc);
+
+	if ((config->stsMode & DW3000_STS_BASIC_MODES_MASK) &&
+	    !(config->stsMode & DW3000_STS_MODE_SDC)) {
+		/* Resend key non-NUL STS KEY */
+		__le64 swapped_key[AES_KEYSIZE_128 / sizeof(__le64)];
+		_swap128(swapped_key, dw->data.sts_key);
+		rc = _dw3000_reg_write(dw, DW3000_STS_KEY_ID, 0,
+				       AES_KEYSIZE_128, swapped_key);
+		if (rc)
+			return dw3000_spi_queue_reset(dw, rc);
+	} else {
+		/* STS wasn't activate before entering DEEP-SLEEP, invalidate
+		   STS key to ensure it is resent to the chip the next time it
+		   is changed by MCPS. */
+		memset(dw->data.sts_key, 0, AES_KEYSIZE_128);
+		config->stsMode |= DW3000_STS_MODE_SDC;
+	}
+	return dw3000_spi_queue_flush(dw);
 }
 
 static inline int dw3000_isr_handle_spi_ready(struct dw3000 *dw,
@@ -7315,6 +8471,7 @@ static inline int dw3000_isr_handle_spi_ready(struct dw3000 *dw,
 {
 	struct dw3000_deep_sleep_state *dss = &dw->deep_sleep_state;
 	const dw3000_wakeup_done_cb wakeup_done_cb = dw->wakeup_done_cb;
+	u64 wakeup_ns;
 	int rc;
 
 	if (dw->current_operational_state != DW3000_OP_STATE_WAKE_UP) {
@@ -7364,7 +8521,7 @@ static inline int dw3000_isr_handle_spi_ready(struct dw3000 *dw,
 		else
 			rc = 0; /* remove uninit variable error */
 		if (rc)
-			return rc;
+			goto wakeup_failed;
 		dss->config_changed &=
 			~(DW3000_CHANNEL_CHANGED | DW3000_PCODE_CHANGED);
 		/* TODO: If channel is changed, the ongoing automatic PLL
@@ -7380,27 +8537,27 @@ static inline int dw3000_isr_handle_spi_ready(struct dw3000 *dw,
 			dw, !(dss->config_changed &
 			      DW3000_PREAMBLE_LENGTH_CHANGED));
 		if (rc)
-			return rc;
+			goto wakeup_failed;
 	}
 
 	/* SFD was changed during DEEP-SLEEP. */
 	if (dss->config_changed & DW3000_SFD_CHANGED) {
 		rc = dw3000_configure_sfd_type(dw);
 		if (rc)
-			return rc;
+			goto wakeup_failed;
 	}
 
 	/* PHR rate was changed during DEEP-SLEEP. */
 	if (dss->config_changed & DW3000_PHR_RATE_CHANGED) {
 		rc = dw3000_configure_phr_rate(dw);
 		if (rc)
-			return rc;
+			goto wakeup_failed;
 	}
 
 	/* Auto calibrate the PLL and change to IDLE_PLL state */
 	rc = dw3000_lock_pll(dw, isr->status);
 	if (rc)
-		return rc;
+		goto wakeup_failed;
 
 	/* Trace Wakeup after DTU/SYS_TIME resync */
 	{
@@ -7420,65 +8577,14 @@ static inline int dw3000_isr_handle_spi_ready(struct dw3000 *dw,
 	/* PGF calibration */
 	rc = dw3000_pgf_cal(dw, 1);
 	if (rc)
-		return rc;
-	/* DGC LUT */
-	rc = dw3000_restore_dgc(dw);
-	if (rc)
-		return rc;
-	/* Calibrate ADC offset, if needed, after DGC configuration and after PLL lock.
-	 * If this calibration is executed before the PLL lock, the PLL lock failed.
-	 */
-	if (dw->chip_ops->adc_offset_calibration) {
-		rc = dw->chip_ops->adc_offset_calibration(dw);
-		if (rc)
-			goto setuperror;
-	}
-	/* WiFi coexistence initialisation */
-	rc = dw3000_coex_init(dw);
-	if (rc)
-		goto setuperror;
-	/* Configure antenna selection GPIO if any */
-	rc = dw3000_config_antenna_gpios(dw);
-	if (rc)
-		goto setuperror;
-	/* Reset cached antenna config to ensure GPIO are well reconfigured */
-	dw->config.ant[0] = -1;
-	dw->config.ant[1] = -1;
-
-	/* Select the events that will generate an interruption */
-	rc = dw3000_set_interrupt(dw, DW3000_SYS_STATUS_TRX,
-				  DW3000_ENABLE_INT_ONLY);
-	if (rc)
-		goto setuperror;
-
-	rc = dw3000_reconfigure_hw_addr_filt(dw);
+		goto wakeup_failed;
+	/* Restore all others registers */
+	rc = dw3000_wakeup_restore(dw);
 	if (rc)
-		goto setuperror;
-
-	if ((dw->config.stsMode & DW3000_STS_BASIC_MODES_MASK) &&
-	    !(dw->config.stsMode & DW3000_STS_MODE_SDC)) {
-		/* Resend key non-NUL STS KEY */
-		__le64 swapped_key[AES_KEYSIZE_128 / sizeof(__le64)];
-		_swap128(swapped_key, dw->data.sts_key);
-		rc = _dw3000_reg_write(dw, DW3000_STS_KEY_ID, 0,
-				       AES_KEYSIZE_128, swapped_key);
-		if (rc)
-			goto setuperror;
-	} else {
-		/* STS wasn't activate before entering DEEP-SLEEP, invalidate
-		   STS key to ensure it is resent to the chip the next time it
-		   is changed by MCPS. */
-		memset(dw->data.sts_key, 0, AES_KEYSIZE_128);
-		dw->config.stsMode |= DW3000_STS_MODE_SDC;
-	}
-
-	/* TODO: So, just add below this line more required unsaved registers
-	 * setup. */
-	 rc = dw3000_reg_write32(dw, DW3000_LDO_VOUT_ID, 0, DW3000_RF_LDO_VOUT);
-	 if (rc)
-		 return rc;
+		goto wakeup_failed;
+	/* Chip is ready for TX/RX */
+	wakeup_ns = dw3000_power_stats_wakeup_done(dw);
 
-setuperror:
 #ifdef CONFIG_DW3000_DEBUG
 	/* Read and check configuration */
 	rc = dw3000_backup_registers(dw, true);
@@ -7490,6 +8596,7 @@ setuperror:
 		dw->wakeup_done_cb = NULL;
 		rc = wakeup_done_cb(dw);
 		if (rc == -ETIME) {
+			dw->power.wakeup_late++;
 			if (wakeup_done_cb == dw3000_wakeup_done_to_tx)
 				mcps802154_tx_too_late(dw->llhw);
 			else
@@ -7498,6 +8605,13 @@ setuperror:
 			rc = 0;
 		}
 	}
+	/* Learn from this wake-up once the pending TX/RX is programmed */
+	dw3000_wakeup_latency_update(dw, wakeup_ns);
+	return rc;
+
+wakeup_failed:
+	/* Failed wake-up isn't measured */
+	dw3000_power_stats_wakeup_cancel(dw);
 	return rc;
 }
 
@@ -7597,11 +8711,13 @@ static inline int dw3000_isr_handle_rx_call_handler(struct dw3000 *dw,
 	/* In case of automatic ack reply. */
 	if (isr->status & DW3000_SYS_STATUS_AAT_BIT_MASK)
 		isr->rx_flags |= DW3000_RX_FLAG_AACK;
-	/* Read frame timestamp */
-	rc = dw3000_read_rx_timestamp(dw, &isr->ts_rctu);
-	if (unlikely(rc))
-		return rc;
-	isr->rx_flags |= DW3000_RX_FLAG_TS; /* don't read it again later */
+	/* Read frame timestamp, if not already done by RX fast path */
+	if (!(isr->rx_flags & DW3000_RX_FLAG_TS)) {
+		rc = dw3000_read_rx_timestamp(dw, &isr->ts_rctu);
+		if (unlikely(rc))
+			return rc;
+		isr->rx_flags |= DW3000_RX_FLAG_TS; /* don't read it again later */
+	}
 	eof_dtu = dw3000_sys_time_rctu_to_dtu(dw, isr->ts_rctu) +
 		  dw3000_frame_duration_dtu(dw, isr->datalength, false);
 	/* Update power statistics */
@@ -7623,22 +8739,27 @@ static inline int dw3000_isr_handle_rxfcg_event(struct dw3000 *dw,
 	u16 finfo16;
 	int rc;
 
-	/* Read frame info, only the first two bytes of the register are used
-	   here. */
-	rc = dw3000_read_frame_info16(dw, dw->data.dblbuffon, &finfo16);
-	if (unlikely(rc)) {
-		dev_err(dw->dev, "could not read the frame info : %d\n", rc);
-		return rc;
+	if (isr->rx_flags & DW3000_RX_FLAG_TS) {
+		/* Frame info already read by RX fast path */
+		finfo16 = isr->finfo16;
+	} else {
+		/* Read frame info, only the first two bytes of the register
+		   are used here. */
+		rc = dw3000_read_frame_info16(dw, dw->data.dblbuffon, &finfo16);
+		if (unlikely(rc)) {
+			dev_err(dw->dev, "could not read the frame info : %d\n",
+				rc);
+			return rc;
+		}
 	}
 	/* Report frame length, standard frame length up to 127, extended frame
 	   length up to 1023 bytes */
 	isr->datalength =
 		(finfo16 & dw->data.max_frames_len) - IEEE802154_FCS_LEN;
-	/* Report ranging bit */
+	/* Report ranging bit, keeping timestamp flag */
+	isr->rx_flags &= DW3000_RX_FLAG_TS;
 	if (finfo16 & DW3000_RX_FINFO_RNG_BIT_MASK)
-		isr->rx_flags = DW3000_RX_FLAG_RNG;
-	else
-		isr->rx_flags = 0;
+		isr->rx_flags |= DW3000_RX_FLAG_RNG;
 	rc = dw3000_isr_handle_rx_call_handler(dw, isr);
 	/* Clear errors (as we do not want to go back into cbRxErr) */
 	isr->status &= ~clear;
@@ -7747,6 +8868,7 @@ static inline int dw3000_isr_handle_tx_event(struct dw3000 *dw,
 							  DW3000_DTU_PER_DLY);
 	}
 	/* Report completion to MCPS 802.15.4 stack */
+	dw3000_lat_stats_tx_done(dw);
 	mcps802154_tx_done(dw->llhw);
 	/* Clear TXFRS status to not handle it a second time. */
 	isr->status &= ~DW3000_SYS_STATUS_TXFRS_BIT_MASK;
@@ -7769,10 +8891,35 @@ static inline int dw3000_clear_db_events(struct dw3000 *dw)
 	return 0;
 }
 
+/**
+ * dw3000_isr_use_rx_fastpath() - Check if ISR RX fast path can be used
+ * @dw: the DW device
+ *
+ * Frame info and timestamp are read speculatively with the status register
+ * only when a frame is expected: while in RX, or while in TX with W4R
+ * configured, as the TX done event may be reported with the response frame
+ * and the power state only switches to RX in the TX event handler. Double
+ * buffer mode needs RDB status first to select registers, and NFCC
+ * coexistence needs DSS status, so the generic path is used for them.
+ *
+ * Return: true if RX fast path must be used.
+ */
+static inline bool dw3000_isr_use_rx_fastpath(struct dw3000 *dw)
+{
+	int state = dw->power.cur_state;
+
+	return dw->data.dblbuffon == DW3000_DBL_BUFF_OFF &&
+	       !dw->nfcc_coex.enabled &&
+	       (state == DW3000_PWR_RX ||
+		(state == DW3000_PWR_TX && dw->data.w4r_time));
+}
+
 void dw3000_isr(struct dw3000 *dw)
 {
 	struct dw3000_local_data *local = &dw->data;
 	struct dw3000_isr_data isr; /* in-stack */
+	__le64 raw_status;
+	u8 status_db = 0;
 	int rc = 0;
 	bool stsnd = ((dw->config.stsMode & DW3000_STS_BASIC_MODES_MASK) ==
 		      DW3000_STS_MODE_ND);
@@ -7783,28 +8930,54 @@ void dw3000_isr(struct dw3000 *dw)
 		return;
 	}
 
-	/* Read status register(64bits). */
-	rc = dw3000_read_all_sys_status(dw, &isr.status);
+	isr.rx_flags = 0;
+	if (dw3000_isr_use_rx_fastpath(dw)) {
+		/* A frame is expected: read status register, frame info and
+		   timestamp in a single SPI message. */
+		rc = dw3000_read_rx_fastpath(dw, &isr);
+		if (rc)
+			goto spi_err;
+		trace_dw3000_isr(dw, isr.status);
+		goto clear_status;
+	}
+	/* Read status register(64bits), DSS and RDB status registers in a
+	   single SPI message. */
+	dw3000_spi_queue_start(dw);
+	rc = dw3000_spi_queue_read(dw, DW3000_SYS_STATUS_ID, 0,
+				   sizeof(raw_status), &raw_status);
+	if (!rc && dw->nfcc_coex.enabled)
+		rc = dw3000_spi_queue_read(dw, DW3000_DSS_STAT_ID, 0,
+					   sizeof(isr.dss_stat), &isr.dss_stat);
+	if (!rc && local->dblbuffon)
+		rc = dw3000_spi_queue_read(dw, DW3000_RDB_STATUS_ID, 0,
+					   sizeof(status_db), &status_db);
+	if (rc) {
+		dw3000_spi_queue_reset(dw, rc);
+		goto spi_err;
+	}
+	rc = dw3000_spi_queue_flush(dw);
 	if (rc)
 		goto spi_err;
+	isr.status = le64_to_cpu(raw_status);
 	trace_dw3000_isr(dw, isr.status);
-	if (dw->nfcc_coex.enabled) {
-		rc = dw3000_read_dss_status(dw, &isr.dss_stat);
-		if (rc)
-			goto spi_err;
+	if (dw->nfcc_coex.enabled)
 		trace_dw3000_isr_dss_stat(dw, isr.dss_stat);
-	}
-	/* Early clear all status bits since saved locally */
+clear_status:
+	dw3000_lat_stats_status(dw);
+	/* Early clear all status bits since saved locally. Don't wait for
+	   completion, next SPI transfers are executed after this one. */
+	dw3000_spi_queue_start(dw);
 	rc = dw3000_clear_all_sys_status(dw, isr.status);
+	if (rc) {
+		dw3000_spi_queue_reset(dw, rc);
+		goto spi_err;
+	}
+	rc = dw3000_spi_queue_flush_async(dw, NULL, NULL);
 	if (rc)
 		goto spi_err;
 	/* RX double-buffering enabled */
 	if (local->dblbuffon) {
-		u8 status_db;
-		/* RDB status register */
-		rc = dw3000_read_rdb_status(dw, &status_db);
-		if (rc)
-			goto spi_err;
+		/* RDB status register was read with SYS_STATUS */
 		/*
 		 * If accessing the second buffer (RX_BUFFER_B then read second
 		 * nibble of the DB status reg)
@@ -7930,10 +9103,16 @@ void dw3000_isr(struct dw3000 *dw)
 			goto spi_err;
 	}
 
+	/* Collect status of asynchronous transfers */
+	rc = dw3000_spi_async_wait(dw);
+	if (unlikely(rc))
+		goto spi_err;
+
 	trace_dw3000_return_int(dw, 0);
 	return;
 
 spi_err:
+	dw3000_spi_async_wait(dw);
 	mcps802154_broken(dw->llhw);
 	/* TODO: handle SPI error */
 	trace_dw3000_return_int(dw, rc);
@@ -8122,7 +9301,10 @@ static ssize_t dw3000_sysfs_show(struct kobject *kobj,
 			"Idle state:\n\tcount:\t%llu\n\tdur ns:\t%llu\n"
 			"Tx state:\n\tcount:\t%llu\n\tdur ns:\t%llu\n"
 			"Rx state:\n\tcount:\t%llu\n\tdur ns:\t%llu\n"
-			"Interrupts:\n\tcount:\t%lld\n",
+			"Interrupts:\n\tcount:\t%lld\n"
+			"Wake-up to ready:\n\tcount:\t%llu\n\tdur ns:\t%llu\n"
+			"\tmax ns:\t%llu\n\tlatency us:\t%d\n\tlate:\t%llu\n"
+			"Deep sleep missed:\n\tcount:\t%llu\n",
 			dw->power.stats[DW3000_PWR_OFF].count,
 			dw->power.stats[DW3000_PWR_OFF].dur,
 			dw->power.stats[DW3000_PWR_DEEPSLEEP].count,
@@ -8132,7 +9314,10 @@ static ssize_t dw3000_sysfs_show(struct kobject *kobj,
 			dw->power.stats[DW3000_PWR_IDLE].count, idle_dur,
 			dw->power.stats[DW3000_PWR_TX].count, tx_ns,
 			dw->power.stats[DW3000_PWR_RX].count, rx_ns,
-			(s64)atomic64_read(&dw->power.interrupts));
+			(s64)atomic64_read(&dw->power.interrupts),
+			dw->power.wakeup.count, dw->power.wakeup.dur,
+			dw->power.wakeup_max, dw3000_wakeup_latency_us(dw),
+			dw->power.wakeup_late, dw->power.sleep_missed);
 	return ret;
 }
 
@@ -8150,6 +9335,10 @@ static ssize_t dw3000_sysfs_store(struct kobject *kobj,
 		if (dw->power.cur_state > DW3000_PWR_RUN)
 			dw->power.stats[dw->power.cur_state].count = 1;
 		atomic64_set(&dw->power.interrupts, 0);
+		memset(&dw->power.wakeup, 0, sizeof(dw->power.wakeup));
+		dw->power.wakeup_max = 0;
+		dw->power.wakeup_late = 0;
+		dw->power.sleep_missed = 0;
 	}
 	return length;
 }
@@ -30,8 +30,17 @@
 
 #define DW3000_GPIO_COUNT 9 /* GPIO0 to GPIO8 */
 
+/* Maximum PSDU length, FCS included, for standard and extended PHR */
+#define DW3000_STD_FRAME_LEN (127)
+#define DW3000_EXT_FRAME_LEN (1023)
+
 /* DW3000 wake-up latency. At least 2ms is required. */
 #define DW3000_WAKEUP_LATENCY_US 15000
+/* Learned wake-up latency: percentile of measured durations, safety margin
+   added to it, and minimum number of measures before it is used. */
+#define DW3000_WAKEUP_LATENCY_PERCENTILE 95
+#define DW3000_WAKEUP_LATENCY_GUARD_US 500
+#define DW3000_WAKEUP_LATENCY_MIN_SAMPLES (DW3000_WAKEUP_SAMPLES / 2)
 
 /* Define DW3000 PDOA modes */
 #define DW3000_PDOA_M0 0x0 /* PDOA mode is off */
@@ -275,6 +284,7 @@ enum spi_modes {
 	 DW3000_SYS_STATUS_TXFRS_BIT_MASK)
 
 void dw3000_init_config(struct dw3000 *dw);
+void dw3000_rx_skb_pool_free(struct dw3000 *dw);
 
 int dw3000_init(struct dw3000 *dw, bool check_idlerc);
 void dw3000_remove(struct dw3000 *dw);
@@ -303,8 +313,26 @@ int dw3000_setup_regulator_delay(struct dw3000 *dw);
 
 void dw3000_spi_queue_start(struct dw3000 *dw);
 int dw3000_spi_queue_flush(struct dw3000 *dw);
+int dw3000_spi_queue_flush_async(struct dw3000 *dw, dw3000_spi_async_cb cb,
+				 void *arg);
+int dw3000_spi_async_wait(struct dw3000 *dw);
+int dw3000_spi_queue_read(struct dw3000 *dw, u32 reg_fileid, u16 index,
+			  u16 length, void *buffer);
 int dw3000_spi_queue_reset(struct dw3000 *dw, int rc);
 
+/**
+ * dw3000_wakeup_restore_invalidate() - Rebuild registers restore on wake-up
+ * @dw: the DW device
+ *
+ * Must be called when calibration data used by the saved restore program may
+ * have changed. Channel, preamble code, WiFi coexistence GPIO and antenna
+ * selection GPIOs changes are detected on wake-up.
+ */
+static inline void dw3000_wakeup_restore_invalidate(struct dw3000 *dw)
+{
+	dw->wakeup_restore.prog.valid = false;
+}
+
 int dw3000_reg_read_fast(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
 			 u16 length, void *buffer);
 int dw3000_reg_read32(struct dw3000 *dw, u32 reg_fileid, u16 reg_offset,
@@ -413,6 +441,8 @@ struct mcps802154_tx_frame_config;
 int dw3000_do_tx_frame(struct dw3000 *dw,
 		       const struct mcps802154_tx_frame_config *config,
 		       struct sk_buff *skb, int frame_idx);
+int dw3000_do_tx_prepare_frame(struct dw3000 *dw, struct sk_buff *skb,
+			       int frame_idx);
 
 int dw3000_tx_setcwtone(struct dw3000 *dw, bool on);
 
@@ -458,6 +488,20 @@ int dw3000_deepsleep_wakeup_now(struct dw3000 *dw,
 				u32 timestamp_dtu,
 				enum operational_state next_operational_state);
 int dw3000_can_deep_sleep(struct dw3000 *dw, int delay_us);
+
+/**
+ * dw3000_wakeup_latency_us() - Get wake-up latency to anticipate
+ * @dw: the DW device
+ *
+ * Return: the latency learned from last wake-ups, or the default one if not
+ * enough wake-ups were measured yet.
+ */
+static inline int dw3000_wakeup_latency_us(struct dw3000 *dw)
+{
+	int latency_us = READ_ONCE(dw->power.wakeup_latency_us);
+
+	return latency_us ? latency_us : DW3000_WAKEUP_LATENCY_US;
+}
 int dw3000_trace_rssi_info(struct dw3000 *dw, u32 regid, char *chipver);
 
 int dw3000_testmode_continuous_tx_start(struct dw3000 *dw, u32 frame_length,
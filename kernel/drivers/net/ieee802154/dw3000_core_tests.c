@@ -495,6 +495,105 @@ static void dw3000_power_stats_test_rx(struct kunit *test)
 	KUNIT_EXPECT_EQ(test, 0ull, pwr->stats[DW3000_PWR_TX].dur);
 }
 
+static void dw3000_power_stats_test_wakeup(struct kunit *test)
+{
+	struct dw3000 *dw = kunit_kzalloc(test, sizeof(*dw), GFP_KERNEL);
+	struct dw3000_power *pwr = &dw->power;
+	u64 incr = 1000000;
+	/* Ensure allocation succeeded. */
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dw);
+	if (!dw)
+		return;
+	kunit_boot_time_ns = 0;
+
+	/* Only the first start is recorded. */
+	dw3000_power_stats_wakeup_start(dw);
+	KUNIT_EXPECT_EQ(test, incr, pwr->wakeup_start);
+	dw3000_power_stats_wakeup_start(dw);
+	KUNIT_EXPECT_EQ(test, incr, pwr->wakeup_start);
+	KUNIT_EXPECT_EQ(test, incr, dw3000_power_stats_wakeup_done(dw));
+	KUNIT_EXPECT_EQ(test, 0ull, pwr->wakeup_start);
+	KUNIT_EXPECT_EQ(test, 1ull, pwr->wakeup.count);
+	KUNIT_EXPECT_EQ(test, incr, pwr->wakeup.dur);
+	KUNIT_EXPECT_EQ(test, incr, pwr->wakeup_max);
+
+	/* A cancelled wake-up is not measured, next one has its own start. */
+	dw3000_power_stats_wakeup_start(dw);
+	dw3000_power_stats_wakeup_cancel(dw);
+	KUNIT_EXPECT_EQ(test, 0ull, pwr->wakeup_start);
+	dw3000_power_stats_wakeup_start(dw);
+	kunit_get_boottime_ns();
+	KUNIT_EXPECT_EQ(test, incr * 2, dw3000_power_stats_wakeup_done(dw));
+	KUNIT_EXPECT_EQ(test, 2ull, pwr->wakeup.count);
+	KUNIT_EXPECT_EQ(test, incr * 3, pwr->wakeup.dur);
+	KUNIT_EXPECT_EQ(test, incr * 2, pwr->wakeup_max);
+}
+
+static void dw3000_power_stats_test_sleep_missed(struct kunit *test)
+{
+	struct dw3000 *dw = kunit_kzalloc(test, sizeof(*dw), GFP_KERNEL);
+	struct dw3000_power *pwr = &dw->power;
+	/* Ensure allocation succeeded. */
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dw);
+	if (!dw)
+		return;
+
+	/* Default latency until learned. */
+	dw3000_sleep_missed(dw, DW3000_WAKEUP_LATENCY_US - 1);
+	KUNIT_EXPECT_EQ(test, 0ull, pwr->sleep_missed);
+	dw3000_sleep_missed(dw, DW3000_WAKEUP_LATENCY_US);
+	KUNIT_EXPECT_EQ(test, 1ull, pwr->sleep_missed);
+	/* Deep sleep isn't possible while ranging clock is needed. */
+	dw->need_ranging_clock = true;
+	dw3000_sleep_missed(dw, DW3000_WAKEUP_LATENCY_US * 2);
+	KUNIT_EXPECT_EQ(test, 1ull, pwr->sleep_missed);
+	/* Learned latency. */
+	dw->need_ranging_clock = false;
+	pwr->wakeup_latency_us = 3000;
+	dw3000_sleep_missed(dw, 2999);
+	KUNIT_EXPECT_EQ(test, 1ull, pwr->sleep_missed);
+	dw3000_sleep_missed(dw, 3000);
+	KUNIT_EXPECT_EQ(test, 2ull, pwr->sleep_missed);
+}
+
+static void dw3000_power_stats_test_wakeup_latency(struct kunit *test)
+{
+	struct dw3000 *dw = kunit_kzalloc(test, sizeof(*dw), GFP_KERNEL);
+	struct dw3000_power *pwr = &dw->power;
+	int guard_us = DW3000_WAKEUP_LATENCY_GUARD_US;
+	int i;
+	/* Ensure allocation succeeded. */
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, dw);
+	if (!dw)
+		return;
+
+	/* Not enough samples, default latency is used. */
+	for (i = 0; i < DW3000_WAKEUP_LATENCY_MIN_SAMPLES - 1; i++)
+		dw3000_wakeup_latency_update(dw, 2000000);
+	KUNIT_EXPECT_EQ(test, 0, pwr->wakeup_latency_us);
+	KUNIT_EXPECT_EQ(test, DW3000_WAKEUP_LATENCY_US,
+			dw3000_wakeup_latency_us(dw));
+	dw3000_wakeup_latency_update(dw, 2000000);
+	KUNIT_EXPECT_EQ(test, 2000 + guard_us, dw3000_wakeup_latency_us(dw));
+
+	/* 95th percentile of 32 samples is the second largest one. */
+	for (i = DW3000_WAKEUP_LATENCY_MIN_SAMPLES;
+	     i < DW3000_WAKEUP_SAMPLES - 2; i++)
+		dw3000_wakeup_latency_update(dw, 2000000);
+	dw3000_wakeup_latency_update(dw, 5000000);
+	dw3000_wakeup_latency_update(dw, 4000000);
+	KUNIT_EXPECT_EQ(test, DW3000_WAKEUP_SAMPLES, pwr->wakeup_sample_count);
+	KUNIT_EXPECT_EQ(test, 4000 + guard_us, dw3000_wakeup_latency_us(dw));
+
+	/* Long measures are clamped, and replace the oldest samples. */
+	dw3000_wakeup_latency_update(dw, 100000000);
+	dw3000_wakeup_latency_update(dw, 100000000);
+	KUNIT_EXPECT_EQ(test, 2u * DW3000_WAKEUP_LATENCY_US,
+			pwr->wakeup_samples_us[0]);
+	KUNIT_EXPECT_EQ(test, 2 * DW3000_WAKEUP_LATENCY_US + guard_us,
+			dw3000_wakeup_latency_us(dw));
+}
+
 static struct kunit_case dw3000_core_test_cases[] = {
 	KUNIT_CASE(dw3000_ktime_to_dtu_test_basic),
 	KUNIT_CASE(dw3000_dtu_to_ktime_test_basic),
@@ -504,6 +603,9 @@ static struct kunit_case dw3000_core_test_cases[] = {
 	KUNIT_CASE(dw3000_power_stats_test_basic),
 	KUNIT_CASE(dw3000_power_stats_test_tx),
 	KUNIT_CASE(dw3000_power_stats_test_rx),
+	KUNIT_CASE(dw3000_power_stats_test_wakeup),
+	KUNIT_CASE(dw3000_power_stats_test_sleep_missed),
+	KUNIT_CASE(dw3000_power_stats_test_wakeup_latency),
 	{}
 };
 
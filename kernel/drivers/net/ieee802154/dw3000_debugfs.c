@@ -23,6 +23,7 @@
 #include <linux/module.h>
 #include <linux/debugfs.h>
 #include <linux/string.h>
+#include <linux/math64.h>
 
 #include "dw3000.h"
 #include "dw3000_core.h"
@@ -234,12 +235,248 @@ static int dw3000_dbgfs_cir_config(struct file *filp, bool write, void *buffer,
 	return size;
 }
 
+/**
+ * dw3000_dbgfs_latency() - Dump or reset pipeline latency histograms
+ * @filp: debugfs file pointer associated to the virtual register
+ * @write: false means dump histograms, true means reset them
+ * @buffer: userland buffer, written value is ignored
+ * @size: buffer size
+ * @ppos: offset in opened file
+ *
+ * Each output line gives a stage name, the lower bound in ns of a log2
+ * bucket and the number of measures in this bucket, summed over all CPUs.
+ * Empty buckets are not displayed.
+ *
+ * Return: a negative error code or the size written or readed from buffer
+ */
+static int dw3000_dbgfs_latency(struct file *filp, bool write, void *buffer,
+				size_t size, loff_t *ppos)
+{
+	static const char *const stage_names[DW3000_LAT_MAX] = {
+		[DW3000_LAT_IRQ_TO_THREAD] = "irq_to_thread",
+		[DW3000_LAT_THREAD_TO_STATUS] = "thread_to_status",
+		[DW3000_LAT_STATUS_TO_MCPS] = "status_to_mcps",
+		[DW3000_LAT_TX_TO_TXFRS] = "tx_to_txfrs",
+	};
+	struct dw3000_debugfs_file *dbgfs_file = filp->private_data;
+	struct dw3000_chip_register_priv *crp = &dbgfs_file->chip_reg_priv;
+	struct dw3000 *dw = crp->dw;
+	char *cbuf;
+	int stage, bucket, cpu;
+	int r = 0;
+
+	if (!dw->lat.hist)
+		return 0;
+
+	if (write) {
+		for_each_possible_cpu (cpu)
+			memset(per_cpu_ptr(dw->lat.hist, cpu), 0,
+			       sizeof(struct dw3000_lat_hist));
+		*ppos += size;
+		return size;
+	}
+
+	if (*ppos > 0)
+		return 0;
+
+	cbuf = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!cbuf)
+		return -ENOMEM;
+	for (stage = 0; stage < DW3000_LAT_MAX; stage++) {
+		for (bucket = 0; bucket < DW3000_LAT_BUCKETS; bucket++) {
+			u64 count = 0;
+
+			for_each_possible_cpu (cpu)
+				count += per_cpu_ptr(dw->lat.hist, cpu)
+						 ->count[stage][bucket];
+			if (!count)
+				continue;
+			r += scnprintf(cbuf + r, PAGE_SIZE - r, "%s %llu %llu\n",
+				       stage_names[stage],
+				       bucket ? 1ull << bucket : 0ull, count);
+		}
+	}
+	r = min_t(size_t, r, size);
+	if (copy_to_user(buffer, cbuf, r)) {
+		dev_err(dw->dev, "impossible to copy data to userland");
+		kfree(cbuf);
+		return -EFAULT;
+	}
+	kfree(cbuf);
+	*ppos += r;
+	return r;
+}
+
+/**
+ * dw3000_dbgfs_rx_skb_pool() - Dump RX socket buffers pool status
+ * @filp: debugfs file pointer associated to the virtual register
+ * @write: unused, register is read-only
+ * @buffer: userland buffer to fill
+ * @size: buffer size
+ * @ppos: offset in opened file
+ *
+ * Return: a negative error code or the size readed from buffer
+ */
+static int dw3000_dbgfs_rx_skb_pool(struct file *filp, bool write,
+				    void *buffer, size_t size, loff_t *ppos)
+{
+	struct dw3000_debugfs_file *dbgfs_file = filp->private_data;
+	struct dw3000_chip_register_priv *crp = &dbgfs_file->chip_reg_priv;
+	struct dw3000 *dw = crp->dw;
+	struct dw3000_rx_skb_pool *pool = &dw->rx.pool;
+	char cbuf[64];
+	int r;
+
+	if (*ppos > 0)
+		return 0;
+
+	r = scnprintf(cbuf, sizeof(cbuf), "size %u available %u exhausted %llu\n",
+		      DW3000_RX_SKB_POOL_SIZE, skb_queue_len(&pool->skbs),
+		      (u64)atomic64_read(&pool->exhausted));
+	r = min_t(size_t, r, size);
+	if (copy_to_user(buffer, cbuf, r)) {
+		dev_err(dw->dev, "impossible to copy data to userland");
+		return -EFAULT;
+	}
+	*ppos += r;
+	return r;
+}
+
+/**
+ * dw3000_dbgfs_stm_queue() - Dump state machine commands ring statistics
+ * @filp: debugfs file pointer associated to the virtual register
+ * @write: unused, register is read-only
+ * @buffer: userland buffer to fill
+ * @size: buffer size
+ * @ppos: offset in opened file
+ *
+ * Return: a negative error code or the size readed from buffer
+ */
+static int dw3000_dbgfs_stm_queue(struct file *filp, bool write, void *buffer,
+				  size_t size, loff_t *ppos)
+{
+	struct dw3000_debugfs_file *dbgfs_file = filp->private_data;
+	struct dw3000_chip_register_priv *crp = &dbgfs_file->chip_reg_priv;
+	struct dw3000 *dw = crp->dw;
+	struct dw3000_stm_stats stats;
+	unsigned int occupancy;
+	char cbuf[256];
+	int r;
+
+	if (*ppos > 0)
+		return 0;
+
+	dw3000_get_stm_stats(dw, &stats, &occupancy);
+	r = scnprintf(cbuf, sizeof(cbuf),
+		      "occupancy %u max_occupancy %u size %u\n"
+		      "executed %llu wait_avg_ns %llu wait_max_ns %llu\n"
+		      "full_waits %llu timer_dropped %llu\n",
+		      occupancy, stats.max_occupancy, DW3000_STM_RING_SIZE,
+		      stats.executed,
+		      stats.executed ?
+			      div64_u64(stats.wait_total_ns, stats.executed) :
+			      0,
+		      stats.wait_max_ns, stats.full_waits,
+		      stats.timer_dropped);
+	r = min_t(size_t, r, size);
+	if (copy_to_user(buffer, cbuf, r)) {
+		dev_err(dw->dev, "impossible to copy data to userland");
+		return -EFAULT;
+	}
+	*ppos += r;
+	return r;
+}
+
+/**
+ * dw3000_dbgfs_reg_cache() - Dump shadow registers cache statistics
+ * @filp: debugfs file pointer associated to the virtual register
+ * @write: unused, register is read-only
+ * @buffer: userland buffer to fill
+ * @size: buffer size
+ * @ppos: offset in opened file
+ *
+ * Return: a negative error code or the size readed from buffer
+ */
+static int dw3000_dbgfs_reg_cache(struct file *filp, bool write, void *buffer,
+				  size_t size, loff_t *ppos)
+{
+	struct dw3000_debugfs_file *dbgfs_file = filp->private_data;
+	struct dw3000_chip_register_priv *crp = &dbgfs_file->chip_reg_priv;
+	struct dw3000 *dw = crp->dw;
+	struct dw3000_reg_cache *cache = &dw->reg_cache;
+	char cbuf[128];
+	int r;
+
+	if (*ppos > 0)
+		return 0;
+
+	mutex_lock(&dw->msg_mutex);
+	r = scnprintf(cbuf, sizeof(cbuf),
+		      "registers %d valid %u\n"
+		      "hits %llu misses %llu elided %llu writes %llu\n",
+		      cache->count, hweight_long(cache->valid), cache->hits,
+		      cache->misses, cache->elided, cache->writes);
+	mutex_unlock(&dw->msg_mutex);
+	r = min_t(size_t, r, size);
+	if (copy_to_user(buffer, cbuf, r)) {
+		dev_err(dw->dev, "impossible to copy data to userland");
+		return -EFAULT;
+	}
+	*ppos += r;
+	return r;
+}
+
+/**
+ * dw3000_dbgfs_txpower_memo() - Dump smart TX power memo statistics
+ * @filp: debugfs file pointer associated to the virtual register
+ * @write: unused, register is read-only
+ * @buffer: userland buffer to fill
+ * @size: buffer size
+ * @ppos: offset in opened file
+ *
+ * Return: a negative error code or the size readed from buffer
+ */
+static int dw3000_dbgfs_txpower_memo(struct file *filp, bool write,
+				     void *buffer, size_t size, loff_t *ppos)
+{
+	struct dw3000_debugfs_file *dbgfs_file = filp->private_data;
+	struct dw3000_chip_register_priv *crp = &dbgfs_file->chip_reg_priv;
+	struct dw3000 *dw = crp->dw;
+	struct dw3000_txpower_memo *memo = &dw->txpower_memo;
+	char cbuf[128];
+	int r;
+
+	if (*ppos > 0)
+		return 0;
+
+	r = scnprintf(cbuf, sizeof(cbuf),
+		      "entries %d valid %u\nhits %llu misses %llu\n",
+		      DW3000_TXPOWER_MEMO_SIZE, hweight_long(memo->valid),
+		      memo->hits, memo->misses);
+	r = min_t(size_t, r, size);
+	if (copy_to_user(buffer, cbuf, r)) {
+		dev_err(dw->dev, "impossible to copy data to userland");
+		return -EFAULT;
+	}
+	*ppos += r;
+	return r;
+}
+
 static const struct dw3000_chip_register virtual_registers[] = {
 	{ "power", 0x0, 0x0, 0x0, DW3000_CHIPREG_PERM, dw3000_dbgfs_power },
 	{ "cir_data", 0x0, 0x0, 0x0,
 	  DW3000_CHIPREG_RO | DW3000_CHIPREG_OPENONCE, dw3000_dbgfs_cir_data },
 	{ "cir_config", 0x0, 0x0, 0x0, DW3000_CHIPREG_PERM,
 	  dw3000_dbgfs_cir_config },
+	{ "latency", 0x0, 0x0, 0x0, DW3000_CHIPREG_PERM, dw3000_dbgfs_latency },
+	{ "rx_skb_pool", 0x0, 0x0, 0x0, DW3000_CHIPREG_RO | DW3000_CHIPREG_PERM,
+	  dw3000_dbgfs_rx_skb_pool },
+	{ "stm_queue", 0x0, 0x0, 0x0, DW3000_CHIPREG_RO | DW3000_CHIPREG_PERM,
+	  dw3000_dbgfs_stm_queue },
+	{ "reg_cache", 0x0, 0x0, 0x0, DW3000_CHIPREG_RO | DW3000_CHIPREG_PERM,
+	  dw3000_dbgfs_reg_cache },
+	{ "txpower_memo", 0x0, 0x0, 0x0, DW3000_CHIPREG_RO | DW3000_CHIPREG_PERM,
+	  dw3000_dbgfs_txpower_memo },
 };
 
 /** struct do_reg_xfer_params - parameters for spi register access
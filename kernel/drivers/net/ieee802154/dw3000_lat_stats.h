@@ -0,0 +1,164 @@
+/*
+ * This file is part of the UWB stack for linux.
+ *
+ * Copyright (c) 2021 Qorvo US, Inc.
+ *
+ * This software is provided under the GNU General Public License, version 2
+ * (GPLv2), as well as under a Qorvo commercial license.
+ *
+ * You may choose to use this software under the terms of the GPLv2 License,
+ * version 2 ("GPLv2"), as published by the Free Software Foundation.
+ * You should have received a copy of the GPLv2 along with this program.  If
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is distributed under the GPLv2 in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GPLv2 for more
+ * details.
+ *
+ * If you cannot meet the requirements of the GPLv2, you may not use this
+ * software for any purpose without first obtaining a commercial license from
+ * Qorvo. Please contact Qorvo to inquire about licensing terms.
+ */
+#ifndef __DW3000_LAT_STATS_H
+#define __DW3000_LAT_STATS_H
+
+#include <linux/percpu.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+
+#include "dw3000.h"
+
+/**
+ * dw3000_lat_stats_init() - Allocate latency statistics
+ * @dw: the DW device
+ *
+ * Return: zero on success, else a negative error code.
+ */
+static inline int dw3000_lat_stats_init(struct dw3000 *dw)
+{
+	dw->lat.hist = alloc_percpu(struct dw3000_lat_hist);
+	if (!dw->lat.hist)
+		return -ENOMEM;
+	atomic64_set(&dw->lat.irq_ns, 0);
+	dw->lat.thread_ns = 0;
+	dw->lat.status_ns = 0;
+	dw->lat.tx_ns = 0;
+	return 0;
+}
+
+/**
+ * dw3000_lat_stats_free() - Free latency statistics
+ * @dw: the DW device
+ */
+static inline void dw3000_lat_stats_free(struct dw3000 *dw)
+{
+	free_percpu(dw->lat.hist);
+	dw->lat.hist = NULL;
+}
+
+/**
+ * dw3000_lat_stats_record() - Account one stage latency
+ * @dw: the DW device
+ * @stage: the measured stage
+ * @start_ns: stage start date, zero if unknown
+ * @end_ns: stage end date
+ *
+ * Increment the log2 bucket of the measured latency in current CPU histogram.
+ * Nothing is done if start date is unknown.
+ */
+static inline void dw3000_lat_stats_record(struct dw3000 *dw,
+					   enum dw3000_lat_stage stage,
+					   u64 start_ns, u64 end_ns)
+{
+	u64 delta;
+	int bucket;
+
+	if (!start_ns || end_ns < start_ns || !dw->lat.hist)
+		return;
+	delta = end_ns - start_ns;
+	bucket = delta ? min(ilog2(delta), DW3000_LAT_BUCKETS - 1) : 0;
+	this_cpu_inc(dw->lat.hist->count[stage][bucket]);
+}
+
+/**
+ * dw3000_lat_stats_irq() - Save hard IRQ date
+ * @dw: the DW device
+ *
+ * Called from hard IRQ handler. Only first IRQ date is kept until the event
+ * thread handles it.
+ */
+static inline void dw3000_lat_stats_irq(struct dw3000 *dw)
+{
+	atomic64_cmpxchg(&dw->lat.irq_ns, 0, ktime_get_ns());
+}
+
+/**
+ * dw3000_lat_stats_thread() - Account IRQ to event thread latency
+ * @dw: the DW device
+ *
+ * Called by the event thread before IRQ handling.
+ */
+static inline void dw3000_lat_stats_thread(struct dw3000 *dw)
+{
+	u64 now_ns = ktime_get_ns();
+
+	dw3000_lat_stats_record(dw, DW3000_LAT_IRQ_TO_THREAD,
+				atomic64_xchg(&dw->lat.irq_ns, 0), now_ns);
+	dw->lat.thread_ns = now_ns;
+	dw->lat.status_ns = 0;
+}
+
+/**
+ * dw3000_lat_stats_status() - Account event thread to status read latency
+ * @dw: the DW device
+ *
+ * Called by the ISR when status register read is done.
+ */
+static inline void dw3000_lat_stats_status(struct dw3000 *dw)
+{
+	u64 now_ns = ktime_get_ns();
+
+	dw3000_lat_stats_record(dw, DW3000_LAT_THREAD_TO_STATUS,
+				dw->lat.thread_ns, now_ns);
+	dw->lat.thread_ns = 0;
+	dw->lat.status_ns = now_ns;
+}
+
+/**
+ * dw3000_lat_stats_rx_frame() - Account status read to MCPS callback latency
+ * @dw: the DW device
+ *
+ * Called just before the received frame is reported to MCPS.
+ */
+static inline void dw3000_lat_stats_rx_frame(struct dw3000 *dw)
+{
+	dw3000_lat_stats_record(dw, DW3000_LAT_STATUS_TO_MCPS,
+				dw->lat.status_ns, ktime_get_ns());
+}
+
+/**
+ * dw3000_lat_stats_tx_start() - Save immediate TX fast command date
+ * @dw: the DW device
+ * @immediate: true if TX is immediate, delayed TX latency isn't measured
+ */
+static inline void dw3000_lat_stats_tx_start(struct dw3000 *dw, bool immediate)
+{
+	dw->lat.tx_ns = immediate ? ktime_get_ns() : 0;
+}
+
+/**
+ * dw3000_lat_stats_tx_done() - Account TX fast command to TXFRS latency
+ * @dw: the DW device
+ *
+ * Called by the ISR when TXFRS event is handled. The end date is the status
+ * read date, when the event is known by the driver.
+ */
+static inline void dw3000_lat_stats_tx_done(struct dw3000 *dw)
+{
+	dw3000_lat_stats_record(dw, DW3000_LAT_TX_TO_TXFRS, dw->lat.tx_ns,
+				dw->lat.status_ns);
+	dw->lat.tx_ns = 0;
+}
+
+#endif /* __DW3000_LAT_STATS_H */
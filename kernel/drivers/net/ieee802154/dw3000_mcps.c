@@ -39,15 +39,6 @@
 #include "dw3000_cir.h"
 #include "dw3000_power_stats.h"
 
-static int completion_active(struct completion *completion)
-{
-#if (KERNEL_VERSION(5, 7, 0) > LINUX_VERSION_CODE)
-	return waitqueue_active(&completion->wait);
-#else
-	return swait_active(&completion->wait);
-#endif
-}
-
 static inline u64 timestamp_rctu_to_rmarker_rctu(struct dw3000 *dw,
 						 u64 timestamp_rctu,
 						 u32 rmarker_dtu);
@@ -148,6 +139,8 @@ static int do_start(struct dw3000 *dw, const void *in, void *out)
 		goto fail;
 	/* Reset ranging clock requirement */
 	dw->need_ranging_clock = false;
+	/* TX buffer content is lost */
+	dw->tx_prepared_frame_idx = -1;
 	/* Enable the device */
 	rc = dw3000_enable(dw);
 fail:
@@ -220,6 +213,7 @@ static int do_stop(struct dw3000 *dw, const void *in, void *out)
 	}
 	/* Reset ranging clock requirement */
 	dw->need_ranging_clock = false;
+	dw->tx_prepared_frame_idx = -1;
 	dw3000_reset_rctu_conv_state(dw);
 	/* Reset cached antenna config to ensure GPIO are well reconfigured */
 	dw->config.ant[0] = -1;
@@ -277,6 +271,30 @@ static int tx_frame(struct mcps802154_llhw *llhw, struct sk_buff *skb,
 	return dw3000_enqueue_generic(dw, &cmd);
 }
 
+struct do_tx_prepare_frame_params {
+	struct sk_buff *skb;
+	int frame_idx;
+};
+
+static int do_tx_prepare_frame(struct dw3000 *dw, const void *in, void *out)
+{
+	const struct do_tx_prepare_frame_params *params =
+		(const struct do_tx_prepare_frame_params *)in;
+
+	return dw3000_do_tx_prepare_frame(dw, params->skb, params->frame_idx);
+}
+
+static int tx_prepare_frame(struct mcps802154_llhw *llhw, struct sk_buff *skb,
+			    int frame_idx)
+{
+	struct dw3000 *dw = llhw->priv;
+	struct do_tx_prepare_frame_params params = { .skb = skb,
+						     .frame_idx = frame_idx };
+	struct dw3000_stm_command cmd = { do_tx_prepare_frame, &params, NULL };
+
+	return dw3000_enqueue_generic(dw, &cmd);
+}
+
 struct do_rx_frame_params {
 	const struct mcps802154_rx_frame_config *config;
 	int frame_idx;
@@ -543,8 +561,10 @@ static int rx_get_frame(struct mcps802154_llhw *llhw, struct sk_buff **skb,
 		info->ranging_tracking_interval_rctu = 1 << 26;
 	}
 
-	/* If dbgfs file is opened & waiting for data, fill structure and wake-up reading process */
-	if (dw->cir_data && completion_active(&dw->cir_data->complete)) {
+	/* If dbgfs file is opened & waiting for data, or CIR streaming is
+	   active, fill structure and wake-up reading process */
+	if (dw->cir_data && (completion_active(&dw->cir_data->complete) ||
+			     dw3000_cir_stream_active(&dw->cir_stream))) {
 		ret = dw3000_read_frame_cir_data(dw, info, pkt_ts);
 		if (ret)
 			goto error;
@@ -705,6 +725,7 @@ static int do_reset(struct dw3000 *dw, const void *in, void *out)
 		goto fail;
 	}
 fail:
+	dw->tx_prepared_frame_idx = -1;
 	dw3000_reset_rctu_conv_state(dw);
 	trace_dw3000_return_int(dw, rc);
 	return rc;
@@ -730,7 +751,7 @@ static int get_current_timestamp_dtu(struct mcps802154_llhw *llhw,
 		u32 margin = 0;
 		*timestamp_dtu = dw3000_get_dtu_time(dw);
 		if (dw->current_operational_state < DW3000_OP_STATE_IDLE_PLL)
-			margin = US_TO_DTU(DW3000_WAKEUP_LATENCY_US);
+			margin = US_TO_DTU(dw3000_wakeup_latency_us(dw));
 		*timestamp_dtu += margin;
 	} else
 		ret = -EBUSY;
@@ -836,13 +857,86 @@ static int do_set_channel(struct dw3000 *dw, const void *in, void *out)
 	return 0;
 }
 
+static int do_set_hrp_uwb_params(struct dw3000 *dw, const void *in, void *out);
+
+/* Configuration changes applied by do_set_channel() */
+#define DW3000_CHANNEL_CONFIG_CHANGES \
+	(DW3000_CHANNEL_CHANGED | DW3000_PCODE_CHANGED)
+/* Configuration changes applied by do_set_hrp_uwb_params() */
+#define DW3000_HRP_UWB_CONFIG_CHANGES                                  \
+	(DW3000_PREAMBLE_LENGTH_CHANGED | DW3000_SFD_CHANGED |         \
+	 DW3000_PHR_RATE_CHANGED | DW3000_DATA_RATE_CHANGED)
+/* Configuration changes applied by do_set_hw_addr_filt() */
+#define DW3000_HW_ADDR_FILT_CONFIG_CHANGES                                 \
+	(DW3000_AFILT_SADDR_CHANGED | DW3000_AFILT_IEEEADDR_CHANGED |      \
+	 DW3000_AFILT_PANID_CHANGED | DW3000_AFILT_PANC_CHANGED)
+
+static int do_apply_config(struct dw3000 *dw, const void *in, void *out)
+{
+	/* Take all changes made since the command was queued */
+	unsigned long pending = atomic_long_xchg(&dw->config_pending, 0);
+	unsigned long changed;
+	int rc = 0;
+
+	changed = pending & DW3000_CHANNEL_CONFIG_CHANGES;
+	if (changed)
+		rc = do_set_channel(dw, &changed, NULL);
+	changed = pending & DW3000_HRP_UWB_CONFIG_CHANGES;
+	if (!rc && changed)
+		rc = do_set_hrp_uwb_params(dw, &changed, NULL);
+	changed = pending & DW3000_HW_ADDR_FILT_CONFIG_CHANGES;
+	if (!rc && changed)
+		rc = do_set_hw_addr_filt(dw, &changed, NULL);
+	if (unlikely(rc)) {
+		/* No caller waits for the result, report it to MCPS and keep it
+		   for the next configuration caller */
+		dev_err(dw->dev, "configuration apply failed: %d\n", rc);
+		atomic_set(&dw->config_error, rc);
+		mcps802154_broken(dw->llhw);
+	}
+	return rc;
+}
+
+/**
+ * dw3000_apply_config_async() - Apply configuration changes asynchronously
+ * @dw: the DW device
+ * @changed: bitfield of changed configuration, see enum config_changed_flags
+ *
+ * Configuration is already updated in dw->config by the caller, only the chip
+ * must be reconfigured. Changes are accumulated and applied by a single STM
+ * command, so consecutive configuration operations cost only one STM thread
+ * wake-up and don't wait for it. Apply errors are reported using
+ * mcps802154_broken() and returned to the next caller.
+ *
+ * Return: zero on success, else a negative error code, either from enqueuing
+ * or from a previous asynchronous apply.
+ */
+static int dw3000_apply_config_async(struct dw3000 *dw, unsigned long changed)
+{
+	struct dw3000_stm_command cmd = { do_apply_config, NULL, NULL };
+	int rc = atomic_xchg(&dw->config_error, 0);
+
+	/* Nothing to do, or command already queued which will apply these
+	   changes too */
+	if (!changed || atomic_long_fetch_or(changed, &dw->config_pending))
+		return rc;
+	rc = dw3000_enqueue_async(dw, &cmd);
+	if (unlikely(rc)) {
+		/* Not queued, drop our changes only and allow next change to
+		   queue it again */
+		atomic_long_andnot(changed, &dw->config_pending);
+		dev_err(dw->dev, "configuration apply enqueue failed: %d\n",
+			rc);
+	}
+	return rc;
+}
+
 int set_channel(struct mcps802154_llhw *llhw, u8 page, u8 channel,
 		u8 preamble_code)
 {
 	unsigned long changed = 0;
 	struct dw3000 *dw = llhw->priv;
 	struct dw3000_config *config = &dw->config;
-	struct dw3000_stm_command cmd = { do_set_channel, &changed, NULL };
 	int ret = 0;
 
 	trace_dw3000_mcps_set_channel(dw, page, channel, preamble_code);
@@ -879,7 +973,7 @@ int set_channel(struct mcps802154_llhw *llhw, u8 page, u8 channel,
 	config->txCode = preamble_code;
 	config->rxCode = preamble_code;
 	/* Reconfigure the chip with it if needed */
-	ret = dw3000_is_active(dw) ? dw3000_enqueue_generic(dw, &cmd) : 0;
+	ret = dw3000_is_active(dw) ? dw3000_apply_config_async(dw, changed) : 0;
 trace:
 	trace_dw3000_return_int(dw, ret);
 	return ret;
@@ -983,8 +1077,6 @@ int set_hrp_uwb_params(struct mcps802154_llhw *llhw,
 	unsigned long changed = 0;
 	struct dw3000 *dw = llhw->priv;
 	struct dw3000_config *config = &dw->config;
-	struct dw3000_stm_command cmd = { do_set_hrp_uwb_params, &changed,
-					  NULL };
 	int ret;
 	int psr, sfd_selector, phr_hi_rate, data_rate;
 
@@ -1060,7 +1152,7 @@ int set_hrp_uwb_params(struct mcps802154_llhw *llhw,
 	config->dataRate = data_rate;
 
 	/* Reconfigure the chip with it if needed */
-	ret = dw3000_is_active(dw) ? dw3000_enqueue_generic(dw, &cmd) : 0;
+	ret = dw3000_is_active(dw) ? dw3000_apply_config_async(dw, changed) : 0;
 	return ret;
 }
 
@@ -1134,7 +1226,6 @@ static int set_hw_addr_filt(struct mcps802154_llhw *llhw,
 	struct dw3000 *dw = llhw->priv;
 	struct dw3000_config *config = &dw->config;
 	struct ieee802154_hw_addr_filt *cfilt = &config->hw_addr_filt;
-	struct dw3000_stm_command cmd = { do_set_hw_addr_filt, &changed, NULL };
 	int ret;
 
 	if (changed & IEEE802154_AFILT_SADDR_CHANGED)
@@ -1147,7 +1238,7 @@ static int set_hw_addr_filt(struct mcps802154_llhw *llhw,
 		cfilt->pan_coord = filt->pan_coord;
 
 	trace_dw3000_mcps_set_hw_addr_filt(dw, (u8)changed);
-	ret = dw3000_is_active(dw) ? dw3000_enqueue_generic(dw, &cmd) : 0;
+	ret = dw3000_is_active(dw) ? dw3000_apply_config_async(dw, changed) : 0;
 	trace_dw3000_return_int(dw, ret);
 	return ret;
 }
@@ -1216,8 +1307,8 @@ static int check_calibration_value(struct mcps802154_llhw *llhw,
 	return 0;
 }
 
-static int set_calibration(struct mcps802154_llhw *llhw, const char *key,
-			   void *value, size_t length)
+static int set_calibration_value(struct mcps802154_llhw *llhw,
+				 const char *key, void *value, size_t length)
 {
 	struct dw3000 *dw = llhw->priv;
 	void *param;
@@ -1237,6 +1328,18 @@ static int set_calibration(struct mcps802154_llhw *llhw, const char *key,
 		return r;
 	/* FIXME: This copy isn't big-endian compatible. */
 	memcpy(param, value, len);
+	return 0;
+}
+
+static int set_calibration(struct mcps802154_llhw *llhw, const char *key,
+			   void *value, size_t length)
+{
+	struct dw3000 *dw = llhw->priv;
+	int r;
+
+	r = set_calibration_value(llhw, key, value, length);
+	if (r)
+		return r;
 
 	/* One parameter has changed. */
 	dw3000_calib_update_config(dw);
@@ -1244,6 +1347,33 @@ static int set_calibration(struct mcps802154_llhw *llhw, const char *key,
 	return 0;
 }
 
+static int
+set_calibrations(struct mcps802154_llhw *llhw,
+		 const struct mcps802154_calibration *calibrations,
+		 int n_calibrations, int *n_set)
+{
+	struct dw3000 *dw = llhw->priv;
+	int r = 0;
+	int i;
+
+	for (i = 0; i < n_calibrations; i++) {
+		const struct mcps802154_calibration *calibration =
+			&calibrations[i];
+
+		r = set_calibration_value(llhw, calibration->key,
+					  calibration->value,
+					  calibration->length);
+		if (r)
+			break;
+	}
+	*n_set = i;
+
+	/* Update configuration once for all the changed parameters. */
+	if (i)
+		dw3000_calib_update_config(dw);
+	return r;
+}
+
 static int get_calibration(struct mcps802154_llhw *llhw, const char *key,
 			   void *value, size_t length)
 {
@@ -1385,6 +1515,7 @@ static const struct mcps802154_ops dw3000_mcps_ops = {
 	.start = start,
 	.stop = stop,
 	.tx_frame = tx_frame,
+	.tx_prepare_frame = tx_prepare_frame,
 	.rx_enable = rx_enable,
 	.rx_disable = rx_disable,
 	.rx_get_frame = rx_get_frame,
@@ -1406,6 +1537,7 @@ static const struct mcps802154_ops dw3000_mcps_ops = {
 	.set_cca_ed_level = set_cca_ed_level,
 	.set_promiscuous_mode = set_promiscuous_mode,
 	.set_calibration = set_calibration,
+	.set_calibrations = set_calibrations,
 	.get_calibration = get_calibration,
 	.list_calibration = list_calibration,
 	.vendor_cmd = vendor_cmd,
@@ -1474,6 +1606,13 @@ struct dw3000 *dw3000_mcps_alloc(struct device *dev)
 	llhw->hw->phy->current_channel = dw->config.chan;
 	llhw->hw->phy->current_page = 4;
 	llhw->current_preamble_code = dw->config.txCode;
+	/* Largest frame with the extended PHR. */
+	llhw->frame_len_max = DW3000_EXT_FRAME_LEN;
+	/* No frame preloaded in TX buffer. */
+	dw->tx_prepared_frame_idx = -1;
+	/* CIR are not reported in RX measurements, see rx_get_measurement(). */
+	llhw->cir_n_max = 0;
+	llhw->cir_window_size_max = 0;
 	/* AoA/PDoA filtering. */
 	llhw->rx_ctx_size = sizeof(struct dw3000_rx_ctx);
 
@@ -1489,6 +1628,7 @@ void dw3000_mcps_free(struct dw3000 *dw)
 	dev_dbg(dw->dev, "%s called\n", __func__);
 	if (dw->llhw) {
 		struct mcps802154_llhw *llhw = dw->llhw;
+		dw3000_rx_skb_pool_free(dw);
 		dw->llhw = NULL;
 		mcps802154_free_llhw(llhw);
 	}
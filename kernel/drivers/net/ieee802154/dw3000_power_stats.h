@@ -21,6 +21,8 @@
  * Qorvo. Please contact Qorvo to inquire about licensing terms.
  */
 
+#include <linux/sort.h>
+
 /**
  * dw3000_power_stats() - compute time elapsed in dw3000 states
  * @dw: the DW device on which state is changed
@@ -103,3 +105,102 @@ static inline void dw3000_power_stats(struct dw3000 *dw, int state,
 	pw->start_time = boot_time_ns;
 	pw->cur_state = state;
 }
+
+/**
+ * dw3000_power_stats_wakeup_start() - record start of a wake-up
+ * @dw: the DW device which is woken up
+ *
+ * Only the first call is recorded, so the wake-up timer expiration is kept
+ * as start when it triggered the wake-up.
+ */
+static inline void dw3000_power_stats_wakeup_start(struct dw3000 *dw)
+{
+	if (!dw->power.wakeup_start)
+		dw->power.wakeup_start = ktime_get_boottime_ns();
+}
+
+/**
+ * dw3000_power_stats_wakeup_cancel() - forget the start of a wake-up
+ * @dw: the DW device which is not woken up
+ *
+ * Called when the wake-up is not done or failed, so the next one is measured
+ * from its own start.
+ */
+static inline void dw3000_power_stats_wakeup_cancel(struct dw3000 *dw)
+{
+	dw->power.wakeup_start = 0;
+}
+
+/**
+ * dw3000_power_stats_wakeup_done() - account a wake-up, chip is ready
+ * @dw: the DW device which is woken up
+ *
+ * Return: the wake-up to ready duration in ns
+ */
+static inline u64 dw3000_power_stats_wakeup_done(struct dw3000 *dw)
+{
+	struct dw3000_power *pw = &dw->power;
+	u64 duration = ktime_get_boottime_ns() - pw->wakeup_start;
+
+	pw->wakeup_start = 0;
+	pw->wakeup.dur += duration;
+	pw->wakeup.count++;
+	if (duration > pw->wakeup_max)
+		pw->wakeup_max = duration;
+	return duration;
+}
+
+/**
+ * dw3000_sleep_missed() - Count a missed deep sleep opportunity
+ * @dw: the DW device
+ * @delay_us: the delay before which RX/TX must be executed
+ *
+ * Called when dw3000_can_deep_sleep() refused deep sleep before a TX/RX. The
+ * opportunity is counted when only auto_sleep_margin_us prevented it.
+ */
+static inline void dw3000_sleep_missed(struct dw3000 *dw, int delay_us)
+{
+	if (!dw->need_ranging_clock &&
+	    delay_us >= dw3000_wakeup_latency_us(dw))
+		dw->power.sleep_missed++;
+}
+
+static inline int dw3000_wakeup_samples_cmp(const void *a, const void *b)
+{
+	u32 va = *(const u32 *)a, vb = *(const u32 *)b;
+
+	return va < vb ? -1 : va > vb;
+}
+
+/**
+ * dw3000_wakeup_latency_update() - Learn wake-up latency from a measure
+ * @dw: the DW device
+ * @duration_ns: measured wake-up to ready duration
+ *
+ * The learned latency is a high percentile of the last measures, plus a
+ * safety margin. It is only used once enough wake-ups were measured.
+ */
+static inline void dw3000_wakeup_latency_update(struct dw3000 *dw,
+						u64 duration_ns)
+{
+	struct dw3000_power *pw = &dw->power;
+	u32 samples_us[DW3000_WAKEUP_SAMPLES];
+	int n, rank;
+
+	pw->wakeup_samples_us[pw->wakeup_sample_idx] =
+		min_t(u64, div_u64(duration_ns, 1000),
+		      2 * DW3000_WAKEUP_LATENCY_US);
+	pw->wakeup_sample_idx = (pw->wakeup_sample_idx + 1) %
+				DW3000_WAKEUP_SAMPLES;
+	if (pw->wakeup_sample_count < DW3000_WAKEUP_SAMPLES)
+		pw->wakeup_sample_count++;
+	n = pw->wakeup_sample_count;
+	if (n < DW3000_WAKEUP_LATENCY_MIN_SAMPLES)
+		return;
+	memcpy(samples_us, pw->wakeup_samples_us, n * sizeof(*samples_us));
+	sort(samples_us, n, sizeof(*samples_us), dw3000_wakeup_samples_cmp,
+	     NULL);
+	rank = DIV_ROUND_UP(n * DW3000_WAKEUP_LATENCY_PERCENTILE, 100) - 1;
+	WRITE_ONCE(pw->wakeup_latency_us,
+		   samples_us[rank] + DW3000_WAKEUP_LATENCY_GUARD_US);
+}
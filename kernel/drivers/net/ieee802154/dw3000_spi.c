@@ -31,9 +31,12 @@
 #include "dw3000_stm.h"
 #include "dw3000_mcps.h"
 #include "dw3000_debugfs.h"
+#include "dw3000_lat_stats.h"
 
 /* Default value for auto_deep_sleep_margin.
- * Set to -1 (disabled) until we want to have deep-sleep enabled by default. */
+ * Set to -1 (disabled) until we want to have deep-sleep enabled by default.
+ * Wake-up latency is only learned when deep-sleep is enabled, set it to 0 to
+ * use the learned latency alone as deep-sleep threshold. */
 #define DW3000_AUTO_DEEP_SLEEP_MARGIN_US -1
 
 int dw3000_qos_latency = 0;
@@ -154,6 +157,11 @@ static int dw3000_spi_probe(struct spi_device *spi)
 	if (rc != 0)
 		goto err_setup_gpios;
 
+	/* Allocate pipeline latency statistics */
+	rc = dw3000_lat_stats_init(dw);
+	if (rc != 0)
+		goto err_lat_stats_init;
+
 	/* Allocate pre-computed SPI messages for fast access some registers */
 	rc = dw3000_transfers_init(dw);
 	if (rc != 0)
@@ -192,6 +200,11 @@ static int dw3000_spi_probe(struct spi_device *spi)
 	if (rc != 0)
 		goto err_debugfs;
 
+	/* CIR streaming character device */
+	rc = dw3000_cir_stream_init(dw);
+	if (rc != 0)
+		goto err_cir_stream;
+
 	/* Register MCPS 802.15.4 device */
 	rc = dw3000_mcps_register(dw);
 	if (rc != 0) {
@@ -203,6 +216,8 @@ static int dw3000_spi_probe(struct spi_device *spi)
 	return 0;
 
 err_register_hw:
+	dw3000_cir_stream_remove(dw);
+err_cir_stream:
 	dw3000_debugfs_remove(dw);
 err_debugfs:
 err_state_start:
@@ -212,6 +227,8 @@ err_setup_irq:
 err_state_init:
 	dw3000_transfers_free(dw);
 err_transfers_init:
+	dw3000_lat_stats_free(dw);
+err_lat_stats_init:
 err_setup_gpios:
 err_spi_setup:
 	dw3000_sysfs_remove(dw);
@@ -246,6 +263,7 @@ static int dw3000_spi_remove(struct spi_device *spi)
 	dev_dbg(dw->dev, "unloading...");
 
 	/* Remove sysfs files */
+	dw3000_cir_stream_remove(dw);
 	dw3000_debugfs_remove(dw);
 	dw3000_sysfs_remove(dw);
 	/* Unregister subsystems */
@@ -255,6 +273,8 @@ static int dw3000_spi_remove(struct spi_device *spi)
 	dw3000_pm_qos_remove_request(dw);
 	/* Free pre-computed SPI messages */
 	dw3000_transfers_free(dw);
+	/* Free pipeline latency statistics */
+	dw3000_lat_stats_free(dw);
 	/* Release the mcps 802.15.4 device */
 	dw3000_cir_data_alloc_count(dw, 0);
 	dw3000_mcps_free(dw);
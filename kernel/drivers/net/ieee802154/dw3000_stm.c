@@ -25,10 +25,13 @@
 #include <linux/workqueue.h>
 #include <linux/sched.h>
 #include <linux/mutex.h>
+#include <linux/completion.h>
+#include <linux/ktime.h>
 #include <linux/of.h>
 
 #include "dw3000.h"
 #include "dw3000_core.h"
+#include "dw3000_lat_stats.h"
 
 #define DW3000_MIN_CLAMP_VALUE 460
 
@@ -91,12 +94,144 @@ void dw3000_enqueue(struct dw3000 *dw, unsigned long work)
 	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
 }
 
+/* Add a command to the ring, work_wq lock must be held */
+static void dw3000_ring_push(struct dw3000_state *stm,
+			     const struct dw3000_stm_command *cmd,
+			     struct dw3000_stm_command *caller,
+			     struct completion *done)
+{
+	struct dw3000_stm_entry *entry =
+		&stm->ring[(stm->ring_head + stm->ring_count) %
+			   DW3000_STM_RING_SIZE];
+
+	entry->cmd = *cmd;
+	entry->caller = caller;
+	entry->done = done;
+	entry->enqueue_ns = ktime_get_ns();
+	stm->ring_count++;
+	if (stm->ring_count > stm->stats.max_occupancy)
+		stm->stats.max_occupancy = stm->ring_count;
+	stm->pending_work |= DW3000_COMMAND_WORK;
+	wake_up_locked(&stm->work_wq);
+}
+
+/* Remove next command from the ring, return false if empty */
+static bool dw3000_ring_pop(struct dw3000 *dw, struct dw3000_stm_entry *entry)
+{
+	struct dw3000_state *stm = &dw->stm;
+	unsigned long flags;
+	u64 wait_ns;
+
+	spin_lock_irqsave(&stm->work_wq.lock, flags);
+	if (!stm->ring_count) {
+		stm->pending_work &= ~DW3000_COMMAND_WORK;
+		spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+		return false;
+	}
+	*entry = stm->ring[stm->ring_head];
+	stm->ring_head = (stm->ring_head + 1) % DW3000_STM_RING_SIZE;
+	if (!--stm->ring_count)
+		stm->pending_work &= ~DW3000_COMMAND_WORK;
+	/* Update statistics */
+	wait_ns = ktime_get_ns() - entry->enqueue_ns;
+	stm->stats.executed++;
+	stm->stats.wait_total_ns += wait_ns;
+	if (wait_ns > stm->stats.wait_max_ns)
+		stm->stats.wait_max_ns = wait_ns;
+	/* Wake up callers waiting for ring space */
+	wake_up_locked(&stm->work_wq);
+	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+	return true;
+}
+
+/* Add a command to the ring from a context which can sleep, waiting for
+   ring space if needed but keeping some entries for timer commands. */
+static int dw3000_ring_push_wait(struct dw3000 *dw,
+				 const struct dw3000_stm_command *cmd,
+				 struct dw3000_stm_command *caller,
+				 struct completion *done)
+{
+	struct dw3000_state *stm = &dw->stm;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stm->work_wq.lock, flags);
+	if (!stm->stopped && stm->ring_count >= DW3000_STM_RING_SIZE -
+							DW3000_STM_TIMER_RESERVED) {
+		stm->stats.full_waits++;
+		if (wait_event_interruptible_locked_irq(
+			    stm->work_wq,
+			    stm->stopped ||
+				    stm->ring_count <
+					    DW3000_STM_RING_SIZE -
+						    DW3000_STM_TIMER_RESERVED)) {
+			spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+			dev_err(dw->dev, "work enqueuing interrupted by signal");
+			return -EINTR;
+		}
+	}
+	if (unlikely(stm->stopped)) {
+		/* Nobody left to execute the command. */
+		spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+		return -ESHUTDOWN;
+	}
+	dw3000_ring_push(stm, cmd, caller, done);
+	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+	return 0;
+}
+
+/* Cancel a command not yet executed, return false if already taken by the
+   thread. The entry is kept in the ring, but disabled. */
+static bool dw3000_ring_cancel(struct dw3000 *dw, struct completion *done)
+{
+	struct dw3000_state *stm = &dw->stm;
+	unsigned long flags;
+	bool found = false;
+	unsigned int i;
+
+	spin_lock_irqsave(&stm->work_wq.lock, flags);
+	for (i = 0; i < stm->ring_count; i++) {
+		struct dw3000_stm_entry *entry =
+			&stm->ring[(stm->ring_head + i) % DW3000_STM_RING_SIZE];
+
+		if (entry->done == done) {
+			entry->cmd.cmd = NULL;
+			entry->caller = NULL;
+			entry->done = NULL;
+			found = true;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+	return found;
+}
+
+/* Stop accepting commands and release callers of queued ones */
+static void dw3000_ring_shutdown(struct dw3000 *dw)
+{
+	struct dw3000_state *stm = &dw->stm;
+	struct dw3000_stm_entry entry;
+	unsigned long flags;
+
+	spin_lock_irqsave(&stm->work_wq.lock, flags);
+	stm->stopped = true;
+	/* Wake up callers waiting for ring space */
+	wake_up_locked(&stm->work_wq);
+	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+
+	while (dw3000_ring_pop(dw, &entry)) {
+		if (entry.caller) {
+			entry.caller->ret = -ESHUTDOWN;
+			complete(entry.done);
+		}
+	}
+}
+
 /* Enqueue a generic work and wait for execution */
 int dw3000_enqueue_generic(struct dw3000 *dw, struct dw3000_stm_command *cmd)
 {
 	struct dw3000_state *stm = &dw->stm;
-	unsigned long flags;
-	int work = DW3000_COMMAND_WORK;
+	DECLARE_COMPLETION_ONSTACK(done);
+	int rc;
 
 	if (current == stm->mthread) {
 		/* We can't enqueue a new work from the same context and wait,
@@ -104,26 +239,38 @@ int dw3000_enqueue_generic(struct dw3000 *dw, struct dw3000_stm_command *cmd)
 		return cmd->cmd(dw, cmd->in, cmd->out);
 	}
 
-	/* Mutex is used in dw3000_enqueue_generic()
-	* This protection will work with the spinlock in order to allow
-	* the CPU to sleep and avoid ressources wasting during spinning
-	*/
-	if (mutex_lock_interruptible(&stm->mtx) == -EINTR) {
-		dev_err(dw->dev, "work enqueuing interrupted by signal");
-		return -EINTR;
-	}
 	/* Slow path if not in STM thread context */
-	spin_lock_irqsave(&stm->work_wq.lock, flags);
-	stm->pending_work |= work;
-	stm->generic_work = cmd;
-	wake_up_locked(&stm->work_wq);
-	wait_event_interruptible_locked_irq(stm->work_wq,
-					    !(stm->pending_work & work));
-	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
-	mutex_unlock(&stm->mtx);
+	rc = dw3000_ring_push_wait(dw, cmd, cmd, &done);
+	if (rc)
+		return rc;
+	/* The cmd is owned by the caller, so wait for its execution. */
+	if (wait_for_completion_interruptible(&done)) {
+		if (dw3000_ring_cancel(dw, &done)) {
+			dev_err(dw->dev, "work execution interrupted by signal");
+			return -EINTR;
+		}
+		/* Already running, its in/out arguments are still used. */
+		wait_for_completion(&done);
+	}
 	return cmd->ret;
 }
 
+/* Enqueue a generic work without waiting for execution. The cmd is copied,
+ * so its in/out arguments must remain valid until execution. The command
+ * function is responsible of reporting its own errors.
+ */
+int dw3000_enqueue_async(struct dw3000 *dw, struct dw3000_stm_command *cmd)
+{
+	struct dw3000_state *stm = &dw->stm;
+
+	if (current == stm->mthread) {
+		/* Already in the STM thread, just execute it. */
+		cmd->cmd(dw, cmd->in, cmd->out);
+		return 0;
+	}
+	return dw3000_ring_push_wait(dw, cmd, NULL, NULL);
+}
+
 /* Enqueue a timer work and don't wait for execution because sleeping in not
  * possible from a timer callback function.
  */
@@ -133,17 +280,20 @@ void dw3000_enqueue_timer(struct dw3000 *dw, struct dw3000_stm_command *cmd)
 	unsigned long flags;
 
 	spin_lock_irqsave(&stm->work_wq.lock, flags);
-	if (stm->pending_work & DW3000_TIMER_WORK) {
-		/* A timer cmd is already queued. */
+	if (unlikely(stm->stopped)) {
+		spin_unlock_irqrestore(&stm->work_wq.lock, flags);
+		return;
+	}
+	if (unlikely(stm->ring_count >= DW3000_STM_RING_SIZE)) {
+		/* Reserved entries are all used, can't do better. */
+		stm->stats.timer_dropped++;
 		spin_unlock_irqrestore(&stm->work_wq.lock, flags);
 		dev_err(dw->dev,
-			"A timer cmd is already queued, this cmd will be ignored\n");
+			"commands ring is full, timer cmd will be ignored\n");
 		return;
 	}
-	stm->pending_work |= DW3000_TIMER_WORK;
-	/* The cmd should not be stored on the stack of the calling function. */
-	stm->timer_work = *cmd;
-	wake_up_locked(&stm->work_wq);
+	/* The cmd is copied, so it can be stored on the caller stack. */
+	dw3000_ring_push(stm, cmd, NULL, NULL);
 	/* Can't unlock in the event thread, when the cmd is finished, because
 	 * the current function is executed in the timer function in atomic context.
 	 * If the unlock is made in the event thread, a preempt leak warning
@@ -154,15 +304,16 @@ void dw3000_enqueue_timer(struct dw3000 *dw, struct dw3000_stm_command *cmd)
 	/* Can't return cmd->ret because it's not yet executed. */
 }
 
-/* Dequeue work item(s) */
-void dw3000_dequeue(struct dw3000 *dw, unsigned long work)
+/* Read commands ring statistics */
+void dw3000_get_stm_stats(struct dw3000 *dw, struct dw3000_stm_stats *stats,
+			  unsigned int *occupancy)
 {
 	struct dw3000_state *stm = &dw->stm;
 	unsigned long flags;
 
 	spin_lock_irqsave(&stm->work_wq.lock, flags);
-	stm->pending_work &= ~work;
-	wake_up_locked(&stm->work_wq);
+	*stats = stm->stats;
+	*occupancy = stm->ring_count;
 	spin_unlock_irqrestore(&stm->work_wq.lock, flags);
 }
 
@@ -250,7 +401,7 @@ static int dw3000_detect_work(struct dw3000 *dw, const void *in, void *out)
 int dw3000_event_thread(void *data)
 {
 	struct dw3000 *dw = data;
-	struct dw3000_state *stm = &dw->stm;
+	struct dw3000_stm_entry entry;
 	unsigned long pending_work = 0;
 
 	/* Run until stopped */
@@ -268,41 +419,44 @@ int dw3000_event_thread(void *data)
 		/* Check IRQ activity */
 		if (pending_work & DW3000_IRQ_WORK) {
 			/* Handle the event in the ISR */
+			dw3000_lat_stats_thread(dw);
 			dw3000_isr(dw);
 			dw3000_clear_irq(dw);
 			continue;
 		}
 
-		/* In nearly all states, we can execute generic works. */
+		/* In nearly all states, we can execute generic and timer
+		   works. Only one is executed to check IRQ activity first. */
 		if (pending_work & DW3000_COMMAND_WORK) {
-			struct dw3000_stm_command *cmd = stm->generic_work;
-			bool is_detect_work = cmd->cmd == dw3000_detect_work;
-
-			cmd->ret = cmd->cmd(dw, cmd->in, cmd->out);
-			dw3000_dequeue(dw, DW3000_COMMAND_WORK);
-			if (unlikely(is_detect_work &&
-				     dw3000_spitests_enabled(dw))) {
-				/* Run SPI tests if enabled after dw3000_detect_work. */
-				dw3000_spitests(dw);
-				/* Power down the device after SPI tests */
-				dw3000_poweroff(dw);
+			if (dw3000_ring_pop(dw, &entry) && entry.cmd.cmd) {
+				bool is_detect_work =
+					entry.cmd.cmd == dw3000_detect_work;
+				int ret = entry.cmd.cmd(dw, entry.cmd.in,
+							entry.cmd.out);
+
+				if (entry.caller) {
+					entry.caller->ret = ret;
+					complete(entry.done);
+				}
+				if (unlikely(is_detect_work &&
+					     dw3000_spitests_enabled(dw))) {
+					/* Run SPI tests if enabled after dw3000_detect_work. */
+					dw3000_spitests(dw);
+					/* Power down the device after SPI tests */
+					dw3000_poweroff(dw);
+				}
 			}
 		}
 
-		/* Execute the cmd from a timer handler that can't sleep. */
-		if (pending_work & DW3000_TIMER_WORK) {
-			struct dw3000_stm_command *cmd = &stm->timer_work;
-
-			cmd->ret = cmd->cmd(dw, cmd->in, cmd->out);
-			dw3000_dequeue(dw, DW3000_TIMER_WORK);
-		}
-
 		if (!pending_work) {
 			/* Wait for more work */
 			dw3000_wait_pending_work(dw);
 		}
 	}
 
+	/* Release callers of commands which will never be executed */
+	dw3000_ring_shutdown(dw);
+
 	/* Make sure device is off */
 	dw3000_remove(dw);
 	/* Power down the device */
@@ -323,8 +477,6 @@ int dw3000_state_init(struct dw3000 *dw, int cpu)
 	/* Wait queues */
 	init_waitqueue_head(&stm->work_wq);
 
-	mutex_init(&stm->mtx);
-
 	/* SKIP: Setup timers (state timeout and ADC timers) */
 
 	/* Init event handler thread */
@@ -398,6 +550,8 @@ int dw3000_state_stop(struct dw3000 *dw)
 
 	/* Stop state machine thread */
 	kthread_stop(stm->mthread);
+	/* Thread function isn't run if stopped before being started */
+	dw3000_ring_shutdown(dw);
 	put_task_struct(stm->mthread);
 	stm->mthread = NULL;
 
@@ -24,13 +24,18 @@
 #define __DW3000_STM_H
 
 struct dw3000;
+struct completion;
 
 /* Pending work bits */
 enum { DW3000_IRQ_WORK = BIT(0),
        DW3000_COMMAND_WORK = BIT(1),
-       DW3000_TIMER_WORK = BIT(2),
 };
 
+/* Number of entries in the commands ring */
+#define DW3000_STM_RING_SIZE 16
+/* Ring entries reserved to timer commands, which can't wait for space */
+#define DW3000_STM_TIMER_RESERVED 4
+
 /* Custom function for command */
 typedef int (*cmd_func)(struct dw3000 *dw, const void *in, void *out);
 
@@ -42,22 +47,54 @@ struct dw3000_stm_command {
 	int ret;
 };
 
+/* Commands ring entry */
+struct dw3000_stm_entry {
+	/* Command to execute, copied from caller */
+	struct dw3000_stm_command cmd;
+	/* Caller command updated with result, NULL for timer command */
+	struct dw3000_stm_command *caller;
+	/* Completion signaled to waiting caller, NULL for timer command */
+	struct completion *done;
+	/* Enqueue date in ns */
+	u64 enqueue_ns;
+};
+
+/* Commands ring statistics */
+struct dw3000_stm_stats {
+	/* Number of executed commands */
+	u64 executed;
+	/* Cumulated wait time between enqueue and execution in ns */
+	u64 wait_total_ns;
+	/* Maximum wait time between enqueue and execution in ns */
+	u64 wait_max_ns;
+	/* Maximum number of queued commands */
+	unsigned int max_occupancy;
+	/* Number of generic commands which waited for ring space */
+	u64 full_waits;
+	/* Number of timer commands lost because ring was full */
+	u64 timer_dropped;
+};
+
 /* DW3000 state machine */
 struct dw3000_state {
 	/* Pending work bitmap */
 	unsigned long pending_work;
 	/* Error recovery count */
 	unsigned int recovery_count;
-	/* Generic work argument */
-	struct dw3000_stm_command *generic_work;
-	/* Timer work argument */
-	struct dw3000_stm_command timer_work;
+	/* Commands ring, protected by work_wq lock */
+	struct dw3000_stm_entry ring[DW3000_STM_RING_SIZE];
+	/* Index of next command to execute */
+	unsigned int ring_head;
+	/* Number of queued commands */
+	unsigned int ring_count;
+	/* Commands ring statistics, protected by work_wq lock */
+	struct dw3000_stm_stats stats;
+	/* Set when thread stopped, new commands are rejected */
+	bool stopped;
 	/* Event handler thread */
 	struct task_struct *mthread;
 	/* Wait queue */
 	wait_queue_head_t work_wq;
-	/* Enqueue generic mutex */
-	struct mutex mtx;
 };
 
 /* Event handler of the state machine */
@@ -66,7 +103,10 @@ int dw3000_event_thread(void *data);
 void dw3000_enqueue(struct dw3000 *dw, unsigned long work);
 void dw3000_enqueue_irq(struct dw3000 *dw);
 int dw3000_enqueue_generic(struct dw3000 *dw, struct dw3000_stm_command *cmd);
+int dw3000_enqueue_async(struct dw3000 *dw, struct dw3000_stm_command *cmd);
 void dw3000_enqueue_timer(struct dw3000 *dw, struct dw3000_stm_command *cmd);
+void dw3000_get_stm_stats(struct dw3000 *dw, struct dw3000_stm_stats *stats,
+			  unsigned int *occupancy);
 
 int dw3000_state_init(struct dw3000 *dw, int cpu);
 int dw3000_state_start(struct dw3000 *dw);
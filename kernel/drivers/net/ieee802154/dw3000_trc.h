@@ -253,7 +253,7 @@ TRACE_DEFINE_ENUM(DW3000_PWR_TX);
 #define RX_FRAME_INFO_FLAGS_PR_ARG \
 	__print_flags(__entry->flags, "|", RX_FRAME_INFO_FLAGS)
 
-#define TX_FRAME_CONFIG_FLAGS_ENTRY __field(u8, flags)
+#define TX_FRAME_CONFIG_FLAGS_ENTRY __field(u16, flags)
 #define TX_FRAME_CONFIG_FLAGS_ASSIGN entry->flags = flags
 #define TX_FRAME_CONFIG_FLAGS_PR_FMT "flags: %s"
 
@@ -271,7 +271,8 @@ TRACE_DEFINE_ENUM(DW3000_PWR_TX);
 	mcps802154_tx_frame_config_name(SP3),				\
 	mcps802154_tx_frame_config_name(SP2),				\
 	mcps802154_tx_frame_config_name(SP1),				\
-	mcps802154_tx_frame_config_name(STS_MODE_MASK)
+	mcps802154_tx_frame_config_name(STS_MODE_MASK),			\
+	mcps802154_tx_frame_config_name(PREPARED)
 /* clang-format on */
 
 #define TX_FRAME_CONFIG_FLAGS_PR_ARG \
@@ -424,7 +425,7 @@ DEFINE_EVENT(dw_only_evt, dw3000_mcps_stop,
 );
 
 TRACE_EVENT(dw3000_mcps_tx_frame,
-	TP_PROTO(struct dw3000 *dw, u8 flags, u16 len),
+	TP_PROTO(struct dw3000 *dw, u16 flags, u16 len),
 	TP_ARGS(dw, flags, len),
 	TP_STRUCT__entry(
 		DW_ENTRY
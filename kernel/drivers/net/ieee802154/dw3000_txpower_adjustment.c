@@ -21,6 +21,7 @@
  * Qorvo. Please contact Qorvo to inquire about licensing terms.
  */
 
+#include <linux/bits.h>
 #include <linux/types.h>
 #include "dw3000_trc.h"
 #include "dw3000_txpower_adjustment.h"
@@ -550,16 +551,43 @@ static u32 adjust_tx_power(u16 frame_duration_us, u32 ref_tx_power, u8 channel,
  */
 int dw3000_adjust_tx_power(struct dw3000 *dw, int payload_bytes)
 {
-	u16 th_boost, app_boost;
+	struct dw3000_txpower_memo *memo = &dw->txpower_memo;
+	struct dw3000_txpower_memo_entry *entry;
+	u32 ref_tx_power = dw->txconfig.power;
 	u8 chan = dw->config.chan;
 	u16 frm_dur =
 		DTU_TO_US(dw3000_frame_duration_dtu(dw, payload_bytes, true));
-	u32 adjusted_tx_power = adjust_tx_power(frm_dur, dw->txconfig.power,
-						chan, &th_boost, &app_boost);
-
-	trace_dw3000_adjust_tx_power(dw, dw->txconfig.power, adjusted_tx_power,
-				     frm_dur, payload_bytes, chan, th_boost,
-				     app_boost);
+	int i;
+
+	for (i = 0; i < DW3000_TXPOWER_MEMO_SIZE; i++) {
+		entry = &memo->entries[i];
+		if ((memo->valid & BIT(i)) && entry->chan == chan &&
+		    entry->ref_tx_power == ref_tx_power &&
+		    entry->frame_duration_us == frm_dur) {
+			memo->hits++;
+			goto found;
+		}
+	}
 
-	return dw3000_set_tx_power_register(dw, adjusted_tx_power);
+	/* Not known yet, do the search and remember it. */
+	i = memo->next;
+	memo->next = (i + 1) % DW3000_TXPOWER_MEMO_SIZE;
+	entry = &memo->entries[i];
+	entry->chan = chan;
+	entry->ref_tx_power = ref_tx_power;
+	entry->frame_duration_us = frm_dur;
+	entry->adjusted_tx_power =
+		adjust_tx_power(frm_dur, ref_tx_power, chan, &entry->th_boost,
+				&entry->app_boost);
+	memo->valid |= BIT(i);
+	memo->misses++;
+
+found:
+	trace_dw3000_adjust_tx_power(dw, ref_tx_power,
+				     entry->adjusted_tx_power, frm_dur,
+				     payload_bytes, chan, entry->th_boost,
+				     entry->app_boost);
+
+	/* Elided by the shadow registers cache when already programmed. */
+	return dw3000_set_tx_power_register(dw, entry->adjusted_tx_power);
 }
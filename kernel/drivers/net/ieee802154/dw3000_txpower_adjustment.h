@@ -33,4 +33,13 @@ static inline int dw3000_set_tx_power_register(struct dw3000 *dw, u32 value)
 
 int dw3000_adjust_tx_power(struct dw3000 *dw, int payload_bytes);
 
+/**
+ * dw3000_txpower_memo_invalidate() - Forget remembered TX power adjustments
+ * @dw: the DW device
+ */
+static inline void dw3000_txpower_memo_invalidate(struct dw3000 *dw)
+{
+	dw->txpower_memo.valid = 0;
+}
+
 #endif /* __DW3000_TXPOWER_ADJUSTMENT_H */
@@ -0,0 +1 @@
+../../../mac/include/net/fira_report_ring_abi.h
\ No newline at end of file
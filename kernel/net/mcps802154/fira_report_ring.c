@@ -0,0 +1 @@
+../../../mac/fira_report_ring.c
\ No newline at end of file
@@ -0,0 +1 @@
+../../../mac/fira_report_ring.h
\ No newline at end of file
@@ -28,23 +28,27 @@
 
 int fira_round_hopping_crypto_encrypt(
 	const struct fira_round_hopping_sequence *round_hopping_sequence,
-	const u8 *data, u8 *out)
+	const u8 *data, u8 *out, int n_blocks)
 {
 	struct scatterlist sg;
 	SYNC_SKCIPHER_REQUEST_ON_STACK(req, round_hopping_sequence->tfm);
+	unsigned int len = n_blocks * AES_BLOCK_SIZE;
 	int r;
 
-	sg_init_one(&sg, round_hopping_sequence->data, AES_BLOCK_SIZE);
-	memcpy(round_hopping_sequence->data, data, AES_BLOCK_SIZE);
+	if (n_blocks <= 0 || n_blocks > FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS)
+		return -EINVAL;
+
+	sg_init_one(&sg, round_hopping_sequence->data, len);
+	memcpy(round_hopping_sequence->data, data, len);
 
 	skcipher_request_set_sync_tfm(req, round_hopping_sequence->tfm);
 	skcipher_request_set_callback(req, 0, NULL, NULL);
-	skcipher_request_set_crypt(req, &sg, &sg, AES_BLOCK_SIZE, NULL);
+	skcipher_request_set_crypt(req, &sg, &sg, len, NULL);
 
 	r = crypto_skcipher_encrypt(req);
 	skcipher_request_zero(req);
 
-	memcpy(out, round_hopping_sequence->data, AES_BLOCK_SIZE);
+	memcpy(out, round_hopping_sequence->data, len);
 
 	return r;
 }
@@ -56,7 +60,8 @@ int fira_round_hopping_crypto_init(
 	u8 *data;
 	int r;
 
-	data = kmalloc(AES_BLOCK_SIZE, GFP_KERNEL);
+	data = kmalloc(FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS * AES_BLOCK_SIZE,
+		       GFP_KERNEL);
 	if (!data)
 		return -ENOMEM;
 
@@ -39,10 +39,14 @@
 
 struct mcps_aes_ccm_star_128_ctx {
 	struct crypto_aead *tfm;
+	/* Request reused by every call on this context. */
+	struct aead_request *req;
 };
 
 struct mcps_aes_ecb_128_ctx {
 	struct crypto_skcipher *tfm;
+	/* Request reused by every call on this context. */
+	struct skcipher_request *req;
 	bool decrypt;
 };
 
@@ -100,6 +104,7 @@ struct mcps_aes_ccm_star_128_ctx *mcps_crypto_aead_aes_ccm_star_128_create(void)
 		if (PTR_ERR(ctx->tfm) == -ENOENT)
 			pr_err("The crypto transform ccm(aes) seems to be missing."
 			       " Please check your kernel configuration.\n");
+		ctx->tfm = NULL;
 		goto error;
 	}
 
@@ -107,6 +112,10 @@ struct mcps_aes_ccm_star_128_ctx *mcps_crypto_aead_aes_ccm_star_128_create(void)
 	if (r != 0)
 		goto error;
 
+	ctx->req = aead_request_alloc(ctx->tfm, GFP_KERNEL);
+	if (!ctx->req)
+		goto error;
+
 	return ctx;
 
 error:
@@ -129,6 +138,7 @@ void mcps_crypto_aead_aes_ccm_star_128_destroy(struct mcps_aes_ccm_star_128_ctx
 	if (!ctx)
 		return;
 
+	aead_request_free(ctx->req);
 	crypto_free_aead(ctx->tfm);
 	kfree(ctx);
 }
@@ -139,11 +149,10 @@ int mcps_crypto_aead_aes_ccm_star_128_encrypt(
 		uint8_t *data, unsigned int data_len,
 		uint8_t *mac, unsigned int mac_len)
 {
-	struct aead_request *req = NULL;
+	struct aead_request *req;
 	struct scatterlist sg[3];
 	u8 iv[AES_BLOCK_SIZE];
 	DECLARE_CRYPTO_WAIT(wait);
-	int r = -1;
 
 	if (!ctx || !nonce || !header || header_len <= 0 || !data ||
 			data_len <= 0 || !mac ||
@@ -151,11 +160,7 @@ int mcps_crypto_aead_aes_ccm_star_128_encrypt(
 		return -EINVAL;
 	}
 
-	req = aead_request_alloc(ctx->tfm, GFP_KERNEL);
-	if (!req) {
-		r = -ENOMEM;
-		goto end;
-	}
+	req = ctx->req;
 
 	sg_init_table(sg, ARRAY_SIZE(sg));
 	sg_set_buf(&sg[0], header, header_len);
@@ -171,12 +176,7 @@ int mcps_crypto_aead_aes_ccm_star_128_encrypt(
 	aead_request_set_ad(req, header_len);
 	aead_request_set_crypt(req, sg, sg, data_len, iv);
 
-	r = crypto_wait_req(crypto_aead_encrypt(req), &wait);
-
-end:
-	aead_request_free(req);
-
-	return r;
+	return crypto_wait_req(crypto_aead_encrypt(req), &wait);
 }
 
 int mcps_crypto_aead_aes_ccm_star_128_decrypt(
@@ -185,11 +185,10 @@ int mcps_crypto_aead_aes_ccm_star_128_decrypt(
 		uint8_t *data, unsigned int data_len,
 		uint8_t *mac, unsigned int mac_len)
 {
-	struct aead_request *req = NULL;
+	struct aead_request *req;
 	struct scatterlist sg[3];
 	u8 iv[AES_BLOCK_SIZE];
 	DECLARE_CRYPTO_WAIT(wait);
-	int r = -1;
 
 	if (!ctx || !nonce || !header || header_len <= 0 || !data ||
 			data_len <= 0 || !mac ||
@@ -197,11 +196,7 @@ int mcps_crypto_aead_aes_ccm_star_128_decrypt(
 		return -EINVAL;
 	}
 
-	req = aead_request_alloc(ctx->tfm, GFP_KERNEL);
-	if (!req) {
-		r = -ENOMEM;
-		goto end;
-	}
+	req = ctx->req;
 
 	iv[0] = sizeof(u16) - 1;
 	memcpy(iv + 1, nonce, MCPS_CRYPTO_AES_CCM_STAR_NONCE_LEN);
@@ -217,12 +212,7 @@ int mcps_crypto_aead_aes_ccm_star_128_decrypt(
 	aead_request_set_ad(req, header_len);
 	aead_request_set_crypt(req, sg, sg, data_len + mac_len, iv);
 
-	r = crypto_wait_req(crypto_aead_decrypt(req), &wait);
-
-end:
-	aead_request_free(req);
-
-	return r;
+	return crypto_wait_req(crypto_aead_decrypt(req), &wait);
 }
 
 struct mcps_aes_ecb_128_ctx *mcps_crypto_aes_ecb_128_create(void)
@@ -238,9 +228,14 @@ struct mcps_aes_ecb_128_ctx *mcps_crypto_aes_ecb_128_create(void)
 		if (PTR_ERR(ctx->tfm) == -ENOENT)
 			pr_err("The crypto transform ecb(aes) seems to be missing."
 			       " Please check your kernel configuration.\n");
+		ctx->tfm = NULL;
 		goto error;
 	}
 
+	ctx->req = skcipher_request_alloc(ctx->tfm, GFP_KERNEL);
+	if (!ctx->req)
+		goto error;
+
 	return ctx;
 
 error:
@@ -276,6 +271,7 @@ void mcps_crypto_aes_ecb_128_destroy(struct mcps_aes_ecb_128_ctx *ctx)
 	if (!ctx)
 		return;
 
+	skcipher_request_free(ctx->req);
 	crypto_free_skcipher(ctx->tfm);
 	kfree(ctx);
 }
@@ -283,10 +279,10 @@ void mcps_crypto_aes_ecb_128_destroy(struct mcps_aes_ecb_128_ctx *ctx)
 int mcps_crypto_aes_ecb_128_encrypt(struct mcps_aes_ecb_128_ctx *ctx,
 		const uint8_t *data, unsigned int data_len, uint8_t *out)
 {
-	struct skcipher_request *req = NULL;
+	struct skcipher_request *req;
 	struct scatterlist sgin, sgout;
 	DECLARE_CRYPTO_WAIT(wait);
-	int r = -1;
+	int r;
 
 	if (!ctx || !data || data_len <= 0 || !out)
 		return -EINVAL;
@@ -294,11 +290,7 @@ int mcps_crypto_aes_ecb_128_encrypt(struct mcps_aes_ecb_128_ctx *ctx,
 	/* round to full cipher block */
 	data_len = ((data_len - 1) & -AES_KEYSIZE_128) + AES_KEYSIZE_128;
 
-	req = skcipher_request_alloc(ctx->tfm, GFP_KERNEL);
-	if (!req) {
-		r = -ENOMEM;
-		goto end;
-	}
+	req = ctx->req;
 
 	sg_init_one(&sgin, data, data_len);
 	sg_init_one(&sgout, out, data_len);
@@ -311,11 +303,6 @@ int mcps_crypto_aes_ecb_128_encrypt(struct mcps_aes_ecb_128_ctx *ctx,
 		r = crypto_skcipher_decrypt(req);
 	else
 		r = crypto_skcipher_encrypt(req);
-	r = crypto_wait_req(r, &wait);
-
-end:
-	skcipher_request_free(req);
-
-	return r;
+	return crypto_wait_req(r, &wait);
 }
 
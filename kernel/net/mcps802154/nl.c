@@ -685,6 +685,95 @@ finish:
 	return 0;
 }
 
+/**
+ * mcps802154_nl_set_calibration_list() - Set a list of calibration values.
+ * @local: MCPS private data.
+ * @list: Nested calibration values.
+ * @extack: Extended ACK report structure.
+ * @failed_key: Set to the key of the failing value on error, left untouched
+ * if the error is not related to a value.
+ *
+ * Values are given to the low-level driver in a single call when it supports
+ * it, so that its configuration is updated once. Values with an invalid
+ * format or without key are ignored, setting stops on the first error.
+ *
+ * Return: 0 or error.
+ */
+static int mcps802154_nl_set_calibration_list(struct mcps802154_local *local,
+					      const struct nlattr *list,
+					      struct netlink_ext_ack *extack,
+					      const char **failed_key)
+{
+	struct nlattr *attrs[MCPS802154_CALIBRATIONS_ATTR_MAX + 1];
+	struct mcps802154_calibration *calibrations;
+	const char *missing_value_key = NULL;
+	struct nlattr *input;
+	int n_calibrations = 0;
+	int n_set = 0;
+	int rem;
+	int r = 0;
+
+	nla_for_each_nested (input, list, rem)
+		n_calibrations++;
+	if (!n_calibrations)
+		return 0;
+	calibrations = kmalloc_array(n_calibrations, sizeof(*calibrations),
+				     GFP_KERNEL);
+	if (!calibrations)
+		return -ENOMEM;
+
+	n_calibrations = 0;
+	nla_for_each_nested (input, list, rem) {
+		struct mcps802154_calibration *calibration;
+		char *key;
+
+		if (nla_parse_nested(attrs, MCPS802154_CALIBRATIONS_ATTR_MAX,
+				     input, mcps802154_nl_calibration_policy,
+				     extack))
+			continue;
+		if (!attrs[MCPS802154_CALIBRATIONS_ATTR_KEY])
+			continue;
+		key = nla_data(attrs[MCPS802154_CALIBRATIONS_ATTR_KEY]);
+		if (!attrs[MCPS802154_CALIBRATIONS_ATTR_VALUE]) {
+			/* Set the previous values, then report this one. */
+			missing_value_key = key;
+			break;
+		}
+		calibration = &calibrations[n_calibrations++];
+		calibration->key = key;
+		calibration->value =
+			nla_data(attrs[MCPS802154_CALIBRATIONS_ATTR_VALUE]);
+		calibration->length =
+			nla_len(attrs[MCPS802154_CALIBRATIONS_ATTR_VALUE]);
+	}
+
+	if (n_calibrations && local->ops->set_calibrations) {
+		r = llhw_set_calibrations(local, calibrations, n_calibrations,
+					  &n_set);
+	} else {
+		for (n_set = 0; n_set < n_calibrations; n_set++) {
+			struct mcps802154_calibration *calibration =
+				&calibrations[n_set];
+
+			r = llhw_set_calibration(local, calibration->key,
+						 calibration->value,
+						 calibration->length);
+			if (r < 0)
+				break;
+		}
+	}
+	if (r < 0) {
+		if (n_set < n_calibrations)
+			*failed_key = calibrations[n_set].key;
+	} else if (missing_value_key) {
+		*failed_key = missing_value_key;
+		r = -EINVAL;
+	}
+
+	kfree(calibrations);
+	return r;
+}
+
 /**
  * mcps802154_nl_set_calibration() - Set calibrations parameters.
  * @skb: Request message.
@@ -721,46 +810,27 @@ static int mcps802154_nl_set_calibration(struct sk_buff *skb,
 	}
 
 	if (info->attrs[MCPS802154_ATTR_CALIBRATIONS]) {
-		struct nlattr *attrs[MCPS802154_CALIBRATIONS_ATTR_MAX + 1];
-		struct nlattr *calibrations, *input;
-		int rem;
-
-		nla_for_each_nested (
-			input, info->attrs[MCPS802154_ATTR_CALIBRATIONS], rem) {
-			char *key;
-			int r;
-
-			r = nla_parse_nested(
-				attrs, MCPS802154_CALIBRATIONS_ATTR_MAX, input,
-				mcps802154_nl_calibration_policy, info->extack);
-			if (r)
-				continue;
-
-			if (!attrs[MCPS802154_CALIBRATIONS_ATTR_KEY])
-				continue;
-			key = nla_data(attrs[MCPS802154_CALIBRATIONS_ATTR_KEY]);
-
-			if (!attrs[MCPS802154_CALIBRATIONS_ATTR_VALUE])
-				r = -EINVAL;
-			else {
-				struct nlattr *value;
-
-				value = attrs[MCPS802154_CALIBRATIONS_ATTR_VALUE];
-				r = llhw_set_calibration(local, key,
-							 nla_data(value),
-							 nla_len(value));
-			}
-			if (r < 0) {
-				calibrations = nla_nest_start(
-					msg, MCPS802154_ATTR_CALIBRATIONS);
-				/* Put the result in the response message. */
-				err = mcps802154_nl_put_calibration(
-					msg, key, r, NULL, false);
-				if (err)
-					goto nla_put_failure;
-				nla_nest_end(msg, calibrations);
-				break;
-			}
+		struct nlattr *calibrations;
+		const char *key = NULL;
+		int r;
+
+		r = mcps802154_nl_set_calibration_list(
+			local, info->attrs[MCPS802154_ATTR_CALIBRATIONS],
+			info->extack, &key);
+		if (r < 0 && !key) {
+			/* No value to report the error for. */
+			err = r;
+			goto nla_put_failure;
+		}
+		if (r < 0) {
+			calibrations =
+				nla_nest_start(msg, MCPS802154_ATTR_CALIBRATIONS);
+			/* Put the result in the response message. */
+			err = mcps802154_nl_put_calibration(msg, key, r, NULL,
+							    false);
+			if (err)
+				goto nla_put_failure;
+			nla_nest_end(msg, calibrations);
 		}
 	}
 
@@ -43,7 +43,7 @@ static void mcps802154_ca_close_scheduler(struct mcps802154_local *local)
 	struct mcps802154_ca *ca = &local->ca;
 	struct list_head *regions = &ca->regions;
 
-	mcps802154_schedule_clear(local);
+	mcps802154_schedule_free(local);
 	if (local->ca.scheduler) {
 		mcps802154_scheduler_close(local->ca.scheduler);
 		local->ca.scheduler = NULL;
@@ -91,6 +91,7 @@ void mcps802154_ca_init(struct mcps802154_local *local)
 
 void mcps802154_ca_uninit(struct mcps802154_local *local)
 {
+	mcps802154_schedule_free(local);
 }
 
 int mcps802154_ca_start(struct mcps802154_local *local)
@@ -211,6 +212,7 @@ int mcps802154_ca_set_region(struct mcps802154_local *local,
 		list_add(&region->ca_entry, position);
 		ca->n_regions++;
 	}
+	mcps802154_scheduler_notify_change(scheduler);
 
 	return mcps802154_ca_trace_int(local, 0);
 }
@@ -272,6 +274,7 @@ int mcps802154_ca_set_region_parameters(struct mcps802154_local *local,
 
 	r = mcps802154_region_set_parameters(&local->llhw, region, params_attr,
 					     extack);
+	mcps802154_scheduler_notify_change(local->ca.scheduler);
 
 end:
 	return mcps802154_ca_trace_int(local, r);
@@ -296,6 +299,7 @@ int mcps802154_ca_call_region(struct mcps802154_local *local,
 
 	r = mcps802154_region_call(&local->llhw, region, call_id, params_attr,
 				   info);
+	mcps802154_scheduler_notify_change(local->ca.scheduler);
 
 end:
 	return mcps802154_ca_trace_int(local, r);
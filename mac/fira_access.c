@@ -158,6 +158,9 @@ static void fira_access_setup_frame(struct fira_local *local,
 				.ant_set_id = slot->tx_ant_set,
 			},
 			.sts_params = sts_params_for_access,
+			/* Final frame has no payload, it can be built while
+			 * receiving the responses. */
+			.tx_prepare_early = is_last_rframe,
 		};
 	} else {
 		u8 flags = MCPS802154_RX_FRAME_CONFIG_TIMESTAMP_DTU;
@@ -310,17 +313,48 @@ failed:
 	return NULL;
 }
 
+static bool
+fira_diagnostic_cirs_arena(const struct fira_local *local,
+			   struct fira_session *session, int slot_idx,
+			   struct fira_diagnostic *diagnostic)
+{
+	const struct mcps802154_llhw *llhw = local->llhw;
+	struct fira_session_round *round = &session->round;
+	int n_cirs = FIRA_FRAMES_N(round->n_controlees_max) * llhw->cir_n_max;
+	u8 *samples;
+	int i;
+
+	if (!round->diagnostic_cirs)
+		return false;
+
+	/* CIR of all frames first, then all sample windows. */
+	diagnostic->cirs = &round->diagnostic_cirs[slot_idx * llhw->cir_n_max];
+	samples = (u8 *)&round->diagnostic_cirs[n_cirs] +
+		  slot_idx * llhw->cir_n_max * llhw->cir_window_size_max;
+	for (i = 0; i < llhw->cir_n_max; i++)
+		diagnostic->cirs[i].sample_window.samples =
+			samples + i * llhw->cir_window_size_max;
+	diagnostic->cirs_allocated = false;
+	return true;
+}
+
 static void
 fira_diagnostic_cirs_copy(const struct mcps802154_rx_measurement_info *info,
-			  struct fira_diagnostic *diagnostic)
+			  struct fira_diagnostic *diagnostic, int n_cirs_max,
+			  int window_size_max)
 {
+	int n_cirs = info->n_cirs;
 	int i;
 
-	for (i = 0; i < info->n_cirs; i++) {
+	if (WARN_ON_ONCE(n_cirs > n_cirs_max))
+		n_cirs = n_cirs_max;
+
+	for (i = 0; i < n_cirs; i++) {
 		struct mcps802154_rx_cir *cir_in;
 		struct mcps802154_rx_cir *cir_out;
 		struct mcps802154_rx_cir_sample_window *si;
 		struct mcps802154_rx_cir_sample_window *so;
+		u16 n_samples;
 
 		cir_out = &diagnostic->cirs[i];
 		cir_in = &info->cirs[i];
@@ -334,25 +368,42 @@ fira_diagnostic_cirs_copy(const struct mcps802154_rx_measurement_info *info,
 		cir_out->pp_snr = cir_in->pp_snr;
 		cir_out->pp_ns_q6 = cir_in->pp_ns_q6;
 		cir_out->fp_sample_offset = cir_in->fp_sample_offset;
-		so->n_samples = si->n_samples;
+		n_samples = si->n_samples;
+		if (WARN_ON_ONCE(n_samples * si->sizeof_sample >
+				 window_size_max))
+			n_samples = window_size_max / si->sizeof_sample;
+		so->n_samples = n_samples;
 		so->sizeof_sample = si->sizeof_sample;
 
-		memcpy(so->samples, si->samples,
-		       si->n_samples * si->sizeof_sample);
+		memcpy(so->samples, si->samples, n_samples * si->sizeof_sample);
 	}
 	diagnostic->n_cirs = i;
 }
 
 static void
-fira_diagnostic_cirs(const struct mcps802154_rx_measurement_info *info,
+fira_diagnostic_cirs(const struct fira_local *local,
+		     struct fira_session *session, int slot_idx,
+		     const struct mcps802154_rx_measurement_info *info,
 		     struct fira_diagnostic *diagnostic)
 {
-	if (info->flags & MCPS802154_RX_MEASUREMENTS_CIRS) {
-		diagnostic->cirs = fira_diagnostic_cirs_alloc(info);
-		if (diagnostic->cirs)
-			fira_diagnostic_cirs_copy(info, diagnostic);
-		else
-			diagnostic->n_cirs = 0;
+	if (!(info->flags & MCPS802154_RX_MEASUREMENTS_CIRS))
+		return;
+
+	if (fira_diagnostic_cirs_arena(local, session, slot_idx, diagnostic)) {
+		fira_diagnostic_cirs_copy(info, diagnostic,
+					  local->llhw->cir_n_max,
+					  local->llhw->cir_window_size_max);
+		return;
+	}
+
+	/* Low-level driver without CIR limits, allocate for this frame. */
+	diagnostic->cirs = fira_diagnostic_cirs_alloc(info);
+	if (diagnostic->cirs) {
+		diagnostic->cirs_allocated = true;
+		fira_diagnostic_cirs_copy(info, diagnostic, info->n_cirs,
+					  INT_MAX);
+	} else {
+		diagnostic->n_cirs = 0;
 	}
 }
 
@@ -383,7 +434,7 @@ static void fira_diagnostic(struct fira_local *local,
 		return;
 
 	fira_diagnostic_rssis(&info, diagnostic);
-	fira_diagnostic_cirs(&info, diagnostic);
+	fira_diagnostic_cirs(local, session, slot_idx, &info, diagnostic);
 }
 
 static void fira_diagnostic_free(struct fira_local *local)
@@ -394,12 +445,16 @@ static void fira_diagnostic_free(struct fira_local *local)
 		struct fira_diagnostic *diagnostic = &local->diagnostics[i];
 		int j;
 
-		for (j = 0; j < diagnostic->n_cirs; j++)
-			kfree(diagnostic->cirs[j].sample_window.samples);
+		if (diagnostic->cirs_allocated) {
+			for (j = 0; j < diagnostic->n_cirs; j++)
+				kfree(diagnostic->cirs[j].sample_window.samples);
 
-		kfree(diagnostic->cirs);
+			kfree(diagnostic->cirs);
+		}
+		/* Arena CIR are kept in the session round state. */
 		diagnostic->cirs = NULL;
 		diagnostic->n_cirs = 0;
+		diagnostic->cirs_allocated = false;
 	}
 }
 
@@ -556,7 +611,7 @@ static void fira_rx_frame_control(struct fira_local *local,
 	fira_controlee_resync(session, phy_sts_index, info->timestamp_dtu);
 
 	params = &session->params;
-	ri->rx_ctx = session->rx_ctx[0];
+	ri->rx_ctx = session->round.rx_ctx[0];
 
 	header_len = skb->data - header;
 	src_short_addr = slot->controller_tx ? local->dst_short_addr :
@@ -783,7 +838,8 @@ static struct sk_buff *fira_tx_get_frame(struct mcps802154_access *access,
 	    slot->message_id <= FIRA_MESSAGE_ID_RFRAME_MAX)
 		return NULL;
 
-	skb = mcps802154_frame_alloc(local->llhw, IEEE802154_MTU, GFP_KERNEL);
+	skb = mcps802154_frame_alloc(local->llhw, fira_frame_max_len(local, session),
+				     GFP_KERNEL);
 	if (!skb)
 		return NULL;
 
@@ -1008,7 +1064,7 @@ fira_get_access_controller(struct fira_local *local,
 			if (!fira_session_controlee_active(controlee))
 				continue;
 			ri->short_addr = controlee->short_addr;
-			ri->rx_ctx = session->rx_ctx[i];
+			ri->rx_ctx = session->round.rx_ctx[i];
 			/* Requested in fira_report_aoa function. */
 			ri++;
 			s->index = index++;
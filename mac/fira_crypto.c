@@ -29,6 +29,7 @@
 #include <linux/string.h>
 #include <linux/kernel.h>
 #include <linux/list.h>
+#include <linux/hashtable.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
 #include <crypto/aes.h>
@@ -61,8 +62,27 @@ static inline void platform_free(void *p) { kfree(p); }
 
 #define FIRA_CRYPTO_AEAD_AUTHSIZE	8
 
+#define FIRA_CRYPTO_CTX_HASH_BITS	4
+
+/* Number of rotations kept in the derived elements cache. */
+#define FIRA_CRYPTO_DERIVED_CACHE_SIZE	2
+
+struct fira_crypto_ctx;
+
+/**
+ * struct fira_crypto - Handle given to the FiRa region.
+ */
 struct fira_crypto {
+	/**
+	 * @session_id: Id of the session using the fira_crypto.
+	 */
 	u32 session_id;
+
+	/**
+	 * @ctx: Crypto context owned by this handle, used directly by all
+	 * crypto operations without any lookup.
+	 */
+	struct fira_crypto_ctx *ctx;
 };
 
 /**
@@ -128,6 +148,36 @@ struct fira_crypto_base {
 	struct fira_crypto_aead aead;
 };
 
+/**
+ * struct fira_crypto_derived - Elements derived for one crypto STS index.
+ */
+struct fira_crypto_derived {
+	/**
+	 * @crypto_sts_index: Crypto STS index used for the derivation.
+	 */
+	u32 crypto_sts_index;
+
+	/**
+	 * @valid: True if the entry contains derived elements.
+	 */
+	bool valid;
+
+	/**
+	 * @derived_authentication_iv: See &struct fira_crypto_base.
+	 */
+	u8 derived_authentication_iv[AES_BLOCK_SIZE];
+
+	/**
+	 * @derived_authentication_key: See &struct fira_crypto_base.
+	 */
+	u8 derived_authentication_key[FIRA_KEY_SIZE_MIN];
+
+	/**
+	 * @derived_payload_key: See &struct fira_crypto_base.
+	 */
+	u8 derived_payload_key[FIRA_KEY_SIZE_MIN];
+};
+
 struct fira_crypto_ctx {
 	/**
 	 * @session_id: Id of the session using the fira_crypto.
@@ -136,9 +186,10 @@ struct fira_crypto_ctx {
 	u32 session_id;
 
 	/**
-	 * @ca_entry: Entry in list .
+	 * @node: Entry in contexts hashtable, unhashed when the context is
+	 * replaced by a newer one with the same session id.
 	 */
-	struct list_head entry;
+	struct hlist_node node;
 
 	/**
 	 * @sts_config: The type of STS requested for this crypto.
@@ -150,12 +201,30 @@ struct fira_crypto_ctx {
 	 */
 	struct fira_crypto_base base;
 
+	/**
+	 * @derived_cache: Elements derived ahead of the next rotations, so
+	 * that the KDF does not run when the rotation happens.
+	 */
+	struct fira_crypto_derived derived_cache[FIRA_CRYPTO_DERIVED_CACHE_SIZE];
+
+	/**
+	 * @derived_cache_next: Next entry of @derived_cache to replace.
+	 */
+	int derived_cache_next;
+
 	/******* Dynamic STS Only **************/
 
 	/**
-	 * @ecb_ctx: AES ECB context
+	 * @ecb_encrypt_ctx: AES ECB context used to encrypt HIE, keyed once
+	 * with the privacy key.
 	 */
-	struct mcps_aes_ecb_128_ctx *ecb_ctx;
+	struct mcps_aes_ecb_128_ctx *ecb_encrypt_ctx;
+
+	/**
+	 * @ecb_decrypt_ctx: AES ECB context used to decrypt HIE, keyed once
+	 * with the privacy key.
+	 */
+	struct mcps_aes_ecb_128_ctx *ecb_decrypt_ctx;
 
 	/**
 	 * @privacy_key: Derived from the session key, the label
@@ -170,7 +239,10 @@ struct fira_crypto_ctx {
 	u8 vupper64[FIRA_VUPPER64_SIZE];
 };
 
-static LIST_HEAD(fira_crypto_ctx_list);
+/* Contexts by session id, only used on context creation and removal. */
+static DEFINE_HASHTABLE(fira_crypto_ctx_table, FIRA_CRYPTO_CTX_HASH_BITS);
+/* Protect fira_crypto_ctx_table. */
+static DEFINE_MUTEX(fira_crypto_ctx_lock);
 
 static int fira_crypto_kdf(const u8 *input_key, unsigned int input_key_len,
 			const char *label, const u8 *context, u8 *output_key,
@@ -290,6 +362,25 @@ static void fira_crypto_aead_destroy(struct fira_crypto_aead *aead)
 	mcps_crypto_aead_aes_ccm_star_128_destroy(aead->ctx);
 }
 
+static int fira_crypto_ecb_setup(struct fira_crypto_ctx *fira_crypto_ctx)
+{
+	fira_crypto_ctx->ecb_encrypt_ctx = mcps_crypto_aes_ecb_128_create();
+	fira_crypto_ctx->ecb_decrypt_ctx = mcps_crypto_aes_ecb_128_create();
+	if (!fira_crypto_ctx->ecb_encrypt_ctx ||
+	    !fira_crypto_ctx->ecb_decrypt_ctx)
+		return -ENOMEM;
+
+	if (mcps_crypto_aes_ecb_128_set_encrypt(
+		    fira_crypto_ctx->ecb_encrypt_ctx,
+		    fira_crypto_ctx->privacy_key) ||
+	    mcps_crypto_aes_ecb_128_set_decrypt(
+		    fira_crypto_ctx->ecb_decrypt_ctx,
+		    fira_crypto_ctx->privacy_key))
+		return -EINVAL;
+
+	return 0;
+}
+
 /*! ----------------------------------------------------------------------------------------------
  * @brief This function returns the fira crypto context relative to a sessionID
  *
@@ -299,12 +390,15 @@ static void fira_crypto_aead_destroy(struct fira_crypto_aead *aead)
  * output parameters
  *
  * return NULL if error or struct fira_crypto_ctx pointer.
+ *
+ * NOTE: fira_crypto_ctx_lock must be held.
  */
-struct fira_crypto_ctx *get_session(u32 session_id)
+static struct fira_crypto_ctx *__get_session(u32 session_id)
 {
 	struct fira_crypto_ctx *session;
 
-	list_for_each_entry(session, &fira_crypto_ctx_list, entry) {
+	hash_for_each_possible(fira_crypto_ctx_table, session, node,
+			       session_id) {
 		if (session->session_id == session_id)
 			return session;
 	}
@@ -312,11 +406,25 @@ struct fira_crypto_ctx *get_session(u32 session_id)
 	return NULL;
 }
 
+static struct fira_crypto_ctx *get_session(u32 session_id)
+{
+	struct fira_crypto_ctx *session;
+
+	mutex_lock(&fira_crypto_ctx_lock);
+	session = __get_session(session_id);
+	mutex_unlock(&fira_crypto_ctx_lock);
+	return session;
+}
+
 static void remove_session(struct fira_crypto_ctx *session)
 {
+	mutex_lock(&fira_crypto_ctx_lock);
+	if (hash_hashed(&session->node))
+		hash_del(&session->node);
+	mutex_unlock(&fira_crypto_ctx_lock);
 	fira_crypto_aead_destroy(&session->base.aead);
-	mcps_crypto_aes_ecb_128_destroy(session->ecb_ctx);
-	list_del(&session->entry);
+	mcps_crypto_aes_ecb_128_destroy(session->ecb_encrypt_ctx);
+	mcps_crypto_aes_ecb_128_destroy(session->ecb_decrypt_ctx);
 	/* Wipe all derived keys */
 	memzero_explicit(session, sizeof(*session));
 	platform_free(session);
@@ -351,25 +459,18 @@ int fira_crypto_context_init(const struct fira_crypto_params *params,
 	int r;
 	struct fira_crypto *fira_crypto_ext;
 	struct fira_crypto_ctx *fira_crypto_ctx;
+	struct fira_crypto_ctx *old_ctx;
 	u8 session_key[AES_KEYSIZE_128];
 
-	/* checks the sessionId is not already allocated */
-	fira_crypto_ctx = get_session(params->session_id);
-	if (fira_crypto_ctx) {
-		pr_err("Crypto context already exists for session id %u\n", params->session_id);
-		/* Remove the context */
-		remove_session(fira_crypto_ctx);
-	}
-
 	fira_crypto_ext = platform_malloc(sizeof(*fira_crypto_ext));
 	memset(fira_crypto_ext, 0, sizeof(*fira_crypto_ext));
 	fira_crypto_ctx = platform_malloc(sizeof(*fira_crypto_ctx));
 	memset(fira_crypto_ctx, 0, sizeof(*fira_crypto_ctx));
 	if (fira_crypto_ctx && fira_crypto_ext) {
 		fira_crypto_ctx->session_id = params->session_id;
+		INIT_HLIST_NODE(&fira_crypto_ctx->node);
 		fira_crypto_ext->session_id = params->session_id;
-		/* Add this context in the global list */
-		list_add(&fira_crypto_ctx->entry, &fira_crypto_ctx_list);
+		fira_crypto_ext->ctx = fira_crypto_ctx;
 		status = 0;
 	} else {
 		pr_err("Crypto context initialisation failed. Not enough memory !\n");
@@ -451,7 +552,10 @@ int fira_crypto_context_init(const struct fira_crypto_params *params,
 					fira_crypto_ctx->base.config_digest,
 					fira_crypto_ctx->privacy_key,
 					FIRA_KEY_SIZE_MIN);
+			if (r)
+				goto error_out;
 
+			r = fira_crypto_ecb_setup(fira_crypto_ctx);
 		}
 		if (r)
 			goto error_out;
@@ -460,6 +564,18 @@ int fira_crypto_context_init(const struct fira_crypto_params *params,
 	/* Wipe session key */
 	memzero_explicit(session_key, AES_KEYSIZE_128);
 
+	/* Add this context in the global table */
+	mutex_lock(&fira_crypto_ctx_lock);
+	old_ctx = __get_session(params->session_id);
+	if (old_ctx) {
+		pr_err("Crypto context already exists for session id %u\n", params->session_id);
+		/* Replace it, it stays owned by its handle until deinit */
+		hash_del(&old_ctx->node);
+	}
+	hash_add(fira_crypto_ctx_table, &fira_crypto_ctx->node,
+		 params->session_id);
+	mutex_unlock(&fira_crypto_ctx_lock);
+
 	*crypto = fira_crypto_ext;
 
 	return status;
@@ -480,7 +596,7 @@ error_out:
 void fira_crypto_context_deinit(struct fira_crypto *crypto)
 {
 	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 
 	if (fira_crypto_ctx) {
 		/* Remove the context */
@@ -492,64 +608,148 @@ void fira_crypto_context_deinit(struct fira_crypto *crypto)
 	platform_free(crypto);
 }
 
-/**
- * fira_crypto_rotate_elements() - Rotate the crypto elements contained in the
- * crypto context.
- *
- * NOTE: After calling this function, all active crypto elements will be the latest
- * rotated ones.
- *
- * @crypto: The context containing the elements to rotate.
- * @crypto_sts_index: The crypto STS index to use to rotate the elements.
- *
- * Return: 0 or error.
- */
-int fira_crypto_rotate_elements(struct fira_crypto *crypto,
-				const u32 crypto_sts_index)
+static struct fira_crypto_derived *
+fira_crypto_derived_lookup(struct fira_crypto_ctx *fira_crypto_ctx,
+			   u32 crypto_sts_index)
 {
-	int r = 0;
+	struct fira_crypto_derived *derived;
+	int i;
+
+	for (i = 0; i < FIRA_CRYPTO_DERIVED_CACHE_SIZE; i++) {
+		derived = &fira_crypto_ctx->derived_cache[i];
+		if (derived->valid &&
+		    derived->crypto_sts_index == crypto_sts_index)
+			return derived;
+	}
+
+	return NULL;
+}
+
+static int fira_crypto_derive_elements(struct fira_crypto_ctx *fira_crypto_ctx,
+				       u32 crypto_sts_index,
+				       struct fira_crypto_derived *derived)
+{
+	const struct fira_crypto_base *base = &fira_crypto_ctx->base;
 	u8 context[AES_BLOCK_SIZE];
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	int r;
 
-	memcpy(context, fira_crypto_ctx->base.config_digest + sizeof(u32),
+	memzero_explicit(derived, sizeof(*derived));
+
+	memcpy(context, base->config_digest + sizeof(u32),
 			AES_BLOCK_SIZE - sizeof(u32));
 	put_unaligned_be32(crypto_sts_index, context + AES_BLOCK_SIZE -
 			sizeof(u32));
 
-	r = fira_crypto_kdf(fira_crypto_ctx->base.data_protection_key,
-			fira_crypto_ctx->base.key_size,
+	r = fira_crypto_kdf(base->data_protection_key, base->key_size,
 			"DerAuthI", context,
-			fira_crypto_ctx->base.derived_authentication_iv,
-			fira_crypto_ctx->base.key_size);
+			derived->derived_authentication_iv, base->key_size);
 	if (r)
 		goto error_out;
 
-	r = fira_crypto_kdf(fira_crypto_ctx->base.data_protection_key,
-			fira_crypto_ctx->base.key_size,
+	r = fira_crypto_kdf(base->data_protection_key, base->key_size,
 			"DerAuthK", context,
-			fira_crypto_ctx->base.derived_authentication_key,
-			fira_crypto_ctx->base.key_size);
+			derived->derived_authentication_key, base->key_size);
 	if (r)
 		goto error_out;
 
-	r = fira_crypto_kdf(fira_crypto_ctx->base.data_protection_key,
-			fira_crypto_ctx->base.key_size,
+	r = fira_crypto_kdf(base->data_protection_key, base->key_size,
 			"DerPaylK", context,
-			fira_crypto_ctx->base.derived_payload_key,
-			fira_crypto_ctx->base.key_size);
+			derived->derived_payload_key, base->key_size);
 	if (r)
 		goto error_out;
 
-	if (fira_crypto_ctx->base.aead.ctx == NULL)
-		r = fira_crypto_aead_set_key(&fira_crypto_ctx->base.aead,
-				fira_crypto_ctx->base.derived_payload_key);
+	derived->crypto_sts_index = crypto_sts_index;
+	derived->valid = true;
 
 error_out:
+	if (r)
+		memzero_explicit(derived, sizeof(*derived));
 	memzero_explicit(context, sizeof(context));
 	return r;
 }
 
+/**
+ * fira_crypto_rotate_elements() - Rotate the crypto elements contained in the
+ * crypto context.
+ *
+ * NOTE: After calling this function, all active crypto elements will be the latest
+ * rotated ones.
+ *
+ * @crypto: The context containing the elements to rotate.
+ * @crypto_sts_index: The crypto STS index to use to rotate the elements.
+ *
+ * Return: 0 or error.
+ */
+int fira_crypto_rotate_elements(struct fira_crypto *crypto,
+				const u32 crypto_sts_index)
+{
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
+	struct fira_crypto_base *base = &fira_crypto_ctx->base;
+	struct fira_crypto_derived *derived;
+	struct fira_crypto_derived tmp;
+	int r = 0;
+
+	derived = fira_crypto_derived_lookup(fira_crypto_ctx, crypto_sts_index);
+	if (!derived) {
+		/* Not prefetched, derive now. */
+		r = fira_crypto_derive_elements(fira_crypto_ctx,
+						crypto_sts_index, &tmp);
+		if (r)
+			goto error_out;
+		derived = &tmp;
+	}
+
+	memcpy(base->derived_authentication_iv,
+	       derived->derived_authentication_iv, AES_BLOCK_SIZE);
+	memcpy(base->derived_authentication_key,
+	       derived->derived_authentication_key, base->key_size);
+	memcpy(base->derived_payload_key, derived->derived_payload_key,
+	       base->key_size);
+
+	if (base->aead.ctx == NULL)
+		r = fira_crypto_aead_set_key(&base->aead,
+					     base->derived_payload_key);
+
+error_out:
+	memzero_explicit(&tmp, sizeof(tmp));
+	return r;
+}
+
+/**
+ * fira_crypto_prefetch_elements() - Derive the crypto elements of a future
+ * rotation.
+ *
+ * NOTE: The derived elements are kept in the crypto context cache and used by
+ * fira_crypto_rotate_elements() when called with the same crypto STS index.
+ *
+ * @crypto: The context containing the elements to derive.
+ * @crypto_sts_index: The crypto STS index of the future rotation.
+ *
+ * Return: 0 or error.
+ */
+int fira_crypto_prefetch_elements(struct fira_crypto *crypto,
+				  const u32 crypto_sts_index)
+{
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
+	struct fira_crypto_derived *derived;
+	int r;
+
+	if (fira_crypto_derived_lookup(fira_crypto_ctx, crypto_sts_index))
+		return 0;
+
+	derived = &fira_crypto_ctx->derived_cache[
+		fira_crypto_ctx->derived_cache_next];
+	r = fira_crypto_derive_elements(fira_crypto_ctx, crypto_sts_index,
+					derived);
+	if (r)
+		return r;
+	fira_crypto_ctx->derived_cache_next =
+		(fira_crypto_ctx->derived_cache_next + 1) %
+		FIRA_CRYPTO_DERIVED_CACHE_SIZE;
+
+	return 0;
+}
+
 /**
  * fira_crypto_build_phy_sts_index_init() - Build the phy STS index init value
  * related to the given crypto context.
@@ -562,8 +762,7 @@ error_out:
 int fira_crypto_build_phy_sts_index_init(struct fira_crypto *crypto,
 					 u32 *phy_sts_index_init)
 {
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 	int r;
 	u8 phy_sts_index_init_tmp[AES_KEYSIZE_128];
 
@@ -604,8 +803,7 @@ int fira_crypto_get_sts_params(struct fira_crypto *crypto,
 		const u32 crypto_sts_index, u8 *sts_v, u32 sts_v_size,
 		u8 *sts_key, u32 sts_key_size)
 {
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 	u8 *vupper64 = NULL;
 	u32 v_counter;
 	u8 *sts_v_temp;
@@ -663,8 +861,7 @@ int fira_crypto_get_sts_params(struct fira_crypto *crypto,
 int fira_crypto_encrypt_frame(struct fira_crypto *crypto, struct sk_buff *skb,
 		int header_len, __le16 src_short_addr, u32 crypto_sts_index)
 {
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 
 	return fira_crypto_aead_encrypt(&fira_crypto_ctx->base.aead, skb, header_len,
 					src_short_addr, crypto_sts_index);
@@ -695,8 +892,7 @@ int fira_crypto_encrypt_frame(struct fira_crypto *crypto, struct sk_buff *skb,
 int fira_crypto_decrypt_frame(struct fira_crypto *crypto, struct sk_buff *skb,
 		int header_len, __le16 src_short_addr, u32 crypto_sts_index)
 {
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 
 	return fira_crypto_aead_decrypt(&fira_crypto_ctx->base.aead, skb, header_len,
 					src_short_addr, crypto_sts_index);
@@ -714,21 +910,13 @@ int fira_crypto_decrypt_frame(struct fira_crypto *crypto, struct sk_buff *skb,
 int fira_crypto_encrypt_hie(struct fira_crypto *crypto, struct sk_buff *skb,
 		int hie_offset, int hie_len)
 {
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 	int rc;
 
 	if (fira_crypto_ctx->sts_config == FIRA_STS_MODE_STATIC)
 		return 0;
 
-	fira_crypto_ctx->ecb_ctx = mcps_crypto_aes_ecb_128_create();
-	if (!fira_crypto_ctx->ecb_ctx ||
-		mcps_crypto_aes_ecb_128_set_encrypt(
-			fira_crypto_ctx->ecb_ctx,
-			fira_crypto_ctx->privacy_key))
-		return -1;
-
-	rc = mcps_crypto_aes_ecb_128_encrypt(fira_crypto_ctx->ecb_ctx,
+	rc = mcps_crypto_aes_ecb_128_encrypt(fira_crypto_ctx->ecb_encrypt_ctx,
 			(const uint8_t *)(skb->data + hie_offset +
 				IEEE802154_IE_HEADER_LEN +
 				FIRA_IE_VENDOR_OUI_LEN),
@@ -738,9 +926,6 @@ int fira_crypto_encrypt_hie(struct fira_crypto *crypto, struct sk_buff *skb,
 				IEEE802154_IE_HEADER_LEN +
 				FIRA_IE_VENDOR_OUI_LEN));
 
-	mcps_crypto_aes_ecb_128_destroy(fira_crypto_ctx->ecb_ctx);
-	fira_crypto_ctx->ecb_ctx = NULL;
-
 	return rc;
 }
 
@@ -756,28 +941,17 @@ int fira_crypto_encrypt_hie(struct fira_crypto *crypto, struct sk_buff *skb,
 int fira_crypto_decrypt_hie(struct fira_crypto *crypto, struct sk_buff *skb,
 		int hie_offset, int hie_len)
 {
-	u32 fira_session_id = crypto->session_id;
-	struct fira_crypto_ctx *fira_crypto_ctx = get_session(fira_session_id);
+	struct fira_crypto_ctx *fira_crypto_ctx = crypto->ctx;
 	int rc;
 
 	if (fira_crypto_ctx->sts_config == FIRA_STS_MODE_STATIC)
 		return 0;
 
-	fira_crypto_ctx->ecb_ctx = mcps_crypto_aes_ecb_128_create();
-	if (!fira_crypto_ctx->ecb_ctx ||
-			mcps_crypto_aes_ecb_128_set_decrypt(
-				fira_crypto_ctx->ecb_ctx,
-				fira_crypto_ctx->privacy_key))
-		return -1;
-
-	rc = mcps_crypto_aes_ecb_128_encrypt(fira_crypto_ctx->ecb_ctx,
+	rc = mcps_crypto_aes_ecb_128_encrypt(fira_crypto_ctx->ecb_decrypt_ctx,
 			(const uint8_t *)(skb->data + hie_offset),
 			(unsigned int)hie_len,
 			(uint8_t *)(skb->data + hie_offset));
 
-	mcps_crypto_aes_ecb_128_destroy(fira_crypto_ctx->ecb_ctx);
-	fira_crypto_ctx->ecb_ctx = NULL;
-
 	return rc;
 }
 
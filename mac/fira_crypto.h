@@ -122,6 +122,22 @@ void fira_crypto_context_deinit(struct fira_crypto *crypto);
 int fira_crypto_rotate_elements(struct fira_crypto *crypto,
 				const u32 crypto_sts_index);
 
+/**
+ * fira_crypto_prefetch_elements() - Derive the crypto elements of a future
+ * rotation.
+ *
+ * NOTE: The derived elements are kept in the crypto context and used by
+ * fira_crypto_rotate_elements() when called with the same crypto STS index.
+ * Nothing is done if they are already available.
+ *
+ * @crypto: The context containing the elements to derive.
+ * @crypto_sts_index: The crypto STS index of the future rotation.
+ *
+ * Return: 0 or error.
+ */
+int fira_crypto_prefetch_elements(struct fira_crypto *crypto,
+				  const u32 crypto_sts_index);
+
 /**
  * fira_crypto_build_phy_sts_index_init() - Build the phy STS index init value
  * related to the given crypto context.
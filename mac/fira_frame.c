@@ -36,7 +36,8 @@
 
 #include "warn_return.h"
 
-bool fira_frame_check_n_controlees(const struct fira_session *session,
+bool fira_frame_check_n_controlees(const struct fira_local *local,
+				   const struct fira_session *session,
 				   size_t n_controlees, bool active)
 {
 	/*
@@ -51,11 +52,16 @@ bool fira_frame_check_n_controlees(const struct fira_session *session,
 	size_t mrm_size, rcm_size;
 	size_t n_msg_controller;
 	size_t n_msg_controlee = 2;
+	size_t n_slots;
 
 	if (n_controlees > FIRA_CONTROLEES_MAX)
 		return false;
 	if (!active)
 		return true;
+	/* Round state is sized when the session is started. */
+	if (fira_session_is_active(session) &&
+	    n_controlees > session->round.n_controlees_max)
+		return false;
 
 	if (params->ranging_round_usage == FIRA_RANGING_ROUND_USAGE_DSTWR) {
 		mrm_size = FIRA_FRAME_WITHOUT_PAYLOAD_LEN +
@@ -73,7 +79,36 @@ bool fira_frame_check_n_controlees(const struct fira_session *session,
 		   FIRA_IE_PAYLOAD_CONTROL_LEN(n_msg_controller +
 					       n_msg_controlee * n_controlees);
 
-	return mrm_size <= IEEE802154_MTU && rcm_size <= IEEE802154_MTU;
+	/*
+	 * Controller round slots: control, ranging initiation, one response
+	 * per controlee, final for DS-TWR, measurement report, then one
+	 * result report per controlee if enabled. They must fit in the round.
+	 */
+	n_slots = n_msg_controller + n_controlees;
+	if (params->result_report_phase)
+		n_slots += n_controlees;
+	if (params->device_type == FIRA_DEVICE_TYPE_CONTROLLER &&
+	    n_slots > params->round_duration_slots)
+		return false;
+
+	return mrm_size <= fira_frame_max_len(local, session) &&
+	       rcm_size <= fira_frame_max_len(local, session);
+}
+
+int fira_frame_max_len(const struct fira_local *local,
+		       const struct fira_session *session)
+{
+	int frame_len_max = local->llhw->frame_len_max;
+	int len;
+
+	if (session->params.prf_mode == FIRA_PRF_MODE_BPRF)
+		len = IEEE802154_MTU;
+	else
+		/* 1023, 2047 or 4095 bytes. */
+		len = (1024 << session->hrp_uwb_params.psdu_size) - 1;
+	if (frame_len_max && len > frame_len_max)
+		len = frame_len_max;
+	return len;
 }
 
 void fira_frame_header_put(const struct fira_local *local,
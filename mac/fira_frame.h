@@ -94,6 +94,7 @@ struct fira_session_params;
 /**
  * fira_frame_check_n_controlees() - Check the number of wanted
  * controlees.
+ * @local: FiRa context.
  * @session: Current session.
  * @n_controlees: Wanted number of controlees.
  * @active: Is the session (supposed to be) active?
@@ -103,11 +104,25 @@ struct fira_session_params;
  * For an inactive session, the number of controlees is limited by the list
  * size, aka FIRA_CONTROLEES_MAX.
  * For an active session, it depends on the space left in messages, which is
- * determined by the session parameters.
+ * determined by the session parameters, on the round state allocated when the
+ * session was started, and for a controller, on the number of slots in a
+ * round.
  */
-bool fira_frame_check_n_controlees(const struct fira_session *session,
+bool fira_frame_check_n_controlees(const struct fira_local *local,
+				   const struct fira_session *session,
 				   size_t n_controlees, bool active);
 
+/**
+ * fira_frame_max_len() - Get the maximum frame length of a session.
+ * @local: FiRa context.
+ * @session: Current session.
+ *
+ * Return: IEEE802154_MTU in BPRF, or the PSDU size in HPRF, limited to the
+ * maximum frame length of the low-level driver.
+ */
+int fira_frame_max_len(const struct fira_local *local,
+		       const struct fira_session *session);
+
 /**
  * fira_frame_header_put() - Fill FiRa frame header.
  * @local: FiRa context.
@@ -24,6 +24,7 @@
 #include <linux/slab.h>
 #include <linux/netdevice.h>
 #include <linux/errno.h>
+#include <linux/math64.h>
 
 #include <net/mcps802154_schedule.h>
 #include <net/fira_region_nl.h>
@@ -65,8 +66,14 @@ static struct mcps802154_region *fira_open(struct mcps802154_llhw *llhw)
 	local->region.ops = &fira_region_ops;
 	INIT_LIST_HEAD(&local->inactive_sessions);
 	INIT_LIST_HEAD(&local->active_sessions);
+	local->election_tree = RB_ROOT;
+	INIT_LIST_HEAD(&local->starting_sessions);
 	skb_queue_head_init(&local->report_queue);
 	INIT_WORK(&local->report_work, fira_report_event);
+	/* Without the ring, ring report mode falls back to notifications. */
+	local->report_ring = fira_report_ring_new(llhw);
+	if (!local->report_ring)
+		pr_warn("fira: report ring not available\n");
 	/* FIXME: Hack to simplify unit test, which is borderline. */
 	local->block_duration_rx_margin_ppm = UWB_BLOCK_DURATION_MARGIN_PPM;
 	fira_crypto_init(NULL);
@@ -85,6 +92,7 @@ static void fira_close(struct mcps802154_region *region)
 
 	cancel_work_sync(&local->report_work);
 	skb_queue_purge(&local->report_queue);
+	fira_report_ring_free(local->report_ring);
 	kfree_sensitive(local);
 }
 
@@ -134,6 +142,142 @@ static void fira_session_init_block_start_dtu(struct fira_local *local,
 	}
 }
 
+/**
+ * fira_election_key_dtu() - Build the earliest timestamp of the session demand.
+ * @local: FiRa context.
+ * @session: Session context.
+ *
+ * The demand never starts before the block start, minus the Rx margin for a
+ * controlee.
+ *
+ * Return: Timestamp in dtu.
+ */
+static u32 fira_election_key_dtu(const struct fira_local *local,
+				 const struct fira_session *session)
+{
+	const struct fira_session_params *params = &session->params;
+	s64 duration_dtu;
+
+	if (params->device_type != FIRA_DEVICE_TYPE_CONTROLEE)
+		return session->block_start_dtu;
+	/* Same margin as the one applied on controlee access. */
+	duration_dtu = (s64)(session->block_stride_len + 1) *
+		       params->block_duration_dtu;
+	return session->block_start_dtu -
+	       div64_s64(duration_dtu * local->block_duration_rx_margin_ppm,
+			 1000000);
+}
+
+/**
+ * fira_election_normalise_dtu() - Extend a timestamp to 64 bits, relative to
+ * the election time.
+ * @local: FiRa context.
+ * @timestamp_dtu: Timestamp in dtu.
+ *
+ * Return: Timestamp in dtu, within half the dtu range of the election time.
+ */
+static s64 fira_election_normalise_dtu(const struct fira_local *local,
+				       u32 timestamp_dtu)
+{
+	return local->election_time_dtu +
+	       (s32)(timestamp_dtu - (u32)local->election_time_dtu);
+}
+
+/**
+ * fira_election_is_before() - Compare two sessions in election order.
+ * @a: First session.
+ * @b: Second session.
+ *
+ * Return: True when a must be considered before b.
+ */
+static bool fira_election_is_before(const struct fira_session *a,
+				    const struct fira_session *b)
+{
+	if (a->params.priority != b->params.priority)
+		return a->params.priority > b->params.priority;
+	return a->election_key_dtu < b->election_key_dtu;
+}
+
+void fira_election_remove(struct fira_local *local,
+			  struct fira_session *session)
+{
+	if (!RB_EMPTY_NODE(&session->election_node)) {
+		rb_erase(&session->election_node, &local->election_tree);
+		RB_CLEAR_NODE(&session->election_node);
+	}
+	list_del_init(&session->election_entry);
+}
+
+void fira_election_update(struct fira_local *local,
+			  struct fira_session *session)
+{
+	struct rb_node **link = &local->election_tree.rb_node;
+	struct rb_node *parent = NULL;
+	s64 key_dtu;
+
+	if (!fira_session_is_active(session)) {
+		fira_election_remove(local, session);
+		return;
+	}
+	if (!session->block_start_valid) {
+		if (list_empty(&session->election_entry)) {
+			fira_election_remove(local, session);
+			list_add_tail(&session->election_entry,
+				      &local->starting_sessions);
+		}
+		return;
+	}
+	key_dtu = fira_election_normalise_dtu(
+		local, fira_election_key_dtu(local, session));
+	if (!RB_EMPTY_NODE(&session->election_node) &&
+	    session->election_key_dtu == key_dtu)
+		/* Nothing changed. */
+		return;
+	fira_election_remove(local, session);
+	session->election_key_dtu = key_dtu;
+	/* Equal sessions keep the insertion order. */
+	while (*link) {
+		struct fira_session *tmp =
+			rb_entry(*link, struct fira_session, election_node);
+
+		parent = *link;
+		if (fira_election_is_before(session, tmp))
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&session->election_node, parent, link);
+	rb_insert_color(&session->election_node, &local->election_tree);
+}
+
+/**
+ * fira_election_next_priority() - Find the first session with a lower
+ * priority.
+ * @local: FiRa context.
+ * @priority: Current priority.
+ *
+ * Return: Election tree node, or NULL if none.
+ */
+static struct rb_node *fira_election_next_priority(struct fira_local *local,
+						   int priority)
+{
+	struct rb_node *node = local->election_tree.rb_node;
+	struct rb_node *first = NULL;
+
+	while (node) {
+		struct fira_session *session =
+			rb_entry(node, struct fira_session, election_node);
+
+		if (session->params.priority < priority) {
+			first = node;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+	return first;
+}
+
 /**
  * fira_get_next_session() - Find the next session which should have the
  * access.
@@ -150,7 +294,8 @@ fira_get_next_session(struct fira_local *local, u32 next_timestamp_dtu,
 		      struct fira_session_demand *adopted_demand)
 {
 	struct fira_session *adopted_session = NULL;
-	struct fira_session *session;
+	struct fira_session *session, *tmp;
+	struct rb_node *node;
 	bool is_candidate_unsync, is_adopted_unsync;
 	int max_unsync_duration_dtu = max_duration_dtu;
 	int r;
@@ -160,16 +305,22 @@ fira_get_next_session(struct fira_local *local, u32 next_timestamp_dtu,
 	 * delay, and not a absolute time. This is the only function
 	 * which change the session content.
 	 */
-	list_for_each_entry (session, &local->active_sessions, entry) {
+	local->election_time_dtu =
+		fira_election_normalise_dtu(local, next_timestamp_dtu);
+	list_for_each_entry_safe (session, tmp, &local->starting_sessions,
+				  election_entry) {
 		fira_session_init_block_start_dtu(local, session,
 						  next_timestamp_dtu);
+		fira_election_update(local, session);
 	}
 
 	/*
-	 * Reminder: active_sessions list is sorted by session->priority
-	 * from highest priority to lowest priority.
+	 * Reminder: election tree is sorted by session->priority
+	 * from highest priority to lowest priority, and then by the
+	 * earliest timestamp of the session demand.
 	 */
-	list_for_each_entry (session, &local->active_sessions, entry) {
+	node = rb_first(&local->election_tree);
+	while (node) {
 		/*
 		 * Welcome in sessions election!
 		 *
@@ -183,6 +334,9 @@ fira_get_next_session(struct fira_local *local, u32 next_timestamp_dtu,
 		 */
 		struct fira_session_demand candidate_demand;
 
+		session = rb_entry(node, struct fira_session, election_node);
+		node = rb_next(node);
+
 		/*
 		 * Sessions with lower priority are not allowed to overlap
 		 * the adopted session. But a lower priority can start and
@@ -207,6 +361,30 @@ fira_get_next_session(struct fira_local *local, u32 next_timestamp_dtu,
 			if (!max_unsync_duration_dtu ||
 			    max_unsync_duration_dtu > max_duration_dtu)
 				max_unsync_duration_dtu = max_duration_dtu;
+			/*
+			 * The candidate demand can not start before its key,
+			 * nor the next ones with the same priority. None can
+			 * end before the adopted session start.
+			 */
+			if (session->election_key_dtu >=
+			    fira_election_normalise_dtu(
+				    local, adopted_demand->timestamp_dtu)) {
+				node = fira_election_next_priority(
+					local, session->params.priority);
+				continue;
+			}
+		} else if (adopted_session &&
+			   fira_election_normalise_dtu(
+				   local, adopted_demand->timestamp_dtu +
+						  adopted_demand->max_duration_dtu) <
+				   session->election_key_dtu) {
+			/*
+			 * The candidate and the next ones with the same
+			 * priority start after the adopted session.
+			 */
+			node = fira_election_next_priority(
+				local, session->params.priority);
+			continue;
 		}
 
 		is_candidate_unsync = session->params.device_type ==
@@ -25,10 +25,12 @@
 #define NET_FIRA_REGION_H
 
 #include <linux/kernel.h>
+#include <linux/rbtree.h>
 #include <linux/workqueue.h>
 #include <net/mcps802154_schedule.h>
 
 #include "net/fira_region_params.h"
+#include "fira_report_ring.h"
 
 #define FIRA_SLOT_DURATION_RSTU_DEFAULT 2400
 #define FIRA_BLOCK_DURATION_MS_DEFAULT 200
@@ -40,7 +42,15 @@
 #define FIRA_IN_BAND_TERMINATION_ATTEMPT_COUNT_MIN 1
 #define FIRA_BOOLEAN_MAX 1
 #define FIRA_BLOCK_STRIDE_LEN_MAX 255
-#define FIRA_FRAMES_MAX (3 + 3 * FIRA_CONTROLEES_MAX)
+#define FIRA_REPORT_BATCH_MAX_ROUNDS_MAX 32
+#define FIRA_REPORT_BATCH_MAX_ROUNDS_DEFAULT 8
+#define FIRA_REPORT_BATCH_MAX_LATENCY_MS_DEFAULT 100
+/* Size of a batched notification, nested attributes length is 16 bits. */
+#define FIRA_REPORT_BATCH_SIZE 16384
+/* Number of frames of a controller round with n controlees. */
+#define FIRA_FRAMES_N(n_controlees) (3 + 3 * (n_controlees))
+/* Minimum number of controlees a round state is sized for. */
+#define FIRA_ROUND_CONTROLEES_MIN 8
 #define FIRA_CONTROLEE_FRAMES_MAX (3 + 3 + 1)
 /* IEEE 802.15.4z 2020 section 6.9.7.2 */
 #define UWB_BLOCK_DURATION_MARGIN_PPM 100
@@ -106,6 +116,11 @@ struct fira_diagnostic {
 	 * @n_cirs: Number of parts of CIR.
 	 */
 	size_t n_cirs;
+	/**
+	 * @cirs_allocated: True if @cirs and its samples were allocated for
+	 * this frame, false if they are located in the session round arena.
+	 */
+	bool cirs_allocated;
 };
 
 /**
@@ -294,13 +309,20 @@ struct fira_local {
 	 */
 	struct work_struct report_work;
 	/**
-	 * @frames: Access frames referenced from access.
+	 * @report_ring: Shared ring for sessions in ring report mode, NULL if
+	 * not available.
 	 */
-	struct mcps802154_access_frame frames[FIRA_FRAMES_MAX];
+	struct fira_report_ring *report_ring;
 	/**
-	 * @sts_params: STS parameters for access frames.
+	 * @frames: Access frames referenced from access, from the current
+	 * session round state.
 	 */
-	struct mcps802154_sts_params sts_params[FIRA_FRAMES_MAX];
+	struct mcps802154_access_frame *frames;
+	/**
+	 * @sts_params: STS parameters for access frames, from the current
+	 * session round state.
+	 */
+	struct mcps802154_sts_params *sts_params;
 	/**
 	 * @channel: Channel parameters for access.
 	 */
@@ -313,6 +335,22 @@ struct fira_local {
 	 * @active_sessions: List of active sessions.
 	 */
 	struct list_head active_sessions;
+	/**
+	 * @election_tree: Active sessions with a valid block start, sorted
+	 * from highest to lowest priority, then by earliest next demand.
+	 */
+	struct rb_root election_tree;
+	/**
+	 * @starting_sessions: Active sessions waiting for their first block
+	 * start.
+	 */
+	struct list_head starting_sessions;
+	/**
+	 * @election_time_dtu: Time of the last election, extended to 64 bits.
+	 * Election keys are normalised against it, so they stay ordered even
+	 * when more than half the dtu range apart.
+	 */
+	s64 election_time_dtu;
 	/**
 	 * @current_session: Pointer to the current session.
 	 */
@@ -339,16 +377,18 @@ struct fira_local {
 	 * When controller, this is filled when the access is requested. When
 	 * controlee, the first slot is filled when the access is requested and
 	 * the other slots are filled when the control message is received.
+	 * From the current session round state.
 	 */
-	struct fira_slot slots[FIRA_FRAMES_MAX];
+	struct fira_slot *slots;
 	/**
 	 * @ranging_info: Information on ranging for the current session. Index
 	 * in the table is determined by the order of the ranging messages.
 	 * First ranging exchange is put at index 0. When a message is shared
 	 * between several exchanges, its information is stored at index 0.
-	 * Reset when access is requested.
+	 * Reset when access is requested. From the current session round
+	 * state.
 	 */
-	struct fira_ranging_info ranging_info[FIRA_CONTROLEES_MAX];
+	struct fira_ranging_info *ranging_info;
 	/**
 	 * @n_ranging_info: Number of element in the ranging information table.
 	 */
@@ -359,15 +399,16 @@ struct fira_local {
 	 */
 	int n_ranging_valid;
 	/**
-	 * @diagnostics: Diagnostic collected for each slot.
+	 * @diagnostics: Diagnostic collected for each slot, from the current
+	 * session round state.
 	 */
-	struct fira_diagnostic diagnostics[FIRA_FRAMES_MAX];
+	struct fira_diagnostic *diagnostics;
 	/**
 	 * @stopped_controlees: Short addresses of the stopped controlees for
 	 * which an element must be added to the Device Management List of
-	 * the control message.
+	 * the control message. From the current session round state.
 	 */
-	__le16 stopped_controlees[FIRA_CONTROLEES_MAX];
+	__le16 *stopped_controlees;
 	/**
 	 * @n_stopped_controlees: Number of elements in the stopped controlees .
 	 */
@@ -407,4 +448,23 @@ void fira_check_all_missed_ranging(struct fira_local *local,
 				   const struct fira_session *recent_session,
 				   u32 timestamp_dtu);
 
+/**
+ * fira_election_update() - Update the session position used by election.
+ * @local: FiRa context.
+ * @session: FiRa session.
+ *
+ * Must be called when the session state, its block start or its parameters
+ * change. Only active sessions are kept.
+ */
+void fira_election_update(struct fira_local *local,
+			  struct fira_session *session);
+
+/**
+ * fira_election_remove() - Remove the session from election.
+ * @local: FiRa context.
+ * @session: FiRa session.
+ */
+void fira_election_remove(struct fira_local *local,
+			  struct fira_session *session);
+
 #endif /* NET_FIRA_REGION_H */
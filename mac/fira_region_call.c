@@ -135,6 +135,12 @@ static const struct nla_policy fira_session_param_nla_policy[FIRA_SESSION_PARAM_
 		{ .type = NLA_U32 },
 	[FIRA_SESSION_PARAM_ATTR_RANGE_DATA_NTF_PROXIMITY_FAR] =
 		{ .type = NLA_U32 },
+	[FIRA_SESSION_PARAM_ATTR_REPORT_MODE] =
+		NLA_POLICY_MAX(NLA_U8, FIRA_REPORT_MODE_RING),
+	[FIRA_SESSION_PARAM_ATTR_REPORT_BATCH_MAX_ROUNDS] =
+		NLA_POLICY_RANGE(NLA_U8, 1, FIRA_REPORT_BATCH_MAX_ROUNDS_MAX),
+	[FIRA_SESSION_PARAM_ATTR_REPORT_BATCH_MAX_LATENCY_MS] =
+		{ .type = NLA_U32 },
 };
 
 /**
@@ -546,6 +552,10 @@ static int fira_session_set_parameters(struct fira_local *local, u32 session_id,
 	  x);
 	P(RANGE_DATA_NTF_PROXIMITY_FAR, range_data_ntf_proximity_far_mm, u32,
 	  x);
+	/* Report delivery */
+	P(REPORT_MODE, report_mode, u8, x);
+	P(REPORT_BATCH_MAX_ROUNDS, report_batch_max_rounds, u8, x);
+	P(REPORT_BATCH_MAX_LATENCY_MS, report_batch_max_latency_ms, u32, x);
 #undef PMEMNCPY
 #undef PMEMCPY
 #undef P
@@ -783,6 +793,10 @@ static int fira_session_get_parameters(struct fira_local *local, u32 session_id)
 	  x);
 	P(RANGE_DATA_NTF_PROXIMITY_FAR, range_data_ntf_proximity_far_mm, u32,
 	  x);
+	/* Report delivery */
+	P(REPORT_MODE, report_mode, u8, x);
+	P(REPORT_BATCH_MAX_ROUNDS, report_batch_max_rounds, u8, x);
+	P(REPORT_BATCH_MAX_LATENCY_MS, report_batch_max_latency_ms, u32, x);
 #undef P
 #undef PMEMCPY
 
@@ -933,15 +947,18 @@ static int fira_manage_controlees(struct fira_local *local,
 		break;
 	/* FIRA_CALL_NEW_CONTROLEE. */
 	default:
-		r = fira_session_new_controlees(session, &controlees,
+		r = fira_session_new_controlees(local, session, &controlees,
 						n_controlees, is_active);
 	}
 	if (r)
 		goto end;
 
 	if (!is_active && local->llhw->rx_ctx_size) {
-		for (i = 0; i < session->n_current_controlees; i++) {
-			memset(session->rx_ctx[i], 0, local->llhw->rx_ctx_size);
+		for (i = 0; i < session->n_current_controlees &&
+			    i < session->round.n_controlees_max;
+		     i++) {
+			memset(session->round.rx_ctx[i], 0,
+			       local->llhw->rx_ctx_size);
 		}
 	}
 
@@ -0,0 +1,229 @@
+/*
+ * This file is part of the UWB stack for linux.
+ *
+ * Copyright (c) 2022 Qorvo US, Inc.
+ *
+ * This software is provided under the GNU General Public License, version 2
+ * (GPLv2), as well as under a Qorvo commercial license.
+ *
+ * You may choose to use this software under the terms of the GPLv2 License,
+ * version 2 ("GPLv2"), as published by the Free Software Foundation.
+ * You should have received a copy of the GPLv2 along with this program.  If
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is distributed under the GPLv2 in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GPLv2 for more
+ * details.
+ *
+ * If you cannot meet the requirements of the GPLv2, you may not use this
+ * software for any purpose without first obtaining a commercial license from
+ * Qorvo. Please contact Qorvo to inquire about licensing terms.
+ */
+
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+#include <net/cfg802154.h>
+#include <net/mac802154.h>
+#include <net/mcps802154.h>
+
+#include "fira_report_ring.h"
+
+static inline struct fira_report_ring *
+fira_report_ring_from_file(struct file *filp)
+{
+	return container_of(filp->private_data, struct fira_report_ring, misc);
+}
+
+static inline struct fira_report_ring_record *
+fira_report_ring_record(struct fira_report_ring *ring, u32 n)
+{
+	return (void *)(ring->header + 1) +
+	       (n % ring->nr_records) * ring->record_size;
+}
+
+static void fira_report_ring_kref_release(struct kref *kref)
+{
+	struct fira_report_ring *ring =
+		container_of(kref, struct fira_report_ring, kref);
+
+	kfree(ring->misc.name);
+	kfree(ring);
+}
+
+static int fira_report_ring_open(struct inode *inode, struct file *filp)
+{
+	struct fira_report_ring *ring = fira_report_ring_from_file(filp);
+	struct fira_report_ring_header *header;
+	size_t size;
+
+	/* Single consumer only. */
+	if (atomic_cmpxchg(&ring->opened, 0, 1))
+		return -EBUSY;
+	size = PAGE_ALIGN(sizeof(*header) +
+			  sizeof(struct fira_report_ring_record) *
+				  FIRA_REPORT_RING_RECORDS);
+	header = vmalloc_user(size);
+	if (!header) {
+		atomic_set(&ring->opened, 0);
+		return -ENOMEM;
+	}
+	mutex_lock(&ring->mutex);
+	ring->size = size;
+	ring->head = 0;
+	ring->nr_records = FIRA_REPORT_RING_RECORDS;
+	ring->record_size = sizeof(struct fira_report_ring_record);
+	WRITE_ONCE(header->nr_records, ring->nr_records);
+	WRITE_ONCE(header->record_size, ring->record_size);
+	/* Publish the ring, sessions in ring mode start to fill it. */
+	WRITE_ONCE(ring->header, header);
+	mutex_unlock(&ring->mutex);
+	/*
+	 * Misc device open is serialized with misc_deregister(), so the ring
+	 * is still referenced by the FiRa context here.
+	 */
+	kref_get(&ring->kref);
+	return nonseekable_open(inode, filp);
+}
+
+static int fira_report_ring_release(struct inode *inode, struct file *filp)
+{
+	struct fira_report_ring *ring = fira_report_ring_from_file(filp);
+	struct fira_report_ring_header *header;
+
+	mutex_lock(&ring->mutex);
+	header = ring->header;
+	WRITE_ONCE(ring->header, NULL);
+	mutex_unlock(&ring->mutex);
+	/* Existing mappings hold their own reference on the pages. */
+	vfree(header);
+	atomic_set(&ring->opened, 0);
+	kref_put(&ring->kref, fira_report_ring_kref_release);
+	return 0;
+}
+
+static int fira_report_ring_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct fira_report_ring *ring = fira_report_ring_from_file(filp);
+	unsigned long len = vma->vm_end - vma->vm_start;
+	int r;
+
+	mutex_lock(&ring->mutex);
+	if (!ring->header)
+		r = -ENODEV;
+	else if (vma->vm_pgoff || len > ring->size)
+		r = -EINVAL;
+	else
+		r = remap_vmalloc_range(vma, ring->header, 0);
+	mutex_unlock(&ring->mutex);
+	return r;
+}
+
+static __poll_t fira_report_ring_poll(struct file *filp,
+				      struct poll_table_struct *wait)
+{
+	struct fira_report_ring *ring = fira_report_ring_from_file(filp);
+	__poll_t mask = 0;
+
+	poll_wait(filp, &ring->wq, wait);
+	mutex_lock(&ring->mutex);
+	if (!ring->header)
+		mask = EPOLLERR;
+	else if (ring->head != READ_ONCE(ring->header->tail))
+		mask = EPOLLIN | EPOLLRDNORM;
+	mutex_unlock(&ring->mutex);
+	return mask;
+}
+
+static const struct file_operations fira_report_ring_fops = {
+	.owner = THIS_MODULE,
+	.open = fira_report_ring_open,
+	.release = fira_report_ring_release,
+	.mmap = fira_report_ring_mmap,
+	.poll = fira_report_ring_poll,
+	.llseek = no_llseek,
+};
+
+int fira_report_ring_lock(struct fira_report_ring *ring)
+{
+	mutex_lock(&ring->mutex);
+	if (!ring->header) {
+		mutex_unlock(&ring->mutex);
+		return -ENODEV;
+	}
+	ring->lock_head = ring->head;
+	return 0;
+}
+
+void fira_report_ring_unlock(struct fira_report_ring *ring)
+{
+	if (ring->head != ring->lock_head)
+		wake_up_interruptible(&ring->wq);
+	mutex_unlock(&ring->mutex);
+}
+
+void fira_report_ring_push(struct fira_report_ring *ring,
+			   const struct fira_report_ring_record *records,
+			   int n_records)
+{
+	struct fira_report_ring_header *header = ring->header;
+	u32 head = ring->head;
+	u32 used;
+	int i;
+
+	/*
+	 * Pairs with user release of consumed records. A tail ahead of head
+	 * or too late is invalid, the ring is then seen as full.
+	 */
+	used = head - smp_load_acquire(&header->tail);
+	for (i = 0; i < n_records; i++) {
+		if (used >= ring->nr_records) {
+			header->dropped += n_records - i;
+			break;
+		}
+		memcpy(fira_report_ring_record(ring, head), &records[i],
+		       sizeof(*records));
+		head++;
+		used++;
+	}
+	if (head != ring->head) {
+		header->written += head - ring->head;
+		WRITE_ONCE(ring->head, head);
+		/* Records must be visible before the new head. */
+		smp_store_release(&header->head, head);
+	}
+}
+
+struct fira_report_ring *fira_report_ring_new(struct mcps802154_llhw *llhw)
+{
+	struct fira_report_ring *ring;
+
+	ring = kzalloc(sizeof(*ring), GFP_KERNEL);
+	if (!ring)
+		return NULL;
+	kref_init(&ring->kref);
+	mutex_init(&ring->mutex);
+	init_waitqueue_head(&ring->wq);
+	ring->misc.minor = MISC_DYNAMIC_MINOR;
+	ring->misc.name = kasprintf(GFP_KERNEL, "fira_report-%s",
+				    wpan_phy_name(llhw->hw->phy));
+	ring->misc.fops = &fira_report_ring_fops;
+	if (!ring->misc.name || misc_register(&ring->misc)) {
+		kref_put(&ring->kref, fira_report_ring_kref_release);
+		return NULL;
+	}
+	return ring;
+}
+
+void fira_report_ring_free(struct fira_report_ring *ring)
+{
+	if (!ring)
+		return;
+	/* No new open after this, opened device keeps its reference. */
+	misc_deregister(&ring->misc);
+	kref_put(&ring->kref, fira_report_ring_kref_release);
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the UWB stack for linux.
+ *
+ * Copyright (c) 2022 Qorvo US, Inc.
+ *
+ * This software is provided under the GNU General Public License, version 2
+ * (GPLv2), as well as under a Qorvo commercial license.
+ *
+ * You may choose to use this software under the terms of the GPLv2 License,
+ * version 2 ("GPLv2"), as published by the Free Software Foundation.
+ * You should have received a copy of the GPLv2 along with this program.  If
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is distributed under the GPLv2 in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GPLv2 for more
+ * details.
+ *
+ * If you cannot meet the requirements of the GPLv2, you may not use this
+ * software for any purpose without first obtaining a commercial license from
+ * Qorvo. Please contact Qorvo to inquire about licensing terms.
+ */
+
+#ifndef NET_MCPS802154_FIRA_REPORT_RING_H
+#define NET_MCPS802154_FIRA_REPORT_RING_H
+
+#include <linux/types.h>
+#include <linux/kref.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/wait.h>
+#include <net/fira_report_ring_abi.h>
+
+/* Number of records in the report ring. */
+#define FIRA_REPORT_RING_RECORDS 1024
+
+/**
+ * struct fira_report_ring - Report ring character device.
+ *
+ * The ring is referenced by the FiRa context and by the opened device, so it
+ * outlives the region when user space still holds the device opened.
+ */
+struct fira_report_ring {
+	/**
+	 * @kref: Reference counter.
+	 */
+	struct kref kref;
+	/**
+	 * @misc: Misc character device.
+	 */
+	struct miscdevice misc;
+	/**
+	 * @mutex: Protect @header against release while records are written.
+	 */
+	struct mutex mutex;
+	/**
+	 * @wq: Wait queue of poll().
+	 */
+	wait_queue_head_t wq;
+	/**
+	 * @header: Shared ring, allocated while the device is opened.
+	 */
+	struct fira_report_ring_header *header;
+	/**
+	 * @size: Allocated size of @header.
+	 */
+	size_t size;
+	/**
+	 * @head: Count of written records, published in @header.
+	 */
+	u32 head;
+	/**
+	 * @lock_head: Value of @head when the ring was locked.
+	 */
+	u32 lock_head;
+	/**
+	 * @nr_records: Number of record slots in @header.
+	 */
+	u32 nr_records;
+	/**
+	 * @record_size: Size in bytes of each record slot in @header.
+	 */
+	u32 record_size;
+	/**
+	 * @opened: Non-zero while the device is opened.
+	 */
+	atomic_t opened;
+};
+
+struct mcps802154_llhw;
+
+/**
+ * fira_report_ring_new() - Allocate and register the report ring character
+ * device.
+ * @llhw: Low-level device pointer, used to name the device.
+ *
+ * Return: The report ring, or NULL on error.
+ */
+struct fira_report_ring *fira_report_ring_new(struct mcps802154_llhw *llhw);
+
+/**
+ * fira_report_ring_free() - Unregister the report ring character device and
+ * drop the caller reference.
+ * @ring: Report ring.
+ *
+ * The ring is freed once the device is released, if still opened.
+ */
+void fira_report_ring_free(struct fira_report_ring *ring);
+
+/**
+ * fira_report_ring_lock() - Lock the report ring to push records.
+ * @ring: Report ring.
+ *
+ * The ring stays opened until fira_report_ring_unlock(), so all the records
+ * of a report are either pushed or not.
+ *
+ * Return: 0, or -ENODEV if the ring is not opened, and then not locked.
+ */
+int fira_report_ring_lock(struct fira_report_ring *ring);
+
+/**
+ * fira_report_ring_unlock() - Unlock the report ring.
+ * @ring: Report ring.
+ *
+ * Consumers are woken up once for all the records pushed since lock.
+ */
+void fira_report_ring_unlock(struct fira_report_ring *ring);
+
+/**
+ * fira_report_ring_push() - Add records to the locked report ring.
+ * @ring: Report ring.
+ * @records: Records to add.
+ * @n_records: Number of records.
+ *
+ * Records which do not fit are dropped and counted.
+ */
+void fira_report_ring_push(struct fira_report_ring *ring,
+			   const struct fira_report_ring_record *records,
+			   int n_records);
+
+#endif /* NET_MCPS802154_FIRA_REPORT_RING_H */
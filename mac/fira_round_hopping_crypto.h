@@ -27,19 +27,23 @@
 #include <linux/types.h>
 #include <crypto/aes.h>
 
+/* Maximum number of blocks encrypted at once. */
+#define FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS 16
+
 struct fira_round_hopping_sequence;
 
 /**
  * fira_round_hopping_crypto_encrypt() - Compute a cipher using AES.
  * @round_hopping_sequence: Round hopping context.
- * @data: Input data, with length AES_BLOCK_SIZE.
- * @out: Output hash, with length AES_BLOCK_SIZE.
+ * @data: Input data, with length n_blocks * AES_BLOCK_SIZE.
+ * @out: Output hash, with length n_blocks * AES_BLOCK_SIZE.
+ * @n_blocks: Number of AES blocks, up to FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS.
  *
  * Return: 0 or error.
  */
 int fira_round_hopping_crypto_encrypt(
 	const struct fira_round_hopping_sequence *round_hopping_sequence,
-	const u8 *data, u8 *out);
+	const u8 *data, u8 *out, int n_blocks);
 
 /**
  * fira_round_hopping_crypto_init() - Initialize round hopping context.
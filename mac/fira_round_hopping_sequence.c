@@ -44,6 +44,69 @@ void fira_round_hopping_sequence_destroy(struct fira_session *session)
 	fira_round_hopping_crypto_destroy(round_hopping_sequence);
 }
 
+void fira_round_hopping_sequence_invalidate(struct fira_session *session)
+{
+	session->round_hopping_window.step = 0;
+	session->round_hopping_window.n = 0;
+}
+
+/* Refill when less than this number of next hashes are precomputed. */
+#define FIRA_ROUND_HOPPING_WINDOW_LOW 2
+
+/**
+ * fira_round_hopping_sequence_lookup() - Find a precomputed hash.
+ * @session: Session.
+ * @block_index: Block index.
+ * @step: Number of blocks between two accesses.
+ *
+ * Return: Index in window, or -1 when not precomputed with this step.
+ */
+static int fira_round_hopping_sequence_lookup(const struct fira_session *session,
+					      u32 block_index, int step)
+{
+	u32 offset = block_index - session->round_hopping_window.base_block_index;
+	u32 i;
+
+	if (session->round_hopping_window.step != step ||
+	    block_index < session->round_hopping_window.base_block_index ||
+	    offset % step)
+		return -1;
+	i = offset / step;
+	return i < session->round_hopping_window.n ? i : -1;
+}
+
+void fira_round_hopping_sequence_prefetch(struct fira_session *session,
+					  int block_index)
+{
+	const struct fira_round_hopping_sequence *round_hopping_sequence =
+		&session->round_hopping_sequence;
+	const int n_blocks = FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS;
+	int step = session->block_stride_len + 1;
+	u8 blocks[FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS * AES_BLOCK_SIZE];
+	int i;
+
+	i = fira_round_hopping_sequence_lookup(session, block_index, step);
+	if (i >= 0 &&
+	    session->round_hopping_window.n - i > FIRA_ROUND_HOPPING_WINDOW_LOW)
+		return;
+
+	memset(blocks, 0, sizeof(blocks));
+	for (i = 0; i < n_blocks; i++)
+		put_unaligned_be32(block_index + i * step,
+				   blocks + (i + 1) * AES_BLOCK_SIZE -
+					   sizeof(u32));
+	fira_round_hopping_sequence_invalidate(session);
+	if (fira_round_hopping_crypto_encrypt(round_hopping_sequence, blocks,
+					      blocks, n_blocks))
+		return;
+	for (i = 0; i < n_blocks; i++)
+		session->round_hopping_window.hash[i] = get_unaligned_be16(
+			blocks + (i + 1) * AES_BLOCK_SIZE - sizeof(u16));
+	session->round_hopping_window.base_block_index = block_index;
+	session->round_hopping_window.step = step;
+	session->round_hopping_window.n = n_blocks;
+}
+
 int fira_round_hopping_sequence_get(const struct fira_session *session,
 				    int block_index)
 {
@@ -55,19 +118,24 @@ int fira_round_hopping_sequence_get(const struct fira_session *session,
 	int n_rounds = block_duration_slots / params->round_duration_slots;
 	u8 block[AES_BLOCK_SIZE];
 	u8 out[AES_BLOCK_SIZE];
-	int r;
+	u16 hash;
+	int i;
 
 	if (!block_index)
 		return 0;
-	memset(block, 0, AES_BLOCK_SIZE - sizeof(u32));
-	put_unaligned_be32(block_index, block + AES_BLOCK_SIZE - sizeof(u32));
-	r = fira_round_hopping_crypto_encrypt(round_hopping_sequence, block,
-					      out);
-	if (!r) {
-		u16 hash =
-			get_unaligned_be16(out + AES_BLOCK_SIZE - sizeof(u16));
-
-		return hash * n_rounds >> 16;
+	i = fira_round_hopping_sequence_lookup(session, block_index,
+					       session->block_stride_len + 1);
+	if (i >= 0) {
+		hash = session->round_hopping_window.hash[i];
+	} else {
+		/* Not precomputed, compute this block only. */
+		memset(block, 0, AES_BLOCK_SIZE - sizeof(u32));
+		put_unaligned_be32(block_index,
+				   block + AES_BLOCK_SIZE - sizeof(u32));
+		if (fira_round_hopping_crypto_encrypt(round_hopping_sequence,
+						      block, out, 1))
+			return 0;
+		hash = get_unaligned_be16(out + AES_BLOCK_SIZE - sizeof(u16));
 	}
-	return 0;
+	return hash * n_rounds >> 16;
 }
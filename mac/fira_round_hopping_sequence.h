@@ -40,11 +40,35 @@ int fira_round_hopping_sequence_init(struct fira_session *session);
  */
 void fira_round_hopping_sequence_destroy(struct fira_session *session);
 
+/**
+ * fira_round_hopping_sequence_invalidate() - Forget precomputed round indexes.
+ * @session: Session.
+ */
+void fira_round_hopping_sequence_invalidate(struct fira_session *session);
+
+/**
+ * fira_round_hopping_sequence_prefetch() - Precompute next round indexes.
+ * @session: Session.
+ * @block_index: Next block index which will be used.
+ *
+ * Refill the window of precomputed hashes, starting at given block index and
+ * using the current block stride, when it doesn't cover enough next blocks.
+ * All hashes are computed with a single multi-block encryption.
+ *
+ * NOTE: Must be called outside of time critical paths, like after the
+ * ranging round report.
+ */
+void fira_round_hopping_sequence_prefetch(struct fira_session *session,
+					  int block_index);
+
 /**
  * fira_round_hopping_sequence_get() - Get round index for block index.
  * @session: Session.
  * @block_index: Block index.
  *
+ * Use the precomputed window when it contains the block index, else compute
+ * it directly.
+ *
  * Return: Round index.
  */
 int fira_round_hopping_sequence_get(const struct fira_session *session,
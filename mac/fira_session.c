@@ -24,9 +24,11 @@
 #include <linux/bitops.h>
 #include <linux/errno.h>
 #include <linux/ieee802154.h>
+#include <linux/jiffies.h>
 #include <linux/string.h>
 #include <linux/limits.h>
 #include <linux/math64.h>
+#include <linux/mm.h>
 
 #include <net/mcps802154_frame.h>
 #include <net/fira_region_nl.h>
@@ -520,18 +522,10 @@ struct fira_session *fira_session_new(struct fira_local *local, u32 session_id)
 {
 	struct fira_session *session;
 	struct fira_session_params *params;
-	int all_rx_ctx_size = FIRA_CONTROLEES_MAX * local->llhw->rx_ctx_size;
-	void *rx_ctx_base = NULL;
-	int i;
 
 	session = kzalloc(sizeof(*session), GFP_KERNEL);
 	if (!session)
 		return NULL;
-	if (all_rx_ctx_size) {
-		rx_ctx_base = kzalloc(all_rx_ctx_size, GFP_KERNEL);
-		if (!rx_ctx_base)
-			goto failed;
-	}
 
 	params = &session->params;
 	session->id = session_id;
@@ -571,29 +565,144 @@ struct fira_session *fira_session_new(struct fira_local *local, u32 session_id)
 	params->range_data_ntf_proximity_near_mm = 0;
 	params->range_data_ntf_proximity_far_mm =
 		FIRA_RANGE_DATA_NTF_PROXIMITY_FAR_DEFAULT;
+	params->report_mode = FIRA_REPORT_MODE_ROUND;
+	params->report_batch_max_rounds = FIRA_REPORT_BATCH_MAX_ROUNDS_DEFAULT;
+	params->report_batch_max_latency_ms =
+		FIRA_REPORT_BATCH_MAX_LATENCY_MS_DEFAULT;
 
 	if (fira_round_hopping_sequence_init(session))
 		goto failed;
 
-	if (all_rx_ctx_size) {
-		for (i = 0; i < FIRA_CONTROLEES_MAX; i++) {
-			void *rx_ctx = (char *)rx_ctx_base +
-				       i * local->llhw->rx_ctx_size;
-			session->rx_ctx[i] = rx_ctx;
-		}
-	}
-
 	INIT_LIST_HEAD(&session->current_controlees);
 
 	fira_session_fsm_initialise(local, session);
 	return session;
 
 failed:
-	kfree(rx_ctx_base);
 	kfree(session);
 	return NULL;
 }
 
+/**
+ * fira_session_round_free() - Free a round state.
+ * @round: Round state.
+ */
+static void fira_session_round_free(struct fira_session_round *round)
+{
+	kfree(round->frames);
+	kfree(round->sts_params);
+	kfree(round->slots);
+	kfree(round->diagnostics);
+	kvfree(round->diagnostic_cirs);
+	kfree(round->ranging_info);
+	kfree(round->stopped_controlees);
+	if (round->rx_ctx)
+		kfree(round->rx_ctx[0]);
+	kfree(round->rx_ctx);
+	memset(round, 0, sizeof(*round));
+}
+
+static int fira_session_round_frames_alloc(struct fira_local *local,
+					   struct fira_session *session)
+{
+	struct fira_session_round *round = &session->round;
+	struct fira_session_round new_round = {};
+	int n_controlees = clamp(session->n_current_controlees,
+				 FIRA_ROUND_CONTROLEES_MIN, FIRA_CONTROLEES_MAX);
+	int n_frames = FIRA_FRAMES_N(n_controlees);
+	size_t rx_ctx_size = local->llhw->rx_ctx_size;
+	int i;
+
+	if (round->n_controlees_max >= n_controlees)
+		return 0;
+
+	new_round.frames = kcalloc(n_frames, sizeof(*new_round.frames),
+				   GFP_KERNEL);
+	new_round.sts_params = kcalloc(
+		n_frames, sizeof(*new_round.sts_params), GFP_KERNEL);
+	new_round.slots = kcalloc(n_frames, sizeof(*new_round.slots),
+				  GFP_KERNEL);
+	new_round.diagnostics = kcalloc(
+		n_frames, sizeof(*new_round.diagnostics), GFP_KERNEL);
+	new_round.ranging_info = kcalloc(
+		n_controlees, sizeof(*new_round.ranging_info), GFP_KERNEL);
+	new_round.stopped_controlees = kcalloc(
+		n_controlees, sizeof(*new_round.stopped_controlees),
+		GFP_KERNEL);
+	new_round.rx_ctx = kcalloc(n_controlees, sizeof(*new_round.rx_ctx),
+				   GFP_KERNEL);
+	if (!new_round.frames || !new_round.sts_params || !new_round.slots ||
+	    !new_round.diagnostics || !new_round.ranging_info ||
+	    !new_round.stopped_controlees || !new_round.rx_ctx)
+		goto failed;
+	if (rx_ctx_size) {
+		char *rx_ctx_base = kcalloc(n_controlees, rx_ctx_size,
+					    GFP_KERNEL);
+
+		if (!rx_ctx_base)
+			goto failed;
+		for (i = 0; i < n_controlees; i++)
+			new_round.rx_ctx[i] = rx_ctx_base + i * rx_ctx_size;
+	}
+	new_round.n_controlees_max = n_controlees;
+
+	fira_session_round_free(round);
+	*round = new_round;
+	return 0;
+
+failed:
+	fira_session_round_free(&new_round);
+	return -ENOMEM;
+}
+
+/**
+ * fira_session_round_diagnostics_alloc() - Size the CIR diagnostics arena.
+ * @local: FiRa context.
+ * @session: Session to start.
+ *
+ * The arena has room for the largest CIR reported by the low-level driver on
+ * each frame, so that no allocation is done when frames are received.
+ *
+ * Return: 0 or error.
+ */
+static int fira_session_round_diagnostics_alloc(struct fira_local *local,
+						struct fira_session *session)
+{
+	const struct mcps802154_llhw *llhw = local->llhw;
+	struct fira_session_round *round = &session->round;
+	int n_frames = FIRA_FRAMES_N(round->n_controlees_max);
+	size_t size;
+
+	if (!(session->params.diagnostic_report_flags &
+	      FIRA_RANGING_DIAGNOSTICS_FRAME_REPORT_CIRS) ||
+	    !llhw->cir_n_max || !llhw->cir_window_size_max)
+		return 0;
+
+	size = n_frames * llhw->cir_n_max *
+	       (sizeof(struct mcps802154_rx_cir) + llhw->cir_window_size_max);
+	if (round->diagnostic_cirs_size >= size)
+		return 0;
+
+	kvfree(round->diagnostic_cirs);
+	round->diagnostic_cirs_size = 0;
+	round->diagnostic_cirs = kvzalloc(size, GFP_KERNEL);
+	if (!round->diagnostic_cirs)
+		return -ENOMEM;
+	round->diagnostic_cirs_size = size;
+	return 0;
+}
+
+int fira_session_round_alloc(struct fira_local *local,
+			     struct fira_session *session)
+{
+	int r;
+
+	r = fira_session_round_frames_alloc(local, session);
+	if (r)
+		return r;
+	return fira_session_round_diagnostics_alloc(local, session);
+}
+
 void fira_session_free(struct fira_local *local, struct fira_session *session)
 {
 	struct fira_controlee *controlee, *tmp_controlee;
@@ -605,7 +714,8 @@ void fira_session_free(struct fira_local *local, struct fira_session *session)
 	}
 	fira_session_fsm_uninit(local, session);
 	fira_round_hopping_sequence_destroy(session);
-	kfree(session->rx_ctx[0]);
+	fira_session_round_free(&session->round);
+	kfree_skb(session->report_batch.msg);
 	kfree_sensitive(session);
 }
 
@@ -615,7 +725,8 @@ int fira_session_set_controlees(struct fira_local *local,
 {
 	struct fira_controlee *controlee, *tmp_controlee;
 
-	if (!fira_frame_check_n_controlees(session, n_controlees, false))
+	if (!fira_frame_check_n_controlees(local, session, n_controlees,
+					   false))
 		return -EINVAL;
 
 	list_for_each_entry_safe (controlee, tmp_controlee,
@@ -630,14 +741,15 @@ int fira_session_set_controlees(struct fira_local *local,
 	return 0;
 }
 
-int fira_session_new_controlees(struct fira_session *session,
+int fira_session_new_controlees(struct fira_local *local,
+				struct fira_session *session,
 				struct list_head *controlees, int n_controlees,
 				bool async)
 {
 	struct fira_controlee *controlee, *new_controlee, *tmp_new_controlee;
 
 	if (!fira_frame_check_n_controlees(
-		    session, session->n_current_controlees + n_controlees,
+		    local, session, session->n_current_controlees + n_controlees,
 		    async))
 		return -EINVAL;
 
@@ -756,8 +868,11 @@ void fira_session_update_controlees(struct fira_local *local,
 	}
 
 	if (reset_rx_ctx && local->llhw->rx_ctx_size) {
-		for (i = 0; i < session->n_current_controlees; i++) {
-			memset(session->rx_ctx[i], 0, local->llhw->rx_ctx_size);
+		for (i = 0; i < session->n_current_controlees &&
+			    i < session->round.n_controlees_max;
+		     i++) {
+			memset(session->round.rx_ctx[i], 0,
+			       local->llhw->rx_ctx_size);
 		}
 	}
 }
@@ -774,7 +889,8 @@ bool fira_session_is_ready(const struct fira_local *local,
 	} else {
 		/* On success, session will become active, so assume it is. */
 		if (!fira_frame_check_n_controlees(
-			    session, session->n_current_controlees, true))
+			    local, session, session->n_current_controlees,
+			    true))
 			return false;
 	}
 
@@ -878,6 +994,286 @@ static bool proximity_enable_report(const struct fira_report_info *report_info,
 	return false;
 }
 
+/*
+ * Number of controlees which fit in a notification of the default size, with
+ * the measurements and the diagnostics of their slots.
+ */
+#define FIRA_REPORT_CONTROLEES_PER_DEFAULT_SIZE 8
+
+/**
+ * fira_session_report_size() - Estimate the notification size of a report.
+ * @report_info: Report information.
+ *
+ * Return: Size to allocate for the notification.
+ */
+static size_t
+fira_session_report_size(const struct fira_report_info *report_info)
+{
+	int n_controlees = max(report_info->n_ranging_data,
+			       report_info->n_stopped_controlees);
+
+	return NLMSG_DEFAULT_SIZE *
+	       DIV_ROUND_UP(max(n_controlees, 1),
+			    FIRA_REPORT_CONTROLEES_PER_DEFAULT_SIZE);
+}
+
+/**
+ * fira_session_report_round() - Put a round in a notification.
+ * @local: FiRa context.
+ * @session: Session to report.
+ * @report_info: Report information.
+ * @msg: Notification.
+ *
+ * Return: 0 or error.
+ */
+static int fira_session_report_round(struct fira_local *local,
+				     const struct fira_session *session,
+				     const struct fira_report_info *report_info,
+				     struct sk_buff *msg)
+{
+	if (nla_put_u32(msg, FIRA_CALL_ATTR_SEQUENCE_NUMBER,
+			session->sequence_number))
+		return -EMSGSIZE;
+	if (fira_session_report_ranging_data(session, report_info,
+					     local->llhw->dtu_freq_hz,
+					     local->llhw->dtu_rctu, msg))
+		return -EMSGSIZE;
+	return fira_session_report_ranging_diagnostics(session, report_info,
+						       msg);
+}
+
+/**
+ * fira_session_report_alloc() - Allocate a notification for a session.
+ * @local: FiRa context.
+ * @session: Session to report.
+ * @size: Size of the notification.
+ *
+ * Return: The notification with the session identifier, or NULL.
+ */
+static struct sk_buff *fira_session_report_alloc(struct fira_local *local,
+						 struct fira_session *session,
+						 size_t size)
+{
+	struct sk_buff *msg;
+
+	msg = mcps802154_region_event_alloc_skb(local->llhw, &local->region,
+						FIRA_CALL_SESSION_NOTIFICATION,
+						session->event_portid, size,
+						GFP_KERNEL);
+	if (!msg)
+		return NULL;
+	if (nla_put_u32(msg, FIRA_CALL_ATTR_SESSION_ID, session->id)) {
+		kfree_skb(msg);
+		return NULL;
+	}
+	return msg;
+}
+
+void fira_session_report_flush(struct fira_local *local,
+			       struct fira_session *session)
+{
+	struct sk_buff *msg = session->report_batch.msg;
+
+	if (!msg)
+		return;
+	nla_nest_end(msg, session->report_batch.reports);
+	session->report_batch.msg = NULL;
+	session->report_batch.n_rounds = 0;
+	skb_queue_tail(&local->report_queue, msg);
+	schedule_work(&local->report_work);
+}
+
+/**
+ * fira_session_report_batch() - Add a round to the batched notification.
+ * @local: FiRa context.
+ * @session: Session to report.
+ * @report_info: Report information.
+ *
+ * The notification is sent when the maximum number of rounds is reached, when
+ * its oldest round is older than the latency threshold, when the next round
+ * does not fit or when the session is stopped. The latency threshold is only
+ * checked on rounds, so the worst case latency is the threshold plus one
+ * ranging interval.
+ *
+ * Return: 0, or error if the round must be sent on its own.
+ */
+static int fira_session_report_batch(struct fira_local *local,
+				     struct fira_session *session,
+				     const struct fira_report_info *report_info)
+{
+	const struct fira_session_params *params = &session->params;
+	struct sk_buff *msg = session->report_batch.msg;
+	struct nlattr *round;
+	unsigned char *mark;
+
+	if (!msg) {
+		msg = fira_session_report_alloc(local, session,
+						FIRA_REPORT_BATCH_SIZE);
+		if (!msg)
+			return -ENOMEM;
+		session->report_batch.reports =
+			nla_nest_start(msg, FIRA_CALL_ATTR_REPORTS);
+		if (!session->report_batch.reports) {
+			kfree_skb(msg);
+			return -EMSGSIZE;
+		}
+		session->report_batch.msg = msg;
+		session->report_batch.first_round_jiffies = jiffies;
+	}
+
+	mark = skb_tail_pointer(msg);
+	round = nla_nest_start(msg, 1);
+	if (!round ||
+	    fira_session_report_round(local, session, report_info, msg)) {
+		nlmsg_trim(msg, mark);
+		if (!session->report_batch.n_rounds) {
+			/* Too large for a batch. */
+			session->report_batch.msg = NULL;
+			kfree_skb(msg);
+			return -EMSGSIZE;
+		}
+		fira_session_report_flush(local, session);
+		return fira_session_report_batch(local, session, report_info);
+	}
+	nla_nest_end(msg, round);
+	session->report_batch.n_rounds++;
+
+	if (report_info->stopped ||
+	    session->report_batch.n_rounds >= params->report_batch_max_rounds ||
+	    time_after_eq(jiffies,
+			  session->report_batch.first_round_jiffies +
+				  msecs_to_jiffies(
+					  params->report_batch_max_latency_ms)))
+		fira_session_report_flush(local, session);
+	return 0;
+}
+
+/* Number of ring records prepared before being pushed to the ring. */
+#define FIRA_REPORT_RING_RECORDS_CHUNK 8
+
+/**
+ * fira_session_report_ring_record() - Fill a ring record from a measurement.
+ * @session: Session to report.
+ * @ranging_data: Measurement.
+ * @rctu_freq_hz: RCTU frequency.
+ * @rec: Record to fill, session fields already set.
+ */
+static void
+fira_session_report_ring_record(const struct fira_session *session,
+				const struct fira_ranging_info *ranging_data,
+				s64 rctu_freq_hz,
+				struct fira_report_ring_record *rec)
+{
+	const struct fira_session_params *params = &session->params;
+	const struct fira_local_aoa_info *azimuth =
+		ranging_data->local_aoa_azimuth.present ?
+			&ranging_data->local_aoa_azimuth :
+			&ranging_data->local_aoa;
+
+	rec->short_addr = ranging_data->short_addr;
+	rec->status = ranging_data->status;
+	if (ranging_data->status) {
+		rec->slot_index = ranging_data->slot_index;
+		return;
+	}
+	if (ranging_data->tof_present) {
+		static const s64 speed_of_light_mm_per_s = 299702547000ull;
+
+		/* Computation needs to be kept in sync with fira_session_report_measurement() */
+		rec->distance_mm = div64_s64(ranging_data->tof_rctu *
+						     speed_of_light_mm_per_s,
+					     rctu_freq_hz);
+		rec->flags |= FIRA_REPORT_RING_RECORD_DISTANCE;
+	}
+	if (azimuth->present) {
+		rec->aoa_azimuth_2pi = azimuth->aoa_2pi;
+		rec->aoa_azimuth_fom = azimuth->aoa_fom;
+		rec->flags |= FIRA_REPORT_RING_RECORD_AOA_AZIMUTH;
+	}
+	if (ranging_data->local_aoa_elevation.present) {
+		rec->aoa_elevation_2pi =
+			ranging_data->local_aoa_elevation.aoa_2pi;
+		rec->aoa_elevation_fom =
+			ranging_data->local_aoa_elevation.aoa_fom;
+		rec->flags |= FIRA_REPORT_RING_RECORD_AOA_ELEVATION;
+	}
+	if (ranging_data->remote_aoa_azimuth_present) {
+		rec->remote_aoa_azimuth_2pi =
+			ranging_data->remote_aoa_azimuth_2pi;
+		rec->flags |= FIRA_REPORT_RING_RECORD_REMOTE_AOA_AZIMUTH;
+	}
+	if (ranging_data->remote_aoa_elevation_present) {
+		rec->remote_aoa_elevation_pi =
+			ranging_data->remote_aoa_elevation_pi;
+		rec->flags |= FIRA_REPORT_RING_RECORD_REMOTE_AOA_ELEVATION;
+	}
+	switch (params->report_rssi) {
+	case FIRA_RSSI_REPORT_MINIMUM:
+		rec->rssi = fira_compute_minimum_rssi(ranging_data);
+		rec->flags |= FIRA_REPORT_RING_RECORD_RSSI;
+		break;
+	case FIRA_RSSI_REPORT_AVERAGE:
+		rec->rssi = fira_compute_average_rssi(ranging_data);
+		rec->flags |= FIRA_REPORT_RING_RECORD_RSSI;
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * fira_session_report_ring() - Write a round in the report ring.
+ * @local: FiRa context.
+ * @session: Session to report.
+ * @report_info: Report information.
+ *
+ * Return: 0, or error if the round must be sent as a notification.
+ */
+static int fira_session_report_ring(struct fira_local *local,
+				    const struct fira_session *session,
+				    const struct fira_report_info *report_info)
+{
+	struct fira_report_ring_record recs[FIRA_REPORT_RING_RECORDS_CHUNK];
+	s64 rctu_freq_hz = (s64)local->llhw->dtu_freq_hz * local->llhw->dtu_rctu;
+	int n_records = report_info->n_ranging_data +
+			report_info->n_stopped_controlees;
+	int i, n = 0, r;
+
+	/* State changes are only reported as notifications. */
+	if (report_info->stopped)
+		return -ENODEV;
+	if (!local->report_ring)
+		return -ENODEV;
+	/* Keep the ring opened, so the report is not split with netlink. */
+	r = fira_report_ring_lock(local->report_ring);
+	if (r)
+		return r;
+
+	for (i = 0; i < n_records; i++) {
+		struct fira_report_ring_record *rec = &recs[n++];
+
+		memset(rec, 0, sizeof(*rec));
+		rec->session_id = session->id;
+		rec->sequence_number = session->sequence_number;
+		rec->block_index = session->block_index;
+		if (i < report_info->n_ranging_data) {
+			fira_session_report_ring_record(
+				session, &report_info->ranging_data[i],
+				rctu_freq_hz, rec);
+		} else {
+			rec->short_addr = report_info->stopped_controlees
+				[i - report_info->n_ranging_data];
+			rec->flags = FIRA_REPORT_RING_RECORD_STOPPED;
+		}
+		if (n == FIRA_REPORT_RING_RECORDS_CHUNK || i == n_records - 1) {
+			fira_report_ring_push(local->report_ring, recs, n);
+			n = 0;
+		}
+	}
+	fira_report_ring_unlock(local->report_ring);
+	return 0;
+}
+
 void fira_session_report(struct fira_local *local, struct fira_session *session,
 			 const struct fira_report_info *report_info)
 {
@@ -900,29 +1296,31 @@ void fira_session_report(struct fira_local *local, struct fira_session *session,
 	}
 
 	trace_region_fira_session_report(session, report_info);
-	msg = mcps802154_region_event_alloc_skb(local->llhw, &local->region,
-						FIRA_CALL_SESSION_NOTIFICATION,
-						session->event_portid,
-						NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	switch (params->report_mode) {
+	case FIRA_REPORT_MODE_BATCH:
+		if (!fira_session_report_batch(local, session, report_info))
+			goto reported;
+		break;
+	case FIRA_REPORT_MODE_RING:
+		if (!fira_session_report_ring(local, session, report_info))
+			goto reported;
+		break;
+	default:
+		break;
+	}
+
+	msg = fira_session_report_alloc(local, session,
+					fira_session_report_size(report_info));
 	if (!msg)
 		return;
-
-	if (nla_put_u32(msg, FIRA_CALL_ATTR_SESSION_ID, session->id))
+	if (fira_session_report_round(local, session, report_info, msg))
 		goto nla_put_failure;
-	if (nla_put_u32(msg, FIRA_CALL_ATTR_SEQUENCE_NUMBER,
-			session->sequence_number))
-		goto nla_put_failure;
-	if (fira_session_report_ranging_data(session, report_info,
-					     local->llhw->dtu_freq_hz,
-					     local->llhw->dtu_rctu, msg))
-		goto nla_put_failure;
-	if (fira_session_report_ranging_diagnostics(session, report_info, msg))
-		goto nla_put_failure;
-	session->sequence_number++;
-	session->data_payload.sent = false;
-
 	skb_queue_tail(&local->report_queue, msg);
 	schedule_work(&local->report_work);
+
+reported:
+	session->sequence_number++;
+	session->data_payload.sent = false;
 	return;
 
 nla_put_failure:
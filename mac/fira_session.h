@@ -156,6 +156,62 @@ struct fira_session_params {
 	enum fira_range_data_ntf_config range_data_ntf_config;
 	u32 range_data_ntf_proximity_near_mm;
 	u32 range_data_ntf_proximity_far_mm;
+	/* Report delivery */
+	enum fira_report_mode report_mode;
+	u8 report_batch_max_rounds;
+	u32 report_batch_max_latency_ms;
+};
+
+/**
+ * struct fira_session_round - Round state of a session, sized from the number
+ * of controlees when the session is started.
+ */
+struct fira_session_round {
+	/**
+	 * @n_controlees_max: Number of controlees the round state is sized
+	 * for, 0 when not allocated.
+	 */
+	int n_controlees_max;
+	/**
+	 * @frames: Access frames, FIRA_FRAMES_N(n_controlees_max) elements.
+	 */
+	struct mcps802154_access_frame *frames;
+	/**
+	 * @sts_params: STS parameters for access frames.
+	 */
+	struct mcps802154_sts_params *sts_params;
+	/**
+	 * @slots: Descriptions of each slots.
+	 */
+	struct fira_slot *slots;
+	/**
+	 * @diagnostics: Diagnostic collected for each slot.
+	 */
+	struct fira_diagnostic *diagnostics;
+	/**
+	 * @diagnostic_cirs: CIR diagnostics arena, &mcps802154_llhw.cir_n_max
+	 * CIR for each frame, followed by their sample windows. NULL when CIR
+	 * are not requested or when the low-level driver does not give its
+	 * limits.
+	 */
+	struct mcps802154_rx_cir *diagnostic_cirs;
+	/**
+	 * @diagnostic_cirs_size: Size of @diagnostic_cirs in bytes.
+	 */
+	size_t diagnostic_cirs_size;
+	/**
+	 * @ranging_info: Information on ranging, n_controlees_max elements.
+	 */
+	struct fira_ranging_info *ranging_info;
+	/**
+	 * @stopped_controlees: Short addresses of the stopped controlees.
+	 */
+	__le16 *stopped_controlees;
+	/**
+	 * @rx_ctx: Custom rx context for each controlee, NULL pointers when the
+	 * low-level driver does not use a rx context.
+	 */
+	void **rx_ctx;
 };
 
 /**
@@ -174,6 +230,22 @@ struct fira_session {
 	 * @entry: Entry in list of sessions.
 	 */
 	struct list_head entry;
+	/**
+	 * @election_node: Node in the election tree, when the session is active
+	 * with a valid block start.
+	 */
+	struct rb_node election_node;
+	/**
+	 * @election_entry: Entry in list of active sessions waiting for their
+	 * first block start.
+	 */
+	struct list_head election_entry;
+	/**
+	 * @election_key_dtu: Earliest timestamp of the next demand, normalised
+	 * against the election time, used to sort the election tree. Updated
+	 * when the session access is done or when its parameters change.
+	 */
+	s64 election_key_dtu;
 	/**
 	 * @state: State of the session.
 	 */
@@ -259,6 +331,28 @@ struct fira_session {
 	 * @round_hopping_sequence: Round hopping sequence generation context.
 	 */
 	struct fira_round_hopping_sequence round_hopping_sequence;
+	/**
+	 * @round_hopping_window: Precomputed round hopping hashes.
+	 */
+	struct {
+		/**
+		 * @base_block_index: Block index of the first hash.
+		 */
+		u32 base_block_index;
+		/**
+		 * @step: Number of blocks between two hashes, zero when the
+		 * window is invalid.
+		 */
+		int step;
+		/**
+		 * @n: Number of valid hashes.
+		 */
+		int n;
+		/**
+		 * @hash: Hash of each block index, used to build round index.
+		 */
+		u16 hash[FIRA_ROUND_HOPPING_CRYPTO_MAX_BLOCKS];
+	} round_hopping_window;
 	/**
 	 * @controlee: Group of persistent variable(s) used when session
 	 * is a controlee.
@@ -310,6 +404,27 @@ struct fira_session {
 		 */
 		bool sent;
 	} data_payload;
+	/**
+	 * @report_batch: Pending batched notification.
+	 */
+	struct {
+		/**
+		 * @msg: Notification being filled, or NULL.
+		 */
+		struct sk_buff *msg;
+		/**
+		 * @reports: Nested attribute holding the rounds of @msg.
+		 */
+		struct nlattr *reports;
+		/**
+		 * @n_rounds: Number of rounds in @msg.
+		 */
+		int n_rounds;
+		/**
+		 * @first_round_jiffies: Time of the first round in @msg.
+		 */
+		unsigned long first_round_jiffies;
+	} report_batch;
 	/**
 	 * @current_controlees: Current list of controlees.
 	 */
@@ -346,9 +461,9 @@ struct fira_session {
 		bool reset;
 	} measurements;
 	/**
-	 * @rx_ctx: Custom rx context for all controlees.
+	 * @round: Round state, allocated when the session is started.
 	 */
-	void *rx_ctx[FIRA_CONTROLEES_MAX];
+	struct fira_session_round round;
 	/**
 	 * @crypto: crypto related variables.
 	 */
@@ -459,6 +574,20 @@ struct fira_session *fira_session_new(struct fira_local *local, u32 session_id);
  */
 void fira_session_free(struct fira_local *local, struct fira_session *session);
 
+/**
+ * fira_session_round_alloc() - Size the round state for the controlees.
+ * @local: FiRa context.
+ * @session: Session to start.
+ *
+ * The round state is kept when it is already big enough, so it is allocated
+ * once when the session is started, and never on each round. This includes
+ * the CIR diagnostics arena when CIR reports are requested.
+ *
+ * Return: 0 or error.
+ */
+int fira_session_round_alloc(struct fira_local *local,
+			     struct fira_session *session);
+
 /**
  * fira_session_set_controlees() - Set controlees.
  * @local: FiRa context.
@@ -474,6 +603,7 @@ int fira_session_set_controlees(struct fira_local *local,
 
 /**
  * fira_session_new_controlees() - Add new controlees.
+ * @local: FiRa context.
  * @session: Session.
  * @controlees: List of controlees to add.
  * @n_controlees: Number of controlees.
@@ -481,7 +611,8 @@ int fira_session_set_controlees(struct fira_local *local,
  *
  * Return: 0 or error.
  */
-int fira_session_new_controlees(struct fira_session *session,
+int fira_session_new_controlees(struct fira_local *local,
+				struct fira_session *session,
 				struct list_head *controlees, int n_controlees,
 				bool async);
 
@@ -598,6 +729,14 @@ fira_session_get_rx_ant_set(const struct fira_session *session,
 void fira_session_report(struct fira_local *local, struct fira_session *session,
 			 const struct fira_report_info *report_info);
 
+/**
+ * fira_session_report_flush() - Send the pending batched notification.
+ * @local: FiRa context.
+ * @session: Session.
+ */
+void fira_session_report_flush(struct fira_local *local,
+			       struct fira_session *session);
+
 /**
  * fira_session_controlee_active() - Return whether the controlee is currently active.
  * @controlee: Controlee.
@@ -34,6 +34,8 @@ void fira_session_fsm_initialise(struct fira_local *local,
 				 struct fira_session *session)
 {
 	list_add(&session->entry, &local->inactive_sessions);
+	RB_CLEAR_NODE(&session->election_node);
+	INIT_LIST_HEAD(&session->election_entry);
 	session->state = &fira_session_fsm_init;
 	WARN_ON(!session->state->enter);
 	session->state->enter(local, session);
@@ -47,6 +49,7 @@ void fira_session_fsm_uninit(struct fira_local *local,
 
 	trace_region_fira_session_fsm_change_state(
 		session, FIRA_SESSION_STATE_ID_DEINIT);
+	fira_election_remove(local, session);
 	list_del(&session->entry);
 }
 
@@ -60,6 +63,7 @@ void fira_session_fsm_change_state(
 	session->state = new_state;
 	if (session->state->enter)
 		session->state->enter(local, session);
+	fira_election_update(local, session);
 }
 
 bool fira_session_is_active(const struct fira_session *session)
@@ -86,6 +90,9 @@ void fira_session_fsm_parameters_updated(struct fira_local *local,
 	/* The handler is defined for all states. */
 	WARN_ON(!session->state->parameters_updated);
 	session->state->parameters_updated(local, session);
+	/* Priority can change, remove to force the insertion. */
+	fira_election_remove(local, session);
+	fira_election_update(local, session);
 }
 
 void fira_session_fsm_controlee_list_updated(struct fira_local *local,
@@ -131,19 +138,24 @@ fira_session_fsm_get_access(struct fira_local *local,
 			    struct fira_session *session,
 			    const struct fira_session_demand *session_demand)
 {
+	struct mcps802154_access *access;
+
 	/*
 	 * fira_get_access will not call this function without an
 	 * active session.
 	 */
 	WARN_ON(!session->state->get_access);
-	return session->state->get_access(local, session, session_demand);
+	access = session->state->get_access(local, session, session_demand);
+	fira_election_update(local, session);
+	return access;
 }
 
 void fira_session_fsm_access_done(struct fira_local *local,
 				  struct fira_session *session, bool error)
 {
 	WARN_ON(!session->state->access_done);
-	return session->state->access_done(local, session, error);
+	session->state->access_done(local, session, error);
+	fira_election_update(local, session);
 }
 
 void fira_session_fsm_check_missed_ranging(struct fira_local *local,
@@ -151,6 +163,6 @@ void fira_session_fsm_check_missed_ranging(struct fira_local *local,
 					   u32 timestamp_dtu)
 {
 	WARN_ON(!session->state->check_missed_ranging);
-	return session->state->check_missed_ranging(local, session,
-						    timestamp_dtu);
+	session->state->check_missed_ranging(local, session, timestamp_dtu);
+	fira_election_update(local, session);
 }
@@ -264,6 +264,9 @@ static void ranging_round_done(struct fira_local *local,
 			       struct fira_report_info *report_info)
 {
 	const struct fira_session_params *params = &session->params;
+	bool hopping = params->device_type == FIRA_DEVICE_TYPE_CONTROLEE ?
+			       session->controlee.hopping_mode :
+			       params->round_hopping;
 
 	session->next_access_timestamp_dtu =
 		get_next_access_timestamp_dtu(local, session);
@@ -275,13 +278,16 @@ static void ranging_round_done(struct fira_local *local,
 		/* Update controlee's states between two ranging round. */
 		fira_session_update_controlees(local, session);
 		fira_sts_rotate_keys(session);
+		fira_sts_prefetch_keys(session);
 		break;
 	case FIRA_DEVICE_TYPE_CONTROLEE:
 		/* Did the controlee's access lose the synchronisation? */
 		session->controlee.synchronised =
 			is_controlee_synchronised(local, session);
-		if (session->controlee.synchronised)
+		if (session->controlee.synchronised) {
 			fira_sts_rotate_keys(session);
+			fira_sts_prefetch_keys(session);
+		}
 		break;
 	}
 
@@ -292,6 +298,10 @@ static void ranging_round_done(struct fira_local *local,
 					      &fira_session_fsm_idle);
 	} else {
 		forward_to_next_ranging(session, 1);
+		/* Precompute next round indexes outside of the access. */
+		if (hopping)
+			fira_round_hopping_sequence_prefetch(
+				session, session->block_index);
 	}
 }
 
@@ -310,6 +320,7 @@ static void fira_session_fsm_active_enter(struct fira_local *local,
 	session->controlee.next_round_index_valid = false;
 	session->controlee.block_index_sync = 0;
 	session->round_index = 0;
+	fira_round_hopping_sequence_invalidate(session);
 	/*
 	 * Initialize to 1 when initiation_time_ms is 0,
 	 * because first add_blocks built will be 0.
@@ -322,6 +333,7 @@ static void fira_session_fsm_active_enter(struct fira_local *local,
 static void fira_session_fsm_active_leave(struct fira_local *local,
 					  struct fira_session *session)
 {
+	fira_session_report_flush(local, session);
 	fira_sts_deinit(session);
 	list_move(&session->entry, &local->inactive_sessions);
 	fira_session_restart_controlees(session);
@@ -735,6 +747,13 @@ fira_session_fsm_active_get_access(struct fira_local *local,
 	 * (\   /____\
 	 */
 	local->current_session = session;
+	/* Round state used during the access. */
+	local->frames = session->round.frames;
+	local->sts_params = session->round.sts_params;
+	local->slots = session->round.slots;
+	local->diagnostics = session->round.diagnostics;
+	local->ranging_info = session->round.ranging_info;
+	local->stopped_controlees = session->round.stopped_controlees;
 
 	/*
 	 * Update common access fields for controlee and controller.
@@ -926,11 +945,11 @@ fira_session_fsm_active_check_missed_ranging(struct fira_local *local,
 		 */
 		WARN_RETURN_VOID_ON(local->current_session);
 		/* Build a missed ranging round report. */
-		report_info.ranging_data = local->ranging_info;
+		report_info.ranging_data = session->round.ranging_info;
 		switch (params->device_type) {
 		default:
 		case FIRA_DEVICE_TYPE_CONTROLLER:
-			pend_del = local->stopped_controlees;
+			pend_del = session->round.stopped_controlees;
 			j = k = 0;
 			list_for_each_entry (controlee,
 					     &session->current_controlees,
@@ -939,7 +958,7 @@ fira_session_fsm_active_check_missed_ranging(struct fira_local *local,
 				case FIRA_CONTROLEE_STATE_RUNNING:
 				case FIRA_CONTROLEE_STATE_PENDING_STOP:
 				case FIRA_CONTROLEE_STATE_PENDING_DEL:
-					ri = &local->ranging_info[j];
+					ri = &session->round.ranging_info[j];
 					*ri = (struct fira_ranging_info){
 						.short_addr =
 							controlee->short_addr,
@@ -958,7 +977,7 @@ fira_session_fsm_active_check_missed_ranging(struct fira_local *local,
 			report_info.n_ranging_data = j;
 			break;
 		case FIRA_DEVICE_TYPE_CONTROLEE:
-			ri = &local->ranging_info[0];
+			ri = &session->round.ranging_info[0];
 			*ri = (struct fira_ranging_info){
 				.short_addr = params->controller_short_addr,
 				.status = FIRA_STATUS_RANGING_RX_TIMEOUT,
@@ -79,6 +79,10 @@ static int fira_session_fsm_idle_start(struct fira_local *local,
 	if (r)
 		return r;
 
+	r = fira_session_round_alloc(local, session);
+	if (r)
+		return r;
+
 	/* Update session. */
 	session->event_portid = info->snd_portid;
 	session->block_start_valid = false;
@@ -182,6 +182,27 @@ int fira_sts_rotate_keys(struct fira_session *session)
 	return r;
 }
 
+int fira_sts_prefetch_keys(struct fira_session *session)
+{
+	const struct fira_session_params *params = &session->params;
+	u32 rotation_period;
+	u32 n_slots_per_block;
+	u32 next_rotation_block_index;
+
+	if (params->sts_config == FIRA_STS_MODE_STATIC || !params->key_rotation)
+		return 0;
+
+	rotation_period = (1 << params->key_rotation_rate);
+	n_slots_per_block =
+		(params->block_duration_dtu / params->slot_duration_dtu);
+	next_rotation_block_index =
+		session->sts.last_rotation_block_index + rotation_period;
+	return fira_crypto_prefetch_elements(
+		session->crypto, session->sts.phy_sts_index_init +
+					 (next_rotation_block_index *
+					  n_slots_per_block));
+}
+
 int fira_sts_get_sts_params(struct fira_session *session, u32 slot_index,
 			    u8 *sts_v, u32 sts_v_size, u8 *sts_key,
 			    u32 sts_key_size)
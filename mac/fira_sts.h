@@ -61,6 +61,15 @@ void fira_sts_deinit(struct fira_session *session);
  */
 int fira_sts_rotate_keys(struct fira_session *session);
 
+/**
+ * fira_sts_prefetch_keys() - Derive crypto keys of the next rotation ahead of
+ * time, so that the rotation does not have to run the KDF.
+ * @session: The session for which keys are prefetched.
+ *
+ * Return: 0 or error.
+ */
+int fira_sts_prefetch_keys(struct fira_session *session);
+
 /**
  * fira_sts_get_sts_params() - To fetch sts_params in order to configure the
  * current frame.
@@ -174,10 +174,12 @@ TRACE_DEFINE_ENUM(MCPS802154_RX_ERROR_OTHER);
 #define MCPS802154_TX_REASON_SYMBOLS                                 \
 	mcps802154_tx_reason_name(CONSUMED),                         \
 	mcps802154_tx_reason_name(FAILURE),                          \
-	mcps802154_tx_reason_name(CANCEL)
+	mcps802154_tx_reason_name(CANCEL),                           \
+	mcps802154_tx_reason_name(UNUSED)
 TRACE_DEFINE_ENUM(MCPS802154_ACCESS_TX_RETURN_REASON_CONSUMED);
 TRACE_DEFINE_ENUM(MCPS802154_ACCESS_TX_RETURN_REASON_FAILURE);
 TRACE_DEFINE_ENUM(MCPS802154_ACCESS_TX_RETURN_REASON_CANCEL);
+TRACE_DEFINE_ENUM(MCPS802154_ACCESS_TX_RETURN_REASON_UNUSED);
 
 #define FIRA_MEAS_SEQ_STEP_TYPE                                   \
 	{ FIRA_MEASUREMENT_TYPE_RANGE, "range" },                   \
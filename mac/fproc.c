@@ -47,6 +47,7 @@ bool mcps802154_fproc_is_non_recoverable_error(struct mcps802154_access *access)
 void mcps802154_fproc_init(struct mcps802154_local *local)
 {
 	local->fproc.state = &mcps802154_fproc_stopped;
+	local->fproc.prepared_frame_idx = -1;
 	WARN_ON(!local->fproc.state->enter);
 	local->fproc.state->enter(local);
 }
@@ -55,10 +56,31 @@ void mcps802154_fproc_uninit(struct mcps802154_local *local)
 {
 	WARN_ON(local->fproc.access);
 	WARN_ON(local->fproc.tx_skb);
+	WARN_ON(local->fproc.prepared_frame_idx >= 0);
 	WARN_ON(local->started);
 	WARN_ON(local->fproc.deferred);
 }
 
+void mcps802154_fproc_release_prepared(struct mcps802154_local *local)
+{
+	struct mcps802154_access *access = local->fproc.access;
+	int frame_idx = local->fproc.prepared_frame_idx;
+
+	if (frame_idx < 0)
+		return;
+	/*
+	 * Only a hint to the low-level driver, an error is not an issue: later
+	 * frames are not flagged as prepared unless preloaded again.
+	 */
+	if (local->fproc.prepared_in_llhw)
+		llhw_tx_prepare_frame(local, NULL, frame_idx);
+	access->ops->tx_return(access, frame_idx, local->fproc.prepared_skb,
+			       MCPS802154_ACCESS_TX_RETURN_REASON_UNUSED);
+	local->fproc.prepared_skb = NULL;
+	local->fproc.prepared_frame_idx = -1;
+	local->fproc.prepared_in_llhw = false;
+}
+
 void mcps802154_fproc_change_state(
 	struct mcps802154_local *local,
 	const struct mcps802154_fproc_state *new_state)
@@ -142,6 +164,7 @@ void mcps802154_fproc_access_done(struct mcps802154_local *local, bool error)
 {
 	struct mcps802154_access *access = local->fproc.access;
 
+	mcps802154_fproc_release_prepared(local);
 	if (access->common_ops->access_done)
 		access->common_ops->access_done(access, error);
 	local->fproc.access = NULL;
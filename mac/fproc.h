@@ -68,6 +68,18 @@ struct mcps802154_fproc {
 	struct sk_buff *tx_skb;
 	/** @frame_idx: Frame index for multiple frames method. */
 	size_t frame_idx;
+	/**
+	 * @prepared_skb: Buffer of the next frame, prepared while the current
+	 * frame is in progress, for multiple frames method.
+	 */
+	struct sk_buff *prepared_skb;
+	/** @prepared_frame_idx: Index of the prepared frame, or -1. */
+	int prepared_frame_idx;
+	/**
+	 * @prepared_in_llhw: True if the prepared frame data was preloaded by
+	 * the low-level driver.
+	 */
+	bool prepared_in_llhw;
 	/** @deferred: Pointer to region context requesting deferred call. */
 	struct mcps802154_region *deferred;
 };
@@ -86,6 +98,13 @@ void mcps802154_fproc_init(struct mcps802154_local *local);
  */
 void mcps802154_fproc_uninit(struct mcps802154_local *local);
 
+/**
+ * mcps802154_fproc_release_prepared() - Give back the prepared frame, if any,
+ * to the region.
+ * @local: MCPS private data.
+ */
+void mcps802154_fproc_release_prepared(struct mcps802154_local *local);
+
 /**
  * mcps802154_fproc_change_state() - Change the active state.
  * @local: MCPS private data.
@@ -22,11 +22,17 @@
  */
 
 #include <linux/errno.h>
+#include <linux/module.h>
 
 #include "mcps802154_fproc.h"
 #include "mcps802154_i.h"
 #include "llhw-ops.h"
 
+static bool pipeline = true;
+module_param(pipeline, bool, 0644);
+MODULE_PARM_DESC(pipeline,
+		 "Prepare the next frame while the current one is in progress");
+
 static int mcps802154_fproc_multi_handle_frame(struct mcps802154_local *local,
 					       struct mcps802154_access *access,
 					       size_t frame_idx);
@@ -109,6 +115,11 @@ static void mcps802154_fproc_multi_next(struct mcps802154_local *local,
 					size_t frame_idx)
 {
 	frame_idx++;
+	if (local->fproc.prepared_frame_idx >= 0 &&
+	    ((size_t)local->fproc.prepared_frame_idx != frame_idx ||
+	     frame_idx >= access->n_frames))
+		/* Access was shortened. */
+		mcps802154_fproc_release_prepared(local);
 	if (access->ops->access_extend && frame_idx == access->n_frames) {
 		frame_idx = 0;
 		access->n_frames = 0;
@@ -299,6 +310,45 @@ static const struct mcps802154_fproc_state mcps802154_fproc_multi_tx = {
 	.schedule_change = mcps802154_fproc_multi_tx_schedule_change,
 };
 
+/**
+ * mcps802154_fproc_multi_prepare_next() - Prepare the frame following the one
+ * just programmed.
+ * @local: MCPS private data.
+ * @access: Current access to handle.
+ * @frame_idx: Index of the frame just programmed.
+ *
+ * When the region allows it, the next TX frame is requested while the current
+ * frame is in progress. While receiving, the low-level driver is also asked
+ * to preload it, so that only the transmission is left to program once the
+ * current frame is done.
+ */
+static void
+mcps802154_fproc_multi_prepare_next(struct mcps802154_local *local,
+				    struct mcps802154_access *access,
+				    size_t frame_idx)
+{
+	const struct mcps802154_access_frame *frame = &access->frames[frame_idx];
+	const struct mcps802154_access_frame *next_frame;
+	size_t next_frame_idx = frame_idx + 1;
+	struct sk_buff *skb;
+
+	if (!pipeline || next_frame_idx >= access->n_frames)
+		return;
+	next_frame = &access->frames[next_frame_idx];
+	if (!next_frame->is_tx || !next_frame->tx_prepare_early ||
+	    next_frame->tx_frame_config.rx_enable_after_tx_dtu)
+		return;
+
+	skb = access->ops->tx_get_frame(access, next_frame_idx);
+	local->fproc.prepared_skb = skb;
+	local->fproc.prepared_frame_idx = next_frame_idx;
+	/* TX buffer is in use while transmitting. Errors are not fatal, the
+	 * frame is then written when it is transmitted. */
+	local->fproc.prepared_in_llhw =
+		skb && !frame->is_tx &&
+		!llhw_tx_prepare_frame(local, skb, next_frame_idx);
+}
+
 /**
  * mcps802154_fproc_multi_handle_frame() - Handle a single frame and change
  * state.
@@ -313,6 +363,8 @@ static int mcps802154_fproc_multi_handle_frame(struct mcps802154_local *local,
 					       size_t frame_idx)
 {
 	struct mcps802154_access_frame *frame;
+	const struct mcps802154_tx_frame_config *tx_config;
+	struct mcps802154_tx_frame_config prepared_config;
 	struct sk_buff *skb;
 	int r;
 
@@ -337,13 +389,26 @@ static int mcps802154_fproc_multi_handle_frame(struct mcps802154_local *local,
 
 		mcps802154_fproc_change_state(local,
 					      &mcps802154_fproc_multi_rx);
+		mcps802154_fproc_multi_prepare_next(local, access, frame_idx);
 	} else {
 		if (frame->tx_frame_config.rx_enable_after_tx_dtu)
 			return -EINVAL;
 
-		skb = access->ops->tx_get_frame(access, frame_idx);
-
-		/* TODO: prepare next RX directly. */
+		tx_config = &frame->tx_frame_config;
+		if (local->fproc.prepared_frame_idx == (int)frame_idx) {
+			skb = local->fproc.prepared_skb;
+			if (local->fproc.prepared_in_llhw) {
+				prepared_config = *tx_config;
+				prepared_config.flags |=
+					MCPS802154_TX_FRAME_CONFIG_PREPARED;
+				tx_config = &prepared_config;
+			}
+			local->fproc.prepared_skb = NULL;
+			local->fproc.prepared_frame_idx = -1;
+			local->fproc.prepared_in_llhw = false;
+		} else {
+			skb = access->ops->tx_get_frame(access, frame_idx);
+		}
 
 		if (frame->sts_params) {
 			r = llhw_set_sts_params(local, frame->sts_params);
@@ -355,8 +420,7 @@ static int mcps802154_fproc_multi_handle_frame(struct mcps802154_local *local,
 			}
 		}
 
-		r = llhw_tx_frame(local, skb, &frame->tx_frame_config,
-				  frame_idx, 0);
+		r = llhw_tx_frame(local, skb, tx_config, frame_idx, 0);
 		if (r) {
 			access->ops->tx_return(
 				access, frame_idx, skb,
@@ -368,6 +432,7 @@ static int mcps802154_fproc_multi_handle_frame(struct mcps802154_local *local,
 		mcps802154_ca_access_hold(local);
 		mcps802154_fproc_change_state(local,
 					      &mcps802154_fproc_multi_tx);
+		mcps802154_fproc_multi_prepare_next(local, access, frame_idx);
 	}
 
 	return 0;
@@ -275,6 +275,9 @@ enum fira_capability_attrs {
  *	Session notification counter.
  * @FIRA_CALL_ATTR_RANGING_DIAGNOSTICS:
  * 	Diagnostic information.
+ * @FIRA_CALL_ATTR_REPORTS:
+ *	Batched session notifications, one nested entry per round with
+ *	SEQUENCE_NUMBER, RANGING_DATA and RANGING_DIAGNOSTICS attributes.
  *
  * @FIRA_CALL_ATTR_UNSPEC: Invalid command.
  * @__FIRA_CALL_ATTR_AFTER_LAST: Internal use.
@@ -291,6 +294,7 @@ enum fira_call_attrs {
 	FIRA_CALL_ATTR_SESSION_COUNT,
 	FIRA_CALL_ATTR_SEQUENCE_NUMBER,
 	FIRA_CALL_ATTR_RANGING_DIAGNOSTICS,
+	FIRA_CALL_ATTR_REPORTS,
 
 	__FIRA_CALL_ATTR_AFTER_LAST,
 	FIRA_CALL_ATTR_MAX = __FIRA_CALL_ATTR_AFTER_LAST - 1
@@ -416,6 +420,15 @@ enum fira_call_attrs {
  * @FIRA_SESSION_PARAM_ATTR_RANGE_DATA_NTF_PROXIMITY_FAR:
  *       Upper bound in cm above which the ranging notifications
  *       should be disabled when RANGE_DATA_NTF_CONFIG is set to "proximity"
+ * @FIRA_SESSION_PARAM_ATTR_REPORT_MODE:
+ *	Delivery of range data notifications, one notification per round (0,
+ *	default), batched notifications (1) or report ring (2), see
+ *	&enum fira_report_mode
+ * @FIRA_SESSION_PARAM_ATTR_REPORT_BATCH_MAX_ROUNDS:
+ *	Maximum number of rounds in a batched notification, 1 to 32, default 8
+ * @FIRA_SESSION_PARAM_ATTR_REPORT_BATCH_MAX_LATENCY_MS:
+ *	Age of the oldest round after which a batched notification is sent,
+ *	default 100 ms
  *
  * @FIRA_SESSION_PARAM_ATTR_UNSPEC: Invalid command.
  * @__FIRA_SESSION_PARAM_ATTR_AFTER_LAST: Internal use.
@@ -489,6 +502,10 @@ enum fira_session_param_attrs {
 	FIRA_SESSION_PARAM_ATTR_RANGE_DATA_NTF_CONFIG,
 	FIRA_SESSION_PARAM_ATTR_RANGE_DATA_NTF_PROXIMITY_NEAR,
 	FIRA_SESSION_PARAM_ATTR_RANGE_DATA_NTF_PROXIMITY_FAR,
+	/* Report delivery */
+	FIRA_SESSION_PARAM_ATTR_REPORT_MODE,
+	FIRA_SESSION_PARAM_ATTR_REPORT_BATCH_MAX_ROUNDS,
+	FIRA_SESSION_PARAM_ATTR_REPORT_BATCH_MAX_LATENCY_MS,
 	__FIRA_SESSION_PARAM_ATTR_AFTER_LAST,
 	FIRA_SESSION_PARAM_ATTR_MAX = __FIRA_SESSION_PARAM_ATTR_AFTER_LAST - 1
 };
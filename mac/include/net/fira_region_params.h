@@ -30,7 +30,7 @@
 #define FIRA_STS_VUPPER64_OFFSET 8
 #define FIRA_KEY_SIZE_MAX 16
 #define FIRA_KEY_SIZE_MIN 16
-#define FIRA_CONTROLEES_MAX 8
+#define FIRA_CONTROLEES_MAX 64
 #define FIRA_RX_ANTENNA_PAIR_INVALID 0xff
 /*
  * In BPRF, frame is at most 127
@@ -380,4 +380,19 @@ enum fira_range_data_ntf_config {
 	FIRA_RANGE_DATA_NTF_PROXIMITY = 2
 };
 
+/**
+ * enum fira_report_mode - Delivery of range data notifications.
+ * @FIRA_REPORT_MODE_ROUND: One netlink notification per round.
+ * @FIRA_REPORT_MODE_BATCH: Rounds are packed in a single netlink
+ * notification, up to a number of rounds, a size or a latency threshold.
+ * @FIRA_REPORT_MODE_RING: Measurements are written as compact records in the
+ * shared report ring, netlink is only used for state changes or when the ring
+ * is not opened.
+ */
+enum fira_report_mode {
+	FIRA_REPORT_MODE_ROUND = 0,
+	FIRA_REPORT_MODE_BATCH = 1,
+	FIRA_REPORT_MODE_RING = 2,
+};
+
 #endif /* NET_FIRA_REGION_PARAMS_H */
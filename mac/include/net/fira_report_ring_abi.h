@@ -0,0 +1,114 @@
+/*
+ * This file is part of the UWB stack for linux.
+ *
+ * Copyright (c) 2022 Qorvo US, Inc.
+ *
+ * This software is provided under the GNU General Public License, version 2
+ * (GPLv2), as well as under a Qorvo commercial license.
+ *
+ * You may choose to use this software under the terms of the GPLv2 License,
+ * version 2 ("GPLv2"), as published by the Free Software Foundation.
+ * You should have received a copy of the GPLv2 along with this program.  If
+ * not, see <http://www.gnu.org/licenses/>.
+ *
+ * This program is distributed under the GPLv2 in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GPLv2 for more
+ * details.
+ *
+ * If you cannot meet the requirements of the GPLv2, you may not use this
+ * software for any purpose without first obtaining a commercial license from
+ * Qorvo. Please contact Qorvo to inquire about licensing terms.
+ */
+
+#ifndef NET_FIRA_REPORT_RING_ABI_H
+#define NET_FIRA_REPORT_RING_ABI_H
+
+#include <linux/types.h>
+
+/**
+ * struct fira_report_ring_header - Report ring header, shared with user.
+ * @head: Count of written records, only updated by the kernel.
+ * @tail: Count of consumed records, only updated by the user.
+ * @nr_records: Number of record slots following the header, set by the kernel.
+ * @record_size: Size in bytes of each record slot, set by the kernel.
+ * @dropped: Records dropped because the ring was full.
+ * @written: Records written since the device was opened.
+ *
+ * The ring is mapped in user space with mmap(). Record n is located at
+ * offset sizeof(header) + (n % @nr_records) * @record_size. The kernel
+ * publishes a record by incrementing @head after the record is written, the
+ * user releases it by incrementing @tail once consumed.
+ *
+ * The kernel only publishes @head, @nr_records and @record_size here, it
+ * never reads them back, and it validates @tail.
+ */
+struct fira_report_ring_header {
+	__u32 head;
+	__u32 tail;
+	__u32 nr_records;
+	__u32 record_size;
+	__u64 dropped;
+	__u64 written;
+};
+
+/**
+ * enum fira_report_ring_record_flags - Fields present in a ring record.
+ * @FIRA_REPORT_RING_RECORD_DISTANCE: Distance is present.
+ * @FIRA_REPORT_RING_RECORD_AOA_AZIMUTH: Local azimuth AoA is present.
+ * @FIRA_REPORT_RING_RECORD_AOA_ELEVATION: Local elevation AoA is present.
+ * @FIRA_REPORT_RING_RECORD_REMOTE_AOA_AZIMUTH: Remote azimuth AoA is present.
+ * @FIRA_REPORT_RING_RECORD_REMOTE_AOA_ELEVATION: Remote elevation AoA is
+ * present.
+ * @FIRA_REPORT_RING_RECORD_RSSI: RSSI is present.
+ * @FIRA_REPORT_RING_RECORD_STOPPED: Controlee is stopped, only the short
+ * address is valid.
+ */
+enum fira_report_ring_record_flags {
+	FIRA_REPORT_RING_RECORD_DISTANCE = 1 << 0,
+	FIRA_REPORT_RING_RECORD_AOA_AZIMUTH = 1 << 1,
+	FIRA_REPORT_RING_RECORD_AOA_ELEVATION = 1 << 2,
+	FIRA_REPORT_RING_RECORD_REMOTE_AOA_AZIMUTH = 1 << 3,
+	FIRA_REPORT_RING_RECORD_REMOTE_AOA_ELEVATION = 1 << 4,
+	FIRA_REPORT_RING_RECORD_RSSI = 1 << 5,
+	FIRA_REPORT_RING_RECORD_STOPPED = 1 << 6,
+};
+
+/**
+ * struct fira_report_ring_record - Report ring record, one per measurement.
+ * @session_id: Session identifier.
+ * @sequence_number: Session notification counter of the round.
+ * @block_index: Block index of the round.
+ * @distance_mm: Distance in millimeters.
+ * @aoa_azimuth_2pi: Local azimuth AoA.
+ * @aoa_elevation_2pi: Local elevation AoA.
+ * @remote_aoa_azimuth_2pi: Remote azimuth AoA.
+ * @remote_aoa_elevation_pi: Remote elevation AoA.
+ * @short_addr: Peer short address.
+ * @status: Ranging status, see &enum fira_ranging_status.
+ * @slot_index: Slot index of the failure, when @status is not success.
+ * @aoa_azimuth_fom: Local azimuth AoA figure of merit.
+ * @aoa_elevation_fom: Local elevation AoA figure of merit.
+ * @rssi: RSSI, as configured by the REPORT_RSSI session parameter.
+ * @flags: Fields present in the record, see
+ * &enum fira_report_ring_record_flags.
+ */
+struct fira_report_ring_record {
+	__u32 session_id;
+	__u32 sequence_number;
+	__u32 block_index;
+	__s32 distance_mm;
+	__s16 aoa_azimuth_2pi;
+	__s16 aoa_elevation_2pi;
+	__s16 remote_aoa_azimuth_2pi;
+	__s16 remote_aoa_elevation_pi;
+	__u16 short_addr;
+	__u8 status;
+	__u8 slot_index;
+	__u8 aoa_azimuth_fom;
+	__u8 aoa_elevation_fom;
+	__u8 rssi;
+	__u8 flags;
+};
+
+#endif /* NET_FIRA_REPORT_RING_ABI_H */
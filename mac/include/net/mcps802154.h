@@ -278,6 +278,26 @@ struct mcps802154_llhw {
 	 * @rx_ctx_size: size of the context.
 	 */
 	u32 rx_ctx_size;
+	/**
+	 * @frame_len_max: Maximum PSDU length in bytes, FCS included, which
+	 * can be transmitted or received, 0 if unknown.
+	 */
+	int frame_len_max;
+	/**
+	 * @cir_n_max: Maximum number of CIR parts reported for a frame in
+	 * &struct mcps802154_rx_measurement_info, 0 if unknown.
+	 *
+	 * A low-level driver which reports MCPS802154_RX_MEASUREMENTS_CIRS
+	 * should set it with @cir_window_size_max, else the CIR diagnostics
+	 * are allocated for each received frame.
+	 */
+	int cir_n_max;
+	/**
+	 * @cir_window_size_max: Maximum size in bytes of one CIR sample
+	 * window, 0 if unknown. Used with @cir_n_max to preallocate storage
+	 * for CIR diagnostics.
+	 */
+	int cir_window_size_max;
 };
 
 /**
@@ -309,6 +329,9 @@ struct mcps802154_llhw {
  * @MCPS802154_TX_FRAME_CONFIG_RANGING_ROUND:
  *	Inform low-level driver the transmitted frame is the start of a ranging
  *	round (RDEV only).
+ * @MCPS802154_TX_FRAME_CONFIG_PREPARED:
+ *	The frame data was successfully preloaded with
+ *	&mcps802154_ops.tx_prepare_frame() for this frame index.
  *
  * If no timestamp flag is given, transmit as soon as possible.
  */
@@ -323,6 +346,7 @@ enum mcps802154_tx_frame_config_flags {
 	MCPS802154_TX_FRAME_CONFIG_SP3 = BIT(5) | BIT(6),
 	MCPS802154_TX_FRAME_CONFIG_STS_MODE_MASK = BIT(5) | BIT(6),
 	MCPS802154_TX_FRAME_CONFIG_RANGING_ROUND = BIT(7),
+	MCPS802154_TX_FRAME_CONFIG_PREPARED = BIT(8),
 };
 
 /**
@@ -348,7 +372,7 @@ struct mcps802154_tx_frame_config {
 	/**
 	 * @flags: See &enum mcps802154_tx_frame_config_flags.
 	 */
-	u8 flags;
+	u16 flags;
 	/**
 	 * @ant_set_id : antenna set index to use for transmit.
 	 */
@@ -1003,6 +1027,24 @@ struct mcps802154_power_stats {
 	u64 interrupts;
 };
 
+/**
+ * struct mcps802154_calibration - Calibration value to set.
+ */
+struct mcps802154_calibration {
+	/**
+	 * @key: Calibration key string.
+	 */
+	const char *key;
+	/**
+	 * @value: Calibration value.
+	 */
+	void *value;
+	/**
+	 * @length: Length of @value in bytes.
+	 */
+	size_t length;
+};
+
 /**
  * struct mcps802154_ops - Callback from MCPS to the driver.
  */
@@ -1053,6 +1095,26 @@ struct mcps802154_ops {
 	int (*rx_enable)(struct mcps802154_llhw *llhw,
 			 const struct mcps802154_rx_frame_config *config,
 			 int frame_idx, int next_delay_dtu);
+	/**
+	 * @tx_prepare_frame: Optional. Preload the data of the next frame to
+	 * transmit while a reception is in progress, so that the next
+	 * &mcps802154_ops.tx_frame() call for the same frame index, with the
+	 * MCPS802154_TX_FRAME_CONFIG_PREPARED flag, only has to program the
+	 * transmission.
+	 *
+	 * The &frame_idx parameter gives the index of the prepared frame in the
+	 * "block".
+	 *
+	 * Called with a NULL skb to drop the prepared data, when the frame will
+	 * not be transmitted. The prepared data must also be dropped on reset
+	 * and stop. Without the MCPS802154_TX_FRAME_CONFIG_PREPARED flag, the
+	 * frame data is always written by tx_frame.
+	 *
+	 * Return: 0, -EBUSY if the frame can not be prepared now, or any other
+	 * error. On error, the frame data is written by tx_frame as usual.
+	 */
+	int (*tx_prepare_frame)(struct mcps802154_llhw *llhw,
+				struct sk_buff *skb, int frame_idx);
 	/**
 	 * @rx_disable: Disable receiver, or a programmed receiver enabling,
 	 * unless a frame reception is happening right now.
@@ -1245,6 +1307,21 @@ struct mcps802154_ops {
 	 */
 	int (*set_calibration)(struct mcps802154_llhw *llhw, const char *key,
 			       void *value, size_t length);
+	/**
+	 * @set_calibrations: Set several calibration values. Optional, used
+	 * in place of @set_calibration for a list of values, so that the
+	 * low-level driver can update its configuration once for all of them.
+	 *
+	 * Values are set in order, and setting stops on the first error. The
+	 * number of values set is stored in n_set, which is also the index of
+	 * the failing value on error.
+	 *
+	 * Return: 0 or error.
+	 */
+	int (*set_calibrations)(
+		struct mcps802154_llhw *llhw,
+		const struct mcps802154_calibration *calibrations,
+		int n_calibrations, int *n_set);
 	/**
 	 * @get_calibration: Get calibration value.
 	 *
@@ -74,12 +74,17 @@ enum mcps802154_access_method {
  * @MCPS802154_ACCESS_TX_RETURN_REASON_CANCEL:
  *	No attempt was done to deliver the frame, or there was an unexpected
  *	error doing it.
+ * @MCPS802154_TX_ERROR_HPDWARN:
+ *	Frame was programmed too late.
+ * @MCPS802154_ACCESS_TX_RETURN_REASON_UNUSED:
+ *	Frame was prepared in advance, but the access ended before it was due.
  */
 enum mcps802154_access_tx_return_reason {
 	MCPS802154_ACCESS_TX_RETURN_REASON_CONSUMED,
 	MCPS802154_ACCESS_TX_RETURN_REASON_FAILURE,
 	MCPS802154_ACCESS_TX_RETURN_REASON_CANCEL,
 	MCPS802154_TX_ERROR_HPDWARN,
+	MCPS802154_ACCESS_TX_RETURN_REASON_UNUSED,
 };
 
 /**
@@ -123,6 +128,12 @@ struct mcps802154_access_frame {
 	 * after the previous callback.
 	 */
 	const struct mcps802154_sts_params *sts_params;
+	/**
+	 * @tx_prepare_early: For TX, the frame content does not depend on the
+	 * result of the previous frames, so mcps802154_access::tx_get_frame()
+	 * can be called while the previous frame is in progress.
+	 */
+	bool tx_prepare_early;
 };
 
 /**
@@ -508,6 +519,11 @@ struct mcps802154_scheduler_ops {
 	 * @notify_stop: Notify a scheduler that device has been stopped.
 	 */
 	void (*notify_stop)(struct mcps802154_scheduler *scheduler);
+	/**
+	 * @notify_change: Notify a scheduler that regions demands may have
+	 * changed. Return true when the current schedule must be rebuilt.
+	 */
+	bool (*notify_change)(struct mcps802154_scheduler *scheduler);
 	/**
 	 * @set_parameters: Configure the scheduler.
 	 */
@@ -73,6 +73,20 @@ static inline int llhw_rx_enable(struct mcps802154_local *local,
 	return r;
 }
 
+static inline int llhw_tx_prepare_frame(struct mcps802154_local *local,
+					struct sk_buff *skb, int frame_idx)
+{
+	int r;
+
+	trace_llhw_tx_prepare_frame(local, skb, frame_idx);
+	if (local->ops->tx_prepare_frame)
+		r = local->ops->tx_prepare_frame(&local->llhw, skb, frame_idx);
+	else
+		r = -EOPNOTSUPP;
+	trace_llhw_return_int(local, r);
+	return r;
+}
+
 static inline int llhw_rx_disable(struct mcps802154_local *local)
 {
 	int r;
@@ -271,6 +285,20 @@ static inline int llhw_set_calibration(struct mcps802154_local *local,
 	return r;
 }
 
+static inline int
+llhw_set_calibrations(struct mcps802154_local *local,
+		      const struct mcps802154_calibration *calibrations,
+		      int n_calibrations, int *n_set)
+{
+	int r;
+
+	trace_llhw_set_calibrations(local, n_calibrations);
+	r = local->ops->set_calibrations(&local->llhw, calibrations,
+					 n_calibrations, n_set);
+	trace_llhw_return_int(local, r);
+	return r;
+}
+
 static inline int llhw_get_calibration(struct mcps802154_local *local,
 				       const char *key, void *value,
 				       size_t length)
@@ -35,6 +35,46 @@
 #include "on_demand_scheduler.h"
 #include "warn_return.h"
 
+/* Number of regions demands which can be cached. */
+#define MCPS802154_ON_DEMAND_CACHE_SIZE 8
+
+static unsigned int lookahead = 1;
+module_param(lookahead, uint, 0644);
+MODULE_PARM_DESC(lookahead,
+		 "Maximum number of consecutive accesses scheduled at once");
+
+/**
+ * struct mcps802154_on_demand_cache - Cached demand of a region.
+ */
+struct mcps802154_on_demand_cache {
+	/**
+	 * @region: Region, NULL if entry is not used.
+	 */
+	const struct mcps802154_region *region;
+	/**
+	 * @demand: Last demand returned by the region.
+	 */
+	struct mcps802154_region_demand demand;
+	/**
+	 * @timestamp_dtu: Next access opportunity used to get the demand.
+	 */
+	u32 timestamp_dtu;
+	/**
+	 * @generation: Generation of the request, to reuse an empty demand
+	 * only during the same request.
+	 */
+	u32 generation;
+	/**
+	 * @has_demand: True when the region had a demand.
+	 */
+	bool has_demand;
+	/**
+	 * @scheduled: True when the region was put in the schedule, its demand
+	 * is dropped on next schedule update.
+	 */
+	bool scheduled;
+};
+
 /**
  * struct mcps802154_on_demand_local - local context for on demand scheduler.
  */
@@ -51,6 +91,18 @@ struct mcps802154_on_demand_local {
 	 * @idle_region: Idle region to delay start of region selected.
 	 */
 	struct mcps802154_region *idle_region;
+	/**
+	 * @cache: Regions demands cache, invalidated on regions changes.
+	 */
+	struct mcps802154_on_demand_cache cache[MCPS802154_ON_DEMAND_CACHE_SIZE];
+	/**
+	 * @generation: Incremented on each request to the scheduler.
+	 */
+	u32 generation;
+	/**
+	 * @n_planned: Number of regions put in the last schedule.
+	 */
+	int n_planned;
 };
 
 static inline struct mcps802154_on_demand_local *
@@ -65,7 +117,7 @@ mcps802154_on_demand_scheduler_open(struct mcps802154_llhw *llhw)
 {
 	struct mcps802154_on_demand_local *plocal;
 
-	plocal = kmalloc(sizeof(*plocal), GFP_KERNEL);
+	plocal = kzalloc(sizeof(*plocal), GFP_KERNEL);
 	if (!plocal)
 		goto open_failure;
 
@@ -93,6 +145,123 @@ mcps802154_on_demand_scheduler_close(struct mcps802154_scheduler *scheduler)
 	kfree(plocal);
 }
 
+static void
+mcps802154_on_demand_scheduler_notify_stop(struct mcps802154_scheduler *scheduler)
+{
+	struct mcps802154_on_demand_local *plocal =
+		scheduler_to_plocal(scheduler);
+
+	memset(plocal->cache, 0, sizeof(plocal->cache));
+	plocal->n_planned = 0;
+}
+
+static bool
+mcps802154_on_demand_scheduler_notify_change(struct mcps802154_scheduler *scheduler)
+{
+	struct mcps802154_on_demand_local *plocal =
+		scheduler_to_plocal(scheduler);
+
+	memset(plocal->cache, 0, sizeof(plocal->cache));
+	/* Regions planned ahead were chosen with the old demands. */
+	return plocal->n_planned > 1;
+}
+
+/**
+ * mcps802154_on_demand_scheduler_drop_scheduled() - Drop cached demands of
+ * regions which were given an access.
+ * @plocal: On demand scheduler context.
+ */
+static void mcps802154_on_demand_scheduler_drop_scheduled(
+	struct mcps802154_on_demand_local *plocal)
+{
+	int i;
+
+	for (i = 0; i < MCPS802154_ON_DEMAND_CACHE_SIZE; i++) {
+		if (plocal->cache[i].scheduled)
+			plocal->cache[i].region = NULL;
+	}
+}
+
+/**
+ * mcps802154_on_demand_scheduler_get_demand() - Get region demand, using the
+ * cache when possible.
+ * @plocal: On demand scheduler context.
+ * @region: Region.
+ * @next_timestamp_dtu: Next access opportunity.
+ * @demand: Demand output.
+ *
+ * A cached demand is reused when it was requested earlier and still starts
+ * in the future. No demand is only reused during the same request.
+ *
+ * Return: 1 if the region has a demand, 0 if not, or error.
+ */
+static int mcps802154_on_demand_scheduler_get_demand(
+	struct mcps802154_on_demand_local *plocal,
+	struct mcps802154_region *region, u32 next_timestamp_dtu,
+	struct mcps802154_region_demand *demand)
+{
+	struct mcps802154_on_demand_cache *entry = NULL, *free_entry = NULL;
+	int i, r;
+
+	for (i = 0; i < MCPS802154_ON_DEMAND_CACHE_SIZE; i++) {
+		if (plocal->cache[i].region == region) {
+			entry = &plocal->cache[i];
+			break;
+		}
+		if (!plocal->cache[i].region && !free_entry)
+			free_entry = &plocal->cache[i];
+	}
+
+	if (entry && !is_before_dtu(next_timestamp_dtu, entry->timestamp_dtu)) {
+		if (entry->has_demand &&
+		    !is_before_dtu(entry->demand.timestamp_dtu,
+				   next_timestamp_dtu)) {
+			*demand = entry->demand;
+			return 1;
+		}
+		if (!entry->has_demand &&
+		    entry->generation == plocal->generation)
+			return 0;
+	}
+
+	r = mcps802154_region_get_demand(plocal->llhw, region,
+					 next_timestamp_dtu, demand);
+	if (r < 0)
+		return r;
+
+	if (!entry && free_entry) {
+		entry = free_entry;
+		entry->region = region;
+		entry->scheduled = false;
+	}
+	if (entry) {
+		entry->timestamp_dtu = next_timestamp_dtu;
+		entry->generation = plocal->generation;
+		entry->has_demand = r == 1;
+		if (r == 1)
+			entry->demand = *demand;
+	}
+	return r;
+}
+
+/**
+ * mcps802154_on_demand_scheduler_set_scheduled() - Mark a region as put in
+ * the schedule.
+ * @plocal: On demand scheduler context.
+ * @region: Region.
+ */
+static void mcps802154_on_demand_scheduler_set_scheduled(
+	struct mcps802154_on_demand_local *plocal,
+	const struct mcps802154_region *region)
+{
+	int i;
+
+	for (i = 0; i < MCPS802154_ON_DEMAND_CACHE_SIZE; i++) {
+		if (plocal->cache[i].region == region)
+			plocal->cache[i].scheduled = true;
+	}
+}
+
 static int mcps802154_on_demand_scheduler_get_next_region(
 	struct mcps802154_on_demand_local *plocal, struct list_head *regions,
 	const struct mcps802154_region *first_region, u32 next_timestamp_dtu,
@@ -110,8 +279,8 @@ static int mcps802154_on_demand_scheduler_get_next_region(
 		if (first_region && region == first_region)
 			continue;
 
-		r = mcps802154_region_get_demand(
-			plocal->llhw, region, next_timestamp_dtu, &candidate);
+		r = mcps802154_on_demand_scheduler_get_demand(
+			plocal, region, next_timestamp_dtu, &candidate);
 		switch (r) {
 		case 0:
 			/* The region doesn't have a demand. */
@@ -164,8 +333,14 @@ static int mcps802154_on_demand_scheduler_update_schedule(
 	struct mcps802154_region_demand next_demand;
 	struct mcps802154_region *next_region = NULL;
 	u32 start_in_schedule_dtu;
+	u32 region_start_dtu = 0;
+	int n_planned;
 	int r;
 
+	mcps802154_on_demand_scheduler_drop_scheduled(plocal);
+	plocal->generation++;
+	plocal->n_planned = 0;
+
 	mcps802154_schedule_get_regions(plocal->llhw, &regions);
 	r = mcps802154_on_demand_scheduler_get_next_region(
 		plocal, regions, NULL, next_timestamp_dtu, &next_demand,
@@ -176,8 +351,6 @@ static int mcps802154_on_demand_scheduler_update_schedule(
 	if (!next_region)
 		return -ENOENT;
 
-	start_in_schedule_dtu = next_demand.timestamp_dtu - next_timestamp_dtu;
-
 	r = mcps802154_schedule_set_start(schedule_update, next_timestamp_dtu);
 	WARN_RETURN(r);
 
@@ -186,25 +359,45 @@ static int mcps802154_on_demand_scheduler_update_schedule(
 	/* Can not fail, only possible error is invalid parameters. */
 	WARN_RETURN(r);
 
-	if (next_demand.max_duration_dtu)
-		next_demand.max_duration_dtu += start_in_schedule_dtu;
- 	start_in_schedule_dtu = 0;
-
-	if (start_in_schedule_dtu)
-		/* Don't give the access to the region too early.
-		 * And provide advantages:
-		 *  - to have a region inserted with a CA invalidate schedule.
-		 *  - Reduce latency with TX frame prepared close to region
-		 *    start date. */
-		r = mcps802154_schedule_add_region(schedule_update,
-						   plocal->idle_region, 0,
-						   start_in_schedule_dtu,
-						   false);
-	r = mcps802154_schedule_add_region(schedule_update, next_region,
-					   start_in_schedule_dtu,
-					   next_demand.max_duration_dtu, true);
+	/*
+	 * Plan up to lookahead consecutive accesses, each region starting
+	 * at the end of the previous one.
+	 */
+	for (n_planned = 0;;) {
+		/*
+		 * The region is given the access from the end of the
+		 * previous one, it will wait its demand start itself.
+		 */
+		start_in_schedule_dtu = next_demand.timestamp_dtu -
+					next_timestamp_dtu - region_start_dtu;
+		if (next_demand.max_duration_dtu)
+			next_demand.max_duration_dtu += start_in_schedule_dtu;
+
+		r = mcps802154_schedule_add_region(
+			schedule_update, next_region, region_start_dtu,
+			next_demand.max_duration_dtu, true);
+		if (r)
+			return r;
+		mcps802154_on_demand_scheduler_set_scheduled(plocal,
+							     next_region);
+		plocal->n_planned = ++n_planned;
 
-	return r;
+		/* Endless region, or enough regions planned. */
+		if (!next_demand.max_duration_dtu || n_planned >= lookahead)
+			break;
+
+		region_start_dtu += next_demand.max_duration_dtu;
+		r = mcps802154_on_demand_scheduler_get_next_region(
+			plocal, regions, NULL,
+			next_timestamp_dtu + region_start_dtu, &next_demand,
+			&next_region);
+		if (r < 0)
+			return r;
+		if (!next_region)
+			break;
+	}
+
+	return 0;
 }
 
 static int mcps802154_on_demand_scheduler_get_next_demands(
@@ -220,6 +413,7 @@ static int mcps802154_on_demand_scheduler_get_next_demands(
 	u32 next_timestamp_dtu = timestamp_dtu;
 	int r;
 
+	plocal->generation++;
 	mcps802154_schedule_get_regions(plocal->llhw, &regions);
 
 	while (true) {
@@ -267,6 +461,8 @@ static struct mcps802154_scheduler_ops
 		.name = "on_demand",
 		.open = mcps802154_on_demand_scheduler_open,
 		.close = mcps802154_on_demand_scheduler_close,
+		.notify_stop = mcps802154_on_demand_scheduler_notify_stop,
+		.notify_change = mcps802154_on_demand_scheduler_notify_change,
 		.set_parameters = NULL, /* No scheduler parameters for now. */
 		.update_schedule =
 			mcps802154_on_demand_scheduler_update_schedule,
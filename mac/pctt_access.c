@@ -22,6 +22,7 @@
  */
 
 #include <linux/math64.h>
+#include <linux/module.h>
 #include "pctt_access.h"
 #include "pctt_region.h"
 #include "pctt_region_call.h"
@@ -45,6 +46,25 @@ static inline int pctt_rx_margin(int duration)
 	return duration / (1000000 / PCTT_MARGIN_PPM);
 }
 
+static int burst_frames = 8;
+module_param(burst_frames, int, 0644);
+MODULE_PARM_DESC(burst_frames,
+		 "Number of frames per access for periodic TX and PER RX tests");
+
+/**
+ * pctt_burst_frames() - Number of frames to put in the next burst.
+ * @local: PCTT context.
+ *
+ * Return: Number of frames, at least one and no more than the remaining
+ * frames of the test.
+ */
+static int pctt_burst_frames(const struct pctt_local *local)
+{
+	int n = clamp(READ_ONCE(burst_frames), 1, PCTT_BURST_FRAMES_MAX);
+
+	return clamp(local->frames_remaining_nb, 1, n);
+}
+
 static void
 pctt_set_sts_params(struct mcps802154_sts_params *sts_params,
 		    const struct pctt_session_params *session_params)
@@ -325,6 +345,7 @@ static void pctt_rx_frame_per_rx(struct pctt_local *local, struct sk_buff *skb,
 	const struct pctt_session_params *p = &session->params;
 	bool has_sts = p->rframe_config != PCTT_RFRAME_CONFIG_SP0;
 
+	per_rx->attempts++;
 	if (info) {
 		if (info->flags & MCPS802154_RX_FRAME_INFO_TIMESTAMP_DTU) {
 			session->next_timestamp_dtu = info->timestamp_dtu;
@@ -467,9 +488,6 @@ static void pctt_access_done(struct mcps802154_access *access, bool error)
 	struct pctt_session *session = &local->session;
 	bool end_of_test = false;
 
-	if (session->cmd_id == PCTT_ID_ATTR_PER_RX)
-		local->results.tests.per_rx.attempts++;
-
 	if (error && !local->results.status)
 		local->results.status = PCTT_STATUS_RANGING_INTERNAL_ERROR;
 
@@ -515,6 +533,42 @@ struct mcps802154_access_ops pctt_access_ops = {
 	.rx_frame = pctt_rx_frame,
 };
 
+/**
+ * pctt_access_setup_burst() - Fill access frames for a burst of frames.
+ * @local: PCTT context.
+ * @frame_dtu: First frame transmission or reception date.
+ * @period_dtu: Duration between the start of two consecutive frames.
+ * @n_frames: Number of frames in the burst.
+ *
+ * The first frame is set up from the first slot, the following ones are
+ * copies shifted by @period_dtu, sharing the same STS parameters. For
+ * reception, the window of each frame is widened by a margin per elapsed
+ * period to absorb clock drift.
+ */
+static void pctt_access_setup_burst(struct pctt_local *local, u32 frame_dtu,
+				    int period_dtu, int n_frames)
+{
+	const struct pctt_slot *s = local->slots;
+	struct mcps802154_access_frame *frame = local->frames;
+	int i;
+
+	pctt_access_setup_frame(local, s, frame_dtu, frame,
+				&local->sts_params[0]);
+
+	for (i = 1; i < n_frames; i++) {
+		frame[i] = frame[0];
+		if (s->is_tx) {
+			frame[i].tx_frame_config.timestamp_dtu =
+				frame_dtu + i * period_dtu;
+		} else {
+			frame[i].rx.frame_config.timestamp_dtu =
+				frame_dtu + i * period_dtu;
+			frame[i].rx.frame_config.timeout_dtu =
+				(i + 1) * s->timeout_dtu;
+		}
+	}
+}
+
 static struct mcps802154_access *
 pctt_get_access_periodic_tx(struct pctt_local *local, u32 next_timestamp_dtu)
 {
@@ -522,27 +576,29 @@ pctt_get_access_periodic_tx(struct pctt_local *local, u32 next_timestamp_dtu)
 	const struct pctt_session_params *p = &session->params;
 	struct mcps802154_access *access = &local->access;
 	struct pctt_slot *s = local->slots;
+	int n_frames = pctt_burst_frames(local);
 	u32 frame_dtu;
 	access->hrp_uwb_params = &session->hrp_uwb_params;
 
-	/* Unique frame in this access. */
+	/* Same slot for every frame of the burst. */
 	*s = (struct pctt_slot){
 		.is_tx = true,
 	};
 	frame_dtu = session->first_access ? next_timestamp_dtu :
 					    session->next_timestamp_dtu;
 
-	pctt_access_setup_frame(local, s, frame_dtu, &local->frames[0],
-				&local->sts_params[0]);
+	pctt_access_setup_burst(local, frame_dtu, p->gap_duration_dtu,
+				n_frames);
 
 	access->method = MCPS802154_ACCESS_METHOD_MULTI;
 	access->ops = &pctt_access_ops;
 	access->duration_dtu = 0;
-	access->n_frames = 1;
+	access->n_frames = n_frames;
 	access->frames = local->frames;
 	access->timestamp_dtu = frame_dtu;
 	/* Compute next transmit date. */
-	session->next_timestamp_dtu = frame_dtu + p->gap_duration_dtu;
+	session->next_timestamp_dtu =
+		frame_dtu + n_frames * p->gap_duration_dtu;
 
 	pctt_randomize_psdu(local);
 
@@ -556,30 +612,37 @@ pctt_get_access_per_rx(struct pctt_local *local, u32 next_timestamp_dtu)
 	const struct pctt_session_params *p = &session->params;
 	struct mcps802154_access *access = &local->access;
 	struct pctt_slot *s = local->slots;
+	int margin_dtu = pctt_rx_margin(p->gap_duration_dtu);
 	u32 frame_timestamp_dtu;
+	int n_frames = 1;
 	access->hrp_uwb_params = &session->hrp_uwb_params;
 
-	/* Unique frame in this access. */
+	/* Same slot for every frame of the burst. */
 	*s = (struct pctt_slot){
 		.is_immediate = !session->first_rx_synchronized,
-		.timeout_dtu = session->first_rx_synchronized ?
-				       2 * pctt_rx_margin(p->gap_duration_dtu) :
-				       -1,
+		.timeout_dtu =
+			session->first_rx_synchronized ? 2 * margin_dtu : -1,
 	};
 
 	frame_timestamp_dtu = session->first_rx_synchronized ?
 				      session->next_timestamp_dtu :
 				      next_timestamp_dtu;
 
-	pctt_access_setup_frame(local, s, frame_timestamp_dtu,
-				&local->frames[0], &local->sts_params[0]);
+	/* Bursts need a known transmitter timing. */
+	if (session->cmd_id == PCTT_ID_ATTR_PER_RX &&
+	    session->first_rx_synchronized)
+		n_frames = pctt_burst_frames(local);
+
+	pctt_access_setup_burst(local, frame_timestamp_dtu,
+				p->gap_duration_dtu - margin_dtu, n_frames);
 
 	access->ops = &pctt_access_ops;
 	access->method = MCPS802154_ACCESS_METHOD_MULTI;
 	access->timestamp_dtu = frame_timestamp_dtu;
-	access->duration_dtu =
-		session->first_rx_synchronized ? p->gap_duration_dtu : 0;
-	access->n_frames = 1;
+	access->duration_dtu = session->first_rx_synchronized ?
+				       n_frames * p->gap_duration_dtu :
+				       0;
+	access->n_frames = n_frames;
 	access->frames = local->frames;
 
 	return access;
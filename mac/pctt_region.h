@@ -36,6 +36,9 @@
 #define PCTT_SESSION_ID 0
 #define PCTT_BOOLEAN_MAX 1
 #define PCTT_FRAMES_MAX 2
+/* Maximum number of frames in a periodic TX or PER RX burst, must be greater
+ * than or equal to PCTT_FRAMES_MAX. */
+#define PCTT_BURST_FRAMES_MAX 16
 
 #define PCTT_TIMESTAMP_SHIFT 9
 /**
@@ -297,7 +300,7 @@ struct pctt_local {
 	/**
 	 * @frames: Access frames referenced from access.
 	 */
-	struct mcps802154_access_frame frames[PCTT_FRAMES_MAX];
+	struct mcps802154_access_frame frames[PCTT_BURST_FRAMES_MAX];
 	/**
 	 * @sts_params: STS parameters for access frames.
 	 */
@@ -25,15 +25,60 @@
 #include <linux/errno.h>
 
 #include "mcps802154_i.h"
+#include "schedulers.h"
 #include "trace.h"
 
+/* Minimum number of regions allocated in the schedule table. */
+#define MCPS802154_SCHEDULE_REGIONS_MIN 4
+
 void mcps802154_schedule_clear(struct mcps802154_local *local)
 {
-	if (local->ca.schedule.regions) {
-		local->ca.schedule.n_regions = 0;
-		kfree(local->ca.schedule.regions);
-		local->ca.schedule.regions = NULL;
-	}
+	local->ca.schedule.n_regions = 0;
+}
+
+void mcps802154_schedule_free(struct mcps802154_local *local)
+{
+	struct mcps802154_schedule *sched = &local->ca.schedule;
+
+	kfree(sched->regions);
+	sched->regions = NULL;
+	sched->n_regions = 0;
+	sched->n_regions_max = 0;
+}
+
+/**
+ * mcps802154_schedule_reserve() - Make room for one more region.
+ * @local: MCPS private data.
+ *
+ * The table size is doubled when full, so that the schedule update does not
+ * allocate once the table is big enough. The first size is given by the
+ * number of opened regions, plus one for the idle region.
+ *
+ * Return: 0 or error.
+ */
+static int mcps802154_schedule_reserve(struct mcps802154_local *local)
+{
+	struct mcps802154_schedule *sched = &local->ca.schedule;
+	struct mcps802154_schedule_region *new_sched_regions;
+	size_t n_regions_max;
+
+	if (sched->n_regions < sched->n_regions_max)
+		return 0;
+
+	n_regions_max = max_t(size_t, sched->n_regions_max * 2,
+			      local->ca.n_regions + 1);
+	n_regions_max = max_t(size_t, n_regions_max,
+			      MCPS802154_SCHEDULE_REGIONS_MIN);
+	new_sched_regions =
+		krealloc(sched->regions,
+			 sizeof(sched->regions[0]) * n_regions_max, GFP_KERNEL);
+	if (!new_sched_regions)
+		return -ENOMEM;
+
+	sched->regions = new_sched_regions;
+	sched->n_regions_max = n_regions_max;
+	sched->n_allocs++;
+	return 0;
 }
 
 int mcps802154_schedule_update(struct mcps802154_local *local,
@@ -160,7 +205,8 @@ int mcps802154_schedule_add_region(
 	struct mcps802154_schedule *sched = &sulocal->local->ca.schedule;
 	struct mcps802154_schedule_region *last_sched_region =
 		sched->n_regions ? &sched->regions[sched->n_regions - 1] : NULL;
-	struct mcps802154_schedule_region *sched_region, *new_sched_regions;
+	struct mcps802154_schedule_region *sched_region;
+	int r;
 
 	if (start_dtu < 0 || duration_dtu < 0)
 		return -EINVAL;
@@ -179,20 +225,17 @@ int mcps802154_schedule_add_region(
 		return -EINVAL;
 
 	/* Add to schedule. */
-	new_sched_regions = krealloc(
-		sched->regions,
-		sizeof(sched->regions[0]) * (sched->n_regions + 1), GFP_KERNEL);
-	if (!new_sched_regions)
-		return -ENOMEM;
+	r = mcps802154_schedule_reserve(sulocal->local);
+	if (r)
+		return r;
 
 	/* Fill new added schedule region. */
-	sched_region = &new_sched_regions[sched->n_regions];
+	sched_region = &sched->regions[sched->n_regions];
 	sched_region->start_dtu = start_dtu;
 	sched_region->duration_dtu = duration_dtu;
 	sched_region->region = region;
 	sched_region->once = once;
 
-	sched->regions = new_sched_regions;
 	su->n_regions = sched->n_regions = sched->n_regions + 1;
 
 	/* Update schedule duration. */
@@ -211,7 +254,12 @@ void mcps802154_reschedule(struct mcps802154_llhw *llhw)
 {
 	struct mcps802154_local *local = llhw_to_local(llhw);
 
-	mcps802154_ca_may_reschedule(local);
+	/* Regions planned ahead may need to be rebuilt. */
+	if (mcps802154_scheduler_notify_change(local->ca.scheduler) &&
+	    likely(local->started))
+		mcps802154_ca_invalidate_schedule(local);
+	else
+		mcps802154_ca_may_reschedule(local);
 }
 EXPORT_SYMBOL(mcps802154_reschedule);
 
@@ -219,6 +267,7 @@ void mcps802154_schedule_invalidate(struct mcps802154_llhw *llhw)
 {
 	struct mcps802154_local *local = llhw_to_local(llhw);
 
+	mcps802154_scheduler_notify_change(local->ca.scheduler);
 	if (likely(local->started))
 		mcps802154_ca_invalidate_schedule(local);
 }
@@ -65,13 +65,23 @@ struct mcps802154_schedule {
 	 */
 	int duration_dtu;
 	/**
-	 * @regions: Table of regions.
+	 * @regions: Table of regions, kept allocated when the schedule is
+	 * cleared or recycled.
 	 */
 	struct mcps802154_schedule_region *regions;
 	/**
 	 * @n_regions: Number of regions in the schedule.
 	 */
 	size_t n_regions;
+	/**
+	 * @n_regions_max: Number of regions allocated in table.
+	 */
+	size_t n_regions_max;
+	/**
+	 * @n_allocs: Number of regions table allocations, does not change once
+	 * the table is big enough.
+	 */
+	u32 n_allocs;
 	/**
 	 * @current_index: Index of the current region.
 	 */
@@ -104,9 +114,17 @@ static inline struct mcps802154_schedule_update_local *schedule_update_to_local(
 /**
  * mcps802154_schedule_clear() - Clear schedule and release regions.
  * @local: MCPS private data.
+ *
+ * The regions table is kept for the next schedule.
  */
 void mcps802154_schedule_clear(struct mcps802154_local *local);
 
+/**
+ * mcps802154_schedule_free() - Clear schedule and free the regions table.
+ * @local: MCPS private data.
+ */
+void mcps802154_schedule_free(struct mcps802154_local *local);
+
 /**
  * mcps802154_schedule_update() - Initialize or update the schedule.
  * @local: MCPS private data.
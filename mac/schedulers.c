@@ -131,6 +131,19 @@ void mcps802154_scheduler_notify_stop(struct mcps802154_scheduler *scheduler)
 		ops->notify_stop(scheduler);
 }
 
+bool mcps802154_scheduler_notify_change(struct mcps802154_scheduler *scheduler)
+{
+	const struct mcps802154_scheduler_ops *ops;
+
+	if (!scheduler)
+		return false;
+
+	ops = scheduler->ops;
+	if (ops->notify_change)
+		return ops->notify_change(scheduler);
+	return false;
+}
+
 int mcps802154_scheduler_set_parameters(struct mcps802154_scheduler *scheduler,
 					const struct nlattr *params_attr,
 					struct netlink_ext_ack *extack)
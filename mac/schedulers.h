@@ -56,6 +56,15 @@ void mcps802154_scheduler_close(struct mcps802154_scheduler *scheduler);
  */
 void mcps802154_scheduler_notify_stop(struct mcps802154_scheduler *scheduler);
 
+/**
+ * mcps802154_scheduler_notify_change() - Notify a scheduler that regions
+ * demands may have changed.
+ * @scheduler: Pointer to the scheduler, may be NULL.
+ *
+ * Return: True when the current schedule must be rebuilt.
+ */
+bool mcps802154_scheduler_notify_change(struct mcps802154_scheduler *scheduler);
+
 /**
  * mcps802154_scheduler_set_parameters() - Set parameters of an open scheduler.
  * @scheduler: Pointer to the scheduler.
@@ -52,7 +52,8 @@
 	mcps802154_tx_frame_config_name(SP2),                     \
 	mcps802154_tx_frame_config_name(SP3),                     \
 	mcps802154_tx_frame_config_name(STS_MODE_MASK),           \
-	mcps802154_tx_frame_config_name(RANGING_ROUND)
+	mcps802154_tx_frame_config_name(RANGING_ROUND),           \
+	mcps802154_tx_frame_config_name(PREPARED)
 TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_TIMESTAMP_DTU);
 TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_CCA);
 TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_RANGING);
@@ -63,6 +64,7 @@ TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_SP2);
 TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_SP3);
 TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_STS_MODE_MASK);
 TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_RANGING_ROUND);
+TRACE_DEFINE_ENUM(MCPS802154_TX_FRAME_CONFIG_PREPARED);
 
 #define mcps802154_rx_frame_config_name(name)                      \
 	{                                                  \
@@ -293,7 +295,7 @@ TRACE_EVENT(llhw_tx_frame,
 		__field(int, rx_enable_after_tx_dtu)
 		__field(int, rx_enable_after_tx_timeout_dtu)
 		__field(int, ant_set_id)
-		__field(u8, flags)
+		__field(u16, flags)
 		__field(int, frame_idx)
 		__field(int, next_delay_dtu)
 		),
@@ -319,6 +321,24 @@ TRACE_EVENT(llhw_tx_frame,
 		  )
 	);
 
+TRACE_EVENT(llhw_tx_prepare_frame,
+	TP_PROTO(const struct mcps802154_local *local,
+		 const struct sk_buff *skb, int frame_idx),
+	TP_ARGS(local, skb, frame_idx),
+	TP_STRUCT__entry(
+		LOCAL_ENTRY
+		__field(int, len)
+		__field(int, frame_idx)
+		),
+	TP_fast_assign(
+		LOCAL_ASSIGN;
+		__entry->len = skb ? skb->len : -1;
+		__entry->frame_idx = frame_idx;
+		),
+	TP_printk(LOCAL_PR_FMT " len=%d frame_idx=%d", LOCAL_PR_ARG,
+		  __entry->len, __entry->frame_idx)
+	);
+
 TRACE_EVENT(llhw_rx_enable,
 	TP_PROTO(const struct mcps802154_local *local,
 		 const struct mcps802154_rx_frame_config *config,
@@ -691,6 +711,21 @@ DEFINE_EVENT(str_key_evt, llhw_set_calibration,
 	TP_ARGS(local, key)
 	);
 
+TRACE_EVENT(llhw_set_calibrations,
+	TP_PROTO(const struct mcps802154_local *local, int n_calibrations),
+	TP_ARGS(local, n_calibrations),
+	TP_STRUCT__entry(
+		LOCAL_ENTRY
+		__field(int, n_calibrations)
+		),
+	TP_fast_assign(
+		LOCAL_ASSIGN;
+		__entry->n_calibrations = n_calibrations;
+		),
+	TP_printk(LOCAL_PR_FMT " n_calibrations=%d", LOCAL_PR_ARG,
+		  __entry->n_calibrations)
+	);
+
 DEFINE_EVENT(str_key_evt, llhw_get_calibration,
 	TP_PROTO(const struct mcps802154_local *local, const char *const key),
 	TP_ARGS(local, key)
@@ -969,16 +1004,19 @@ TRACE_EVENT(schedule_update_done,
 		__field(u32, start_timestamp_dtu)
 		__field(int, duration_dtu)
 		__field(size_t, n_regions)
+		__field(u32, n_allocs)
 		),
 	TP_fast_assign(
 		LOCAL_ASSIGN;
 		__entry->start_timestamp_dtu = sched->start_timestamp_dtu;
 		__entry->duration_dtu = sched->duration_dtu;
 		__entry->n_regions = sched->n_regions;
+		__entry->n_allocs = sched->n_allocs;
 		),
-	TP_printk(LOCAL_PR_FMT " start_timestamp_dtu=0x%08x duration_dtu=%d n_regions=%lu",
+	TP_printk(LOCAL_PR_FMT " start_timestamp_dtu=0x%08x duration_dtu=%d n_regions=%lu n_allocs=%u",
 		  LOCAL_PR_ARG, __entry->start_timestamp_dtu,
-		  __entry->duration_dtu, __entry->n_regions)
+		  __entry->duration_dtu, __entry->n_regions,
+		  __entry->n_allocs)
 	);
 
 TRACE_EVENT(